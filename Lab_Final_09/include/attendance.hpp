@@ -1,7 +1,16 @@
 ﻿#pragma once
 #include <string>
 #include <vector>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+#include <ostream>
+#include <iostream>
+#include <memory>
 #include "simple_json.hpp"
+#include "table_writer.hpp"
+#include "student_dictionary.hpp"
 
 enum class EventType { IN, OUT, ABSENCE, UNKNOWN };
 
@@ -9,28 +18,262 @@ struct AttendanceRecord {
     std::string student;
     std::string timestamp;
     EventType type;
+    long long epoch = 0; // кэш parseTimestamp(), заполняется при загрузке
 
     long long parseTimestamp() const;
+    static long long parseTimestamp(const std::string& ts);
+    // Обратное преобразование (локальное время, как в parseTimestamp)
+    static std::string formatTimestamp(long long epoch);
 };
 
+struct StudentStat {
+    int absences = 0;
+    double hoursPresent = 0.0;
+    long long lastIn = -1;
+    int totalRecords = 0;
+
+    // Учесть очередное событие студента (события подаются по времени)
+    void absorb(long long epoch, EventType type);
+};
+
+// Критерий рейтинга худших студентов
+enum class RankKey { Absences, Hours, Records };
+
+// Колоночное представление данных для векторных ядер (kernels.hpp)
+struct RecordColumns {
+    std::vector<uint8_t> types;       // EventType, в порядке records
+    std::vector<long long> epochs;    // в порядке records
+    std::vector<uint32_t> students;   // номер студента в словаре имён, в порядке records
+    std::vector<double> hours;        // часы сессии, закрытой записью (out), иначе 0
+    long long minEpoch = 0;           // диапазон epochs (0, 0 — записей нет)
+    long long maxEpoch = 0;
+};
+
+// Индекс по времени: записи в порядке epoch и корзины по суткам.
+// Записи суток days[d] занимают [dayOffsets[d], dayOffsets[d + 1]).
+struct TimeIndex {
+    std::vector<const AttendanceRecord*> byTime;
+    std::vector<long long> epochs;      // epochs[i] == byTime[i]->epoch
+    std::vector<long long> days;        // номер суток (epoch / 86400), по возрастанию
+    std::vector<size_t> dayOffsets;     // days.size() + 1 элементов
+};
+
+class StatsEngine;
+namespace dedup { class Deduplicator; }
+namespace filter { class Expression; }
+namespace partition { struct WriteStats; }
+namespace sketch { struct Summary; }
+
 class AttendanceManager {
 public:
+    AttendanceManager();
+    ~AttendanceManager();
+
     void loadFromJson(const json::Value& root);
 
+    // Загрузка уже разобранных записей (многофайловая загрузка)
+    void loadRecords(std::vector<AttendanceRecord>&& recs);
+
+    // Дописать новые события (режим --follow): невалидные отбрасываются,
+    // готовая статистика обновляется инкрементально через StatsEngine.
+    // Возвращает число принятых записей.
+    size_t appendRecords(std::vector<AttendanceRecord>&& recs);
+
+    static AttendanceRecord recordFromJson(const json::ObjectType& obj, bool decodeTimestamp = true);
+    static std::vector<AttendanceRecord> recordsFromJson(const json::Value& root);
+
     json::Value saveToJson() const;
 
+    // Потоковая сериализация без DOM: куски записей форматируются
+    // параллельно и пишутся в out по порядку, память — O(куска)
+    void writeJson(std::ostream& out) const;
+    void saveJsonFile(const std::string& filename) const;
+
+    // Сжатый колоночный снимок (columnar_store.hpp); загружается через --input *.atc
+    void saveColumnar(const std::string& filename) const;
+
+    // Дописать в NDJSON-файл только записи, добавленные после прошлого
+    // вызова (после загрузки первый вызов пишет все). Возвращает число строк.
+    size_t appendNdjson(const std::string& filename);
+
+    // Сериализация в строку JSON (через writeJson)
+    std::string serializeJson() const;
+
     void validateData();
 
+    // Устранение повторных событий (dedup.hpp): validateData и appendRecords
+    // отбрасывают события с уже встречавшимся (студент, epoch, тип).
+    // windowSeconds > 0 ограничивает память при --follow: помнятся только
+    // события за последние windowSeconds секунд.
+    void enableDedup(long long windowSeconds = 0);
+    bool dedupEnabled() const { return deduper != nullptr; }
+
+    // Удалить повторы среди всех записей (заново, без учёта прошлых вызовов).
+    // Возвращает число удалённых; 0, если устранение повторов выключено.
+    size_t removeDuplicates();
+
+    // Всего отброшено повторов с момента включения
+    size_t duplicateCount() const { return duplicates; }
+
 
     void printReportByStudent(const std::string& name) const;
 
+    // Есть ли студент (O(1) по словарю имён) и похожие имена для промаха
+    bool hasStudent(const std::string& name) const;
+    std::vector<std::string> suggestStudents(const std::string& name, size_t limit = 5) const;
+    static void printSuggestions(const std::vector<std::string>& suggestions);
+
+    // Отчёты по всем студентам за один проход: файл на студента в каталоге dir.
+    // format — "txt", "csv" или "json". Имена, совпавшие после замены запрещённых
+    // символов, получают короткий хеш. Возвращает число записанных файлов.
+    size_t exportReports(const std::string& dir, const std::string& format) const;
+
     void printGeneralStats() const;
 
+    // Двоичный снимок движка статистики (StatsEngine::save)
+    void saveStatsSnapshot(const std::string& filename) const;
+    // Статистика по снимку вместе с загруженными записями (StatsEngine::load,
+    // записи дописываются к хвостам): ранее посчитанное не перечитывается.
+    // Запись раньше свёрнутой истории снимка — runtime_error.
+    // student — только этот студент; если фильтр Блума снимка его отвергает,
+    // события снимка не читаются
+    std::map<std::string, StudentStat> statsWithSnapshot(const std::string& filename,
+        const std::string& student = "") const;
+
+    // Индекс по студентам для быстрого --student (StudentIndex::write)
+    void saveStudentIndex(const std::string& indexFile, const std::string& dataFile) const;
+
+    // Дописать записи в хранилище по разделам (partition_store.hpp);
+    // число перезаписанных разделов
+    size_t savePartitions(const std::string& root, partition::WriteStats* stats = nullptr) const;
+
+    // Сумма по всем студентам (lastIn не используется)
+    StudentStat totalStats() const;
+    size_t recordCount() const { return records.size(); }
+
+    // K худших студентов: больше прогулов, меньше часов или меньше записей.
+    // Считается по кускам с ограниченной кучей на поток, без сортировки всей таблицы.
+    std::vector<std::pair<std::string, StudentStat>> topStudents(size_t k, RankKey key) const;
+    void printTopStudents(size_t k, RankKey key) const;
+
+    // Записи за [from, to] в порядке времени. scanned — сколько строк
+    // индекса пришлось просмотреть (строки найденных суток)
+    std::vector<const AttendanceRecord*> rangeRecords(long long from, long long to,
+        size_t* scanned = nullptr) const;
+    void printRangeReport(long long from, long long to) const;
+
+    // Выборка по выражению --where (filter.hpp): номера записей по возрастанию,
+    // один проход по колонкам для всех условий
+    std::vector<uint32_t> selectWhere(const filter::Expression& expr) const;
+    void printWhereReport(const filter::Expression& expr) const;
+
+    // Группировка (group_by.hpp) по маске ключей groupby::KeyPart за один проход:
+    // записей, часов, первая и последняя отметка, число студентов.
+    // where — необязательный фильтр, выборка которого группируется
+    void printGroupReport(unsigned keys, const filter::Expression* where = nullptr) const;
+
+    // Тепловая карта входов по дню недели × часу (heatmap.hpp);
+    // пустое имя — все студенты
+    void printHeatmap(const std::string& student = "") const;
+
+    // Формат таблиц отчётов (--format): text, csv, tsv или json
+    static void setTableFormat(TableWriter::Format format);
+    // Поток для таблиц отчётов (по умолчанию std::cout)
+    static void setTableOutput(std::ostream& out);
+
+    static bool isValid(const AttendanceRecord& rec);
+    static void printStatsTable(const std::map<std::string, StudentStat>& stats);
+    // Приближённая статистика (--approx) с границами погрешности
+    static void printApproxTable(const sketch::Summary& summary);
+    static void printReportTable(const std::string& name,
+        const std::vector<const AttendanceRecord*>& rows);
+
     void benchmarkAggregation();
 
+    // Микробенчмарки векторных ядер для всех доступных наборов инструкций
+    void benchmarkKernels() const;
+
+    // Вывод таблицы: iostream с setw против TableWriter
+    void benchmarkTableOutput() const;
+
+    // Полный пересчёт статистики против инкрементального добавления событий
+    void benchmarkIncremental() const;
+
+    // Колоночный снимок (--bench-atc): степень сжатия, скорость кодирования
+    // и декодирования; данные сериализуются целиком, поэтому не входит в --bench
+    void benchmarkColumnar() const;
+
+    // Гистограмма входов по дню недели × часу на 10M+ событий (--bench-heatmap)
+    void benchmarkHeatmap() const;
+
+    // Время parse/validate/aggregate/save на 1, 2, 4, 8 и 16 потоках
+    void benchmarkScaling();
+
+    // Колонки строятся лениво, как и остальные агрегаты
+    const RecordColumns& columns() const;
+
+    // Построить все кэшируемые агрегаты заранее
+    void warmCaches() const;
+
+    // Построить все агрегаты и запретить изменения: после этого запросы
+    // читают кэши без захвата мьютекса (неизменяемый снимок для сервера).
+    // Изменяющие методы бросают std::logic_error.
+    void freeze();
+    bool isFrozen() const { return frozen; }
+
+    // Запросы для серверного режима: ответы в виде JSON-значений
+    json::Value statsToJson() const;
+    json::Value studentToJson(const std::string& name) const;
+    json::Value rangeToJson(long long from, long long to) const;
+
+    // Граница диапазона: "YYYY-MM-DD" или полная метка времени.
+    // Для даты без времени и endOfDay == true берётся конец дня.
+    static long long parseDateBound(const std::string& s, bool endOfDay);
+
 private:
     std::vector<AttendanceRecord> records;
 
+    static inline TableWriter::Format tableFormat = TableWriter::Format::Text;
+    static inline std::ostream* tableOut = &std::cout;
+
+    // Версия данных: увеличивается при каждом изменении records
+    size_t version = 0;
+
+    // Сколько первых записей уже дописано через appendNdjson
+    size_t savedCount = 0;
+
+    std::unique_ptr<dedup::Deduplicator> deduper;
+    size_t duplicates = 0;
+
+    // Материализованные агрегаты. Строятся лениво при первом запросе
+    // и перестраиваются, только если версия данных изменилась.
+    static constexpr size_t NO_VERSION = static_cast<size_t>(-1);
+    // Статистика строится движком (сессии по времени), statsCache — его таблица
+    std::unique_ptr<StatsEngine> engine;
+    mutable std::map<std::string, StudentStat> statsCache;
+    mutable size_t statsVersion = NO_VERSION;
+    mutable std::unordered_map<std::string, std::vector<const AttendanceRecord*>> groupedCache;
+    mutable size_t groupedVersion = NO_VERSION;
+    mutable StudentDictionary dictionaryCache;
+    mutable size_t dictionaryVersion = NO_VERSION;
+    mutable TimeIndex timeCache;
+    mutable size_t timeVersion = NO_VERSION;
+    mutable RecordColumns columnsCache;
+    mutable size_t columnsVersion = NO_VERSION;
+    // Защищает ленивое построение кэшей при параллельных запросах
+    mutable std::mutex cacheMutex;
+    // Снимок заморожен: данные и кэши больше не меняются
+    bool frozen = false;
+
+    void ensureMutable() const;
+
+    std::vector<std::pair<std::string, std::vector<size_t>>> groupIndices() const;
+    const std::map<std::string, StudentStat>& getStats() const;
+    const std::unordered_map<std::string, std::vector<const AttendanceRecord*>>& getGrouped() const;
+    const TimeIndex& getTimeIndex() const;
+    const StudentDictionary& getDictionary() const;
+
+public:
     static EventType strToType(const std::string& s);
     static std::string typeToStr(EventType t);
 };
\ No newline at end of file
@@ -0,0 +1,35 @@
+﻿#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include "attendance.hpp"
+
+// Сжатый колоночный снимок записей (.atc).
+// Записи упорядочены по (студент, время) и режутся на независимые блоки по
+// BLOCK_ROWS строк, поэтому блоки кодируются и декодируются параллельно.
+// В блоке: прогоны студентов (номер в словаре, длина), метки времени —
+// zigzag-varint разности внутри прогона, типы — по 2 бита.
+// Метка времени восстанавливается из epoch; строки, записанные в файле иначе,
+// хранятся как исключения, так что снимок без потерь.
+namespace columnar {
+
+    static constexpr size_t BLOCK_ROWS = 65536;
+
+    std::string encode(const std::vector<AttendanceRecord>& records);
+
+    // Записи в порядке (студент, время); бросает std::runtime_error на битых данных
+    std::vector<AttendanceRecord> decode(std::string_view data);
+
+    // Только колонки, без строк: номера студентов, epoch, типы
+    struct Columns {
+        std::vector<std::string> dictionary;
+        std::vector<uint32_t> students;
+        std::vector<long long> epochs;
+        std::vector<uint8_t> types;
+    };
+    Columns decodeColumns(std::string_view data);
+
+    void save(const std::string& filename, const std::vector<AttendanceRecord>& records);
+    std::vector<AttendanceRecord> load(const std::string& filename);
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+﻿#pragma once
+#include <string_view>
+#include <vector>
+#include <climits>
+#include <cstdint>
+#include "attendance.hpp"
+
+// Устранение повторных событий: турникеты пересылают уже отправленные события.
+// Событие определяется 64-битным отпечатком (хеш имени студента, epoch, тип);
+// повтор — событие, отпечаток которого уже встречался. Остаётся первое вхождение.
+namespace dedup {
+
+    uint64_t fingerprint(std::string_view student, long long epoch, EventType type);
+
+    // Множество отпечатков с открытой адресацией (линейное пробирование).
+    // Рядом с отпечатком хранится epoch события — по нему работает вытеснение.
+    class FingerprintSet {
+    public:
+        explicit FingerprintSet(size_t expected = 0);
+
+        // true — отпечаток новый и добавлен, false — уже есть
+        bool insert(uint64_t fp, long long epoch);
+
+        // Удалить отпечатки событий раньше before; возвращает число удалённых
+        size_t evictBefore(long long before);
+
+        void clear();
+        size_t size() const { return count; }
+        size_t memoryBytes() const { return slots.size() * sizeof(Slot); }
+
+    private:
+        struct Slot {
+            uint64_t fp;        // 0 — пустая ячейка
+            long long epoch;
+        };
+
+        std::vector<Slot> slots;
+        size_t count = 0;
+
+        void rehash(size_t capacity);
+    };
+
+    // Отпечатки распределены по независимым частям (по старшим битам), каждую
+    // часть пакета обрабатывает одна задача пула — без блокировок.
+    // windowSeconds > 0: отпечатки событий старше (самое позднее событие − окно)
+    // вытесняются, и память ограничена числом событий в окне. Повтор, пришедший
+    // позже окна, уже не распознаётся.
+    class Deduplicator {
+    public:
+        static constexpr size_t SHARDS = 16;
+
+        explicit Deduplicator(long long windowSeconds = 0);
+
+        // Удалить из recs повторы — внутри пакета и с ранее принятыми событиями.
+        // Порядок оставшихся записей сохраняется. Возвращает число удалённых.
+        size_t filter(std::vector<AttendanceRecord>& recs);
+
+        void clear();
+        long long window() const { return windowSeconds; }
+        size_t size() const;
+        size_t memoryBytes() const;
+
+    private:
+        long long windowSeconds;
+        long long watermark = LLONG_MIN;        // самое позднее принятое событие
+        long long lastEviction = LLONG_MIN;
+        std::vector<FingerprintSet> shards;
+
+        void evict();
+    };
+}
\ No newline at end of file
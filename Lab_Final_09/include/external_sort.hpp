@@ -0,0 +1,75 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <filesystem>
+#include <functional>
+#include <cstdint>
+#include "attendance.hpp"
+#include "student_dictionary.hpp"
+
+// Внешняя сортировка для наборов данных, не помещающихся в память.
+// Записи сжимаются до (ID студента, epoch, тип), копятся в буфере в пределах
+// бюджета памяти и сбрасываются во временные файлы отсортированными прогонами.
+// Отчёты строятся потоковым k-way слиянием прогонов; если прогонов больше
+// MERGE_FAN_IN, finish() заранее сливает их каскадом в промежуточные.
+class ExternalStore {
+public:
+    // Сколько прогонов сливается (и открывается) одновременно
+    static constexpr size_t MERGE_FAN_IN = 64;
+
+    explicit ExternalStore(size_t memoryBudgetBytes);
+    ~ExternalStore();
+
+    ExternalStore(const ExternalStore&) = delete;
+    ExternalStore& operator=(const ExternalStore&) = delete;
+
+    // Добавить запись; невалидные записи отбрасываются
+    void add(const AttendanceRecord& rec);
+
+    // Сбросить остаток буфера и слить прогоны до MERGE_FAN_IN;
+    // вызывается после последнего add()
+    void finish();
+
+    // Статистика в стиле printGeneralStats (сессии в порядке времени)
+    std::map<std::string, StudentStat> aggregate() const;
+
+    // Записи одного студента в порядке времени
+    std::vector<AttendanceRecord> studentRecords(const std::string& name) const;
+
+    size_t recordCount() const { return accepted; }
+    size_t rejectedCount() const { return rejected; }
+    // Прогонов на диске сейчас и сброшенных из буфера всего
+    size_t runCount() const { return runs.size(); }
+    size_t spilledRunCount() const { return spilled; }
+
+    // Имена всех принятых студентов (для проверки и подсказок без слияния прогонов)
+    const StudentDictionary& students() const { return dictionary; }
+
+#pragma pack(push, 1)
+    struct Entry {
+        uint32_t student;
+        int64_t epoch;
+        uint8_t type;
+    };
+#pragma pack(pop)
+
+private:
+    size_t maxBufferEntries;
+    std::vector<Entry> buffer;
+    std::vector<std::filesystem::path> runs;
+    std::string runPrefix;
+    size_t nextRunId = 0;
+    size_t spilled = 0;
+
+    StudentDictionary dictionary;
+
+    size_t accepted = 0;
+    size_t rejected = 0;
+
+    std::filesystem::path nextRunPath();
+    void flushRun();
+    void cascadeRuns();
+    void forEachMerged(const std::function<void(const Entry&)>& fn) const;
+};
\ No newline at end of file
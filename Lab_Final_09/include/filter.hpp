@@ -0,0 +1,70 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <climits>
+#include "attendance.hpp"
+#include "student_dictionary.hpp"
+
+// Язык фильтров --where:
+//   type=absence and ts>=2025-10-01 and student~"Иванов"
+//   (type=in or type=out) and ts<2025-10-15T12:00:00
+// Поля: type (= !=), ts (= != < <= > >=), student (= != ~ — подстрока).
+// Дата без времени обозначает весь день: ts=2025-10-01 — любое время этого дня.
+// Выражение разбирается один раз и компилируется в предикат над колонками записей.
+namespace filter {
+
+    enum class Field { Type, Time, Student };
+    enum class Op { Eq, Ne, Lt, Le, Gt, Ge, Contains };
+
+    struct Condition {
+        Field field;
+        Op op;
+        std::string value;
+    };
+
+    // Разобранное выражение в дизъюнктивной нормальной форме:
+    // запись подходит, если выполнены все условия хотя бы одного терма
+    class Expression {
+    public:
+        // Ошибки синтаксиса — std::invalid_argument с позицией в тексте
+        static Expression parse(const std::string& text);
+
+        const std::string& text() const { return source; }
+        const std::vector<std::vector<Condition>>& terms() const { return dnf; }
+
+    private:
+        std::string source;
+        std::vector<std::vector<Condition>> dnf;
+    };
+
+    // Конъюнкция, сведённая к трём проверкам: маска типов, отрезок времени
+    // и студент (один номер словаря или множество номеров)
+    struct Conjunct {
+        enum class StudentMode { Any, One, Set };
+
+        uint8_t typeMask = 0x0F;            // бит t — тип t допустим
+        long long from = LLONG_MIN;
+        long long to = LLONG_MAX;
+        StudentMode studentMode = StudentMode::Any;
+        uint32_t studentId = 0;
+        std::vector<uint8_t> studentAllowed; // по номерам словаря, для Set
+
+        bool empty() const;
+    };
+
+    // Предикат, привязанный к словарю конкретных данных
+    class Predicate {
+    public:
+        Predicate(const Expression& expr, const StudentDictionary& dict);
+
+        // Номера подходящих записей по возрастанию: один проход по колонкам,
+        // без ветвлений на запись; для частых форм — отдельные экземпляры шаблона
+        std::vector<uint32_t> select(const RecordColumns& cols) const;
+
+        const std::vector<Conjunct>& conjuncts() const { return parts; }
+
+    private:
+        std::vector<Conjunct> parts;    // пустые конъюнкции отброшены
+    };
+}
\ No newline at end of file
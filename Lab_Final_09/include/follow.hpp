@@ -0,0 +1,22 @@
+﻿#pragma once
+#include <string>
+#include "attendance.hpp"
+
+// Режим --follow: чтение растущего файла (JSON-массив или NDJSON) с начала
+// и далее по мере дописывания. Новые события разбираются, проверяются
+// и добавляются в manager, статистика обновляется инкрементально.
+// Работает до Ctrl+C, затем печатает итоговую таблицу.
+namespace follow {
+
+    struct Stats {
+        size_t bytes = 0;
+        size_t accepted = 0;
+        size_t rejected = 0;     // неразобранные, невалидные и повторы
+        size_t malformed = 0;    // из них не разобраны (не JSON-объект записи)
+        size_t duplicates = 0;   // из них повторы (при включённом устранении)
+        size_t batches = 0;
+    };
+
+    // pollMs — пауза между проверками размера файла
+    Stats run(AttendanceManager& manager, const std::string& filename, int pollMs = 500);
+}
\ No newline at end of file
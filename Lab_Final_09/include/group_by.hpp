@@ -0,0 +1,195 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include <tuple>
+#include <utility>
+#include <mutex>
+#include <climits>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <type_traits>
+#include "attendance.hpp"
+#include "thread_pool.hpp"
+
+// Группировка записей по любому сочетанию ключей (студент, день, час, тип)
+// с набором агрегаторов, заданным параметрами шаблона.
+// Хеш-агрегация идёт параллельно: у каждой задачи пула своя частичная
+// таблица, частичные таблицы сливаются в конце.
+namespace groupby {
+
+    enum KeyPart : unsigned {
+        Student = 1,
+        Day = 2,
+        Hour = 4,
+        Type = 8
+    };
+
+    // "student,day,hour,type" в маску KeyPart; false — неизвестное имя
+    bool parseKeys(const std::string& s, unsigned& mask);
+
+    // Ключ группы упакован в 64 бита: студент | день (YYYYMMDD) | час | тип.
+    // Поля, не входящие в группировку, равны нулю.
+    struct Key {
+        uint32_t student;
+        uint32_t day;
+        uint32_t hour;
+        uint8_t type;
+
+        static uint64_t pack(uint32_t student, uint32_t day, uint32_t hour, uint8_t type) {
+            return (static_cast<uint64_t>(student) << 32) | (static_cast<uint64_t>(day) << 7)
+                | (static_cast<uint64_t>(hour) << 2) | type;
+        }
+
+        static Key unpack(uint64_t key) {
+            return { static_cast<uint32_t>(key >> 32), static_cast<uint32_t>((key >> 7) & 0x1FFFFFF),
+                static_cast<uint32_t>((key >> 2) & 0x1F), static_cast<uint8_t>(key & 0x3) };
+        }
+    };
+
+    // День и час в местном времени (как в parseTimestamp); localtime
+    // вызывается только при переходе к другим суткам. Границы суток — местные
+    // полуночи (mktime); в сутках перехода на летнее время (не 24 часа) час
+    // каждой метки берётся из localtime
+    class Calendar {
+    public:
+        void split(long long epoch, uint32_t& day, uint32_t& hour);
+
+    private:
+        long long dayStart = 0;
+        long long dayEnd = 0;
+        uint32_t dayKey = 0;
+        bool uniform = true;
+    };
+
+    // Строка, передаваемая агрегаторам
+    struct Row {
+        uint32_t student;
+        long long epoch;
+        uint8_t type;
+        double hours;       // часы сессии, закрытой этой записью
+    };
+
+    // --- Aggregators ---
+    // Агрегатор: тип State, init(), add(State&, const Row&), merge(State&, const State&)
+
+    struct Count {
+        using State = uint64_t;
+        static State init() { return 0; }
+        static void add(State& s, const Row&) { s++; }
+        static void merge(State& s, const State& other) { s += other; }
+    };
+
+    struct SumHours {
+        using State = double;
+        static State init() { return 0.0; }
+        static void add(State& s, const Row& r) { s += r.hours; }
+        static void merge(State& s, const State& other) { s += other; }
+    };
+
+    struct MinEpoch {
+        using State = long long;
+        static State init() { return LLONG_MAX; }
+        static void add(State& s, const Row& r) { if (r.epoch < s) s = r.epoch; }
+        static void merge(State& s, const State& other) { if (other < s) s = other; }
+    };
+
+    struct MaxEpoch {
+        using State = long long;
+        static State init() { return LLONG_MIN; }
+        static void add(State& s, const Row& r) { if (r.epoch > s) s = r.epoch; }
+        static void merge(State& s, const State& other) { if (other > s) s = other; }
+    };
+
+    // Число разных студентов в группе
+    struct DistinctStudents {
+        using State = std::unordered_set<uint32_t>;
+        static State init() { return {}; }
+        static void add(State& s, const Row& r) { s.insert(r.student); }
+        static void merge(State& s, const State& other) { s.insert(other.begin(), other.end()); }
+    };
+
+    // --- Engine ---
+
+    template <typename... Aggs>
+    class GroupBy {
+    public:
+        using State = std::tuple<typename Aggs::State...>;
+        using Table = std::unordered_map<uint64_t, State>;
+
+        explicit GroupBy(unsigned keys) : keys(keys) {}
+
+        // Агрегаты по всем записям колонок или только по выборке selection
+        Table run(const RecordColumns& cols, const std::vector<uint32_t>* selection = nullptr) const {
+            size_t n = selection ? selection->size() : cols.types.size();
+            std::vector<Table> partials;
+            std::mutex partialsMutex;
+
+            ThreadPool::instance().parallelFor(0, n, 16384, [&](size_t lo, size_t hi) {
+                Table local;
+                Calendar calendar;
+                for (size_t j = lo; j < hi; ++j) {
+                    size_t i = selection ? (*selection)[j] : j;
+                    Row row{ cols.students[i], cols.epochs[i], cols.types[i], cols.hours[i] };
+                    auto found = local.try_emplace(keyOf(row, calendar), Aggs::init()...).first;
+                    addAll(found->second, row, std::index_sequence_for<Aggs...>{});
+                }
+
+                std::lock_guard<std::mutex> lock(partialsMutex);
+                partials.push_back(std::move(local));
+            });
+
+            if (partials.empty()) return {};
+
+            // Слияние в самую большую частичную таблицу
+            size_t largest = 0;
+            for (size_t p = 1; p < partials.size(); ++p) {
+                if (partials[p].size() > partials[largest].size()) largest = p;
+            }
+            Table result = std::move(partials[largest]);
+            for (size_t p = 0; p < partials.size(); ++p) {
+                if (p == largest) continue;
+                for (auto& [key, state] : partials[p]) {
+                    auto [it, inserted] = result.try_emplace(key, std::move(state));
+                    if (!inserted) mergeAll(it->second, state, std::index_sequence_for<Aggs...>{});
+                }
+            }
+            return result;
+        }
+
+        // Состояние агрегатора Agg в строке результата
+        template <typename Agg>
+        static const typename Agg::State& get(const State& state) {
+            return std::get<indexOf<Agg, Aggs...>()>(state);
+        }
+
+    private:
+        unsigned keys;
+
+        uint64_t keyOf(const Row& row, Calendar& calendar) const {
+            uint32_t day = 0, hour = 0;
+            if (keys & (Day | Hour)) calendar.split(row.epoch, day, hour);
+            return Key::pack(
+                (keys & Student) ? row.student : 0,
+                (keys & Day) ? day : 0,
+                (keys & Hour) ? hour : 0,
+                (keys & Type) ? row.type : 0);
+        }
+
+        template <size_t... I>
+        static void addAll(State& s, const Row& row, std::index_sequence<I...>) {
+            (Aggs::add(std::get<I>(s), row), ...);
+        }
+
+        template <size_t... I>
+        static void mergeAll(State& s, const State& other, std::index_sequence<I...>) {
+            (Aggs::merge(std::get<I>(s), std::get<I>(other)), ...);
+        }
+
+        template <typename Agg, typename First, typename... Rest>
+        static constexpr size_t indexOf() {
+            if constexpr (std::is_same_v<Agg, First>) return 0;
+            else return 1 + indexOf<Agg, Rest...>();
+        }
+    };
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+#include "attendance.hpp"
+
+// Тепловая карта посещений: входы (IN) по дню недели × часу в местном времени.
+// Время переводится в ячейку по таблице 15-минутных интервалов диапазона данных
+// (переходы на летнее время учтены при построении таблицы), подсчёт идёт
+// гистограммным ядром kernels::histogramBySlot: у каждой задачи пула свои
+// ячейки, они складываются в конце.
+namespace heatmap {
+
+    static constexpr size_t DAYS = 7;      // понедельник — воскресенье
+    static constexpr size_t HOURS = 24;
+    static constexpr uint32_t ALL_STUDENTS = StudentDictionary::NOT_FOUND;
+
+    struct Grid {
+        uint64_t counts[DAYS][HOURS] = {};
+        uint64_t total = 0;
+    };
+
+    // Ячейка (день недели * 24 + час) для каждого 15-минутного интервала,
+    // покрывающего [from, to]. Бросает std::runtime_error, если диапазон
+    // слишком широк для таблицы.
+    class SlotTable {
+    public:
+        SlotTable(long long from, long long to);
+
+        long long base() const { return start; }
+        const uint8_t* data() const { return bins.data(); }
+        size_t size() const { return bins.size(); }
+
+    private:
+        long long start = 0;
+        std::vector<uint8_t> bins;
+    };
+
+    // Входы всех студентов или одного (номер в словаре имён)
+    Grid build(const RecordColumns& cols, uint32_t student = ALL_STUDENTS);
+
+    // То же по готовой таблице (несколько карт по одним данным, замеры)
+    Grid build(const long long* epochs, const uint8_t* types, const uint32_t* students, size_t n,
+        const SlotTable& table, uint32_t student = ALL_STUDENTS);
+}
\ No newline at end of file
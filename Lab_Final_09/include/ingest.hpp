@@ -0,0 +1,45 @@
+﻿#pragma once
+#include <string>
+#include <vector>
+#include "attendance.hpp"
+
+// Загрузка нескольких файлов: пути, каталоги и шаблоны вида data/2025-10-*.json
+namespace ingest {
+
+    struct FileResult {
+        std::string path;
+        std::vector<AttendanceRecord> records; // отсортированы по (student, epoch)
+        std::string error;                     // пусто, если файл разобран успешно
+        double millis = 0.0;
+    };
+
+    struct Summary {
+        size_t filesTotal = 0;
+        size_t filesFailed = 0;
+        size_t recordsLoaded = 0;
+        double millis = 0.0;
+    };
+
+    // Раскрывает каталоги (*.json, *.ndjson, *.atc) и шаблоны с '*' и '?'
+    std::vector<std::string> expandInputs(const std::vector<std::string>& inputs);
+
+    // Читает и парсит файлы параллельно на общем пуле потоков
+    // (одновременно не больше размера пула). Ошибка одного файла
+    // не прерывает загрузку.
+    std::vector<FileResult> parseFiles(const std::vector<std::string>& paths);
+
+    // k-way слияние отсортированных наборов в один упорядоченный по (student, epoch)
+    std::vector<AttendanceRecord> mergeSorted(std::vector<FileResult>& results);
+
+    // Полный цикл: раскрытие, параллельный разбор, слияние, загрузка и валидация.
+    // Бросает исключение, только если не удалось загрузить ни одного файла.
+    Summary loadInto(AttendanceManager& manager, const std::vector<std::string>& inputs);
+
+    bool isMultiInput(const std::vector<std::string>& inputs);
+
+    // NDJSON (по объекту на строку) читается потоково, без DOM всего файла
+    bool isNdjson(const std::string& path);
+
+    // Сжатый колоночный снимок (.atc, columnar_store.hpp)
+    bool isColumnar(const std::string& path);
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+﻿#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Векторные ядра над упакованной колонкой типов событий (uint8 на запись).
+// Реализации AVX2 и SSE2 выбираются во время выполнения, есть скалярный запасной путь.
+namespace kernels {
+
+    enum class Isa { Scalar, SSE2, AVX2 };
+
+    // Лучший набор инструкций, поддерживаемый процессором и ОС
+    Isa detectIsa();
+    const char* isaName(Isa isa);
+
+    // Текущий набор инструкций (по умолчанию detectIsa()); можно понизить для замеров
+    Isa activeIsa();
+    void setIsa(Isa isa);
+
+    // Битовая маска выборки: бит i слова i/64 равен (types[i] == value).
+    // bits должен вмещать (n + 63) / 64 слов. Используется --where с условием
+    // только на один тип (filter::Predicate).
+    void selectBitmap(const uint8_t* types, size_t n, uint8_t value, uint64_t* bits);
+
+    // Шаг таблицы перевода времени в ячейки гистограммы
+    static constexpr long long SLOT_SECONDS = 900;
+
+    // Гистограмма по таблице перевода: для элементов с types[i] == value
+    // (и students[i] == student, если students не nullptr) к bins[slotBins[s]]
+    // прибавляется 1, где s = (epochs[i] - base) / SLOT_SECONDS. Элементы вне
+    // [base, base + slots * SLOT_SECONDS) пропускаются; slotBins[s] < binCount.
+    // Разброс по ячейкам в SSE2/AVX2 не векторизуется, поэтому реализация одна,
+    // скалярная без ветвлений.
+    void histogramBySlot(const long long* epochs, const uint8_t* types, const uint32_t* students,
+        size_t n, uint8_t value, uint32_t student, long long base,
+        const uint8_t* slotBins, size_t slots, uint64_t* bins, size_t binCount);
+}
\ No newline at end of file
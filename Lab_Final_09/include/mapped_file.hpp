@@ -0,0 +1,36 @@
+﻿#pragma once
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+// Файл, отображённый в память только для чтения (mmap / MapViewOfFile).
+// Страницы подгружаются по мере обращения, поэтому чтение малой части
+// большого файла не зависит от его размера.
+class MappedFile {
+public:
+    MappedFile() = default;
+    // path — готовый путь (без utils::getPath)
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    const char* data() const { return ptr; }
+    size_t size() const { return length; }
+    std::string_view view() const { return { ptr, length }; }
+
+private:
+    const char* ptr = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void* file = nullptr;       // HANDLE
+    void* mapping = nullptr;    // HANDLE
+#else
+    int fd = -1;
+#endif
+
+    void close();
+};
\ No newline at end of file
@@ -0,0 +1,65 @@
+﻿#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <climits>
+#include <cstdint>
+#include "attendance.hpp"
+
+// Хранилище истории по разделам: <каталог>/YYYY-MM/part-XX.bin, где месяц —
+// по времени записи (местное время), XX — хеш имени студента по модулю BUCKETS.
+// Раздел: строки, фильтр Блума по именам студентов раздела и сводка (min/max
+// epoch, размеры частей). Запрос читает только сводки (и фильтр, если задан
+// студент), а данные — лишь тех разделов, что могут подойти.
+namespace partition {
+
+    static constexpr uint32_t BUCKETS = 16;
+
+    // Идентификатор студента в хранилище (FNV-1a имени)
+    uint64_t studentHash(std::string_view name);
+
+    // Сводка раздела (последние байты файла).
+    // Диапазон хешей имён здесь не хранится: хеши одного раздела разбросаны
+    // по всему 64-битному диапазону и почти ничего не отсекали бы; вместо
+    // него отбор по студенту делает фильтр Блума
+    struct Footer {
+        int64_t minEpoch;
+        int64_t maxEpoch;
+        uint64_t recordCount;
+        uint64_t dataBytes;     // данные занимают [0, dataBytes)
+        uint64_t bloomBytes;    // фильтр Блума — [dataBytes, dataBytes + bloomBytes)
+        uint32_t version;
+        char magic[4];
+    };
+
+    // Пустой student — все студенты
+    struct Query {
+        std::string student;
+        long long from = LLONG_MIN;
+        long long to = LLONG_MAX;
+    };
+
+    struct WriteStats {
+        size_t appended = 0;    // новых строк
+        size_t skipped = 0;     // уже были в разделах или повторялись среди записей
+    };
+
+    struct ScanStats {
+        size_t partitions = 0;  // всего разделов
+        size_t pruned = 0;      // пропущено по имени файла или сводке
+        size_t rowsRead = 0;    // строк в прочитанных разделах
+        double millis = 0.0;
+    };
+
+    // Дописать записи в разделы каталога root. Запись, уже лежащая в разделе
+    // (тот же отпечаток dedup::fingerprint), не дописывается повторно, поэтому
+    // повторная загрузка тех же данных ничего не меняет. Разделы с новыми
+    // строками перезаписываются целиком со свежей сводкой.
+    // Возвращает число перезаписанных разделов.
+    size_t write(const std::string& root, const std::vector<AttendanceRecord>& records,
+        WriteStats* stats = nullptr);
+
+    // Записи, подходящие под запрос, в порядке разделов
+    std::vector<AttendanceRecord> scan(const std::string& root, const Query& query,
+        ScanStats* stats = nullptr);
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+﻿#pragma once
+#include <string>
+#include "attendance.hpp"
+
+// Конвейерная загрузка: чтение → парсинг → валидация/загрузка.
+// Стадии работают одновременно и связаны ограниченными SPSC-очередями,
+// поэтому общее время стремится ко времени самой медленной стадии.
+namespace pipeline {
+
+    struct Stats {
+        size_t records = 0;
+        size_t invalid = 0;
+        size_t duplicates = 0;   // при включённом устранении повторов
+        size_t bytes = 0;
+        double readMs = 0.0;     // занятость стадии чтения
+        double parseMs = 0.0;    // суммарная занятость парсеров
+        double loadMs = 0.0;     // занятость стадии валидации/загрузки
+        double wallMs = 0.0;
+    };
+
+    // parserThreads == 0 — по числу потоков пула (--threads, ThreadPool::configure)
+    // минус поток чтения и загрузки
+    Stats loadFile(AttendanceManager& manager, const std::string& filename,
+        size_t parserThreads = 0);
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+﻿#pragma once
+#include <string>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include "attendance.hpp"
+
+// Долгоживущий сервер запросов поверх локального Unix-сокета.
+// Данные загружаются один раз, далее каждый запрос — поиск по индексам.
+// Данные публикуются неизменяемыми снимками: запрос атомарно берёт текущий
+// снимок и работает с ним без блокировок, reload строит следующий снимок
+// параллельно с запросами и подменяет указатель (схема RCU).
+//
+// Соединения не закреплены за потоками: один поток опрашивает (poll) все
+// сокеты и ставит полученные строки в очередь, workerCount потоков отвечают
+// на них по одной. Строки одного клиента обрабатываются по порядку, так что
+// ответы приходят в том же порядке; число постоянных клиентов ограничено
+// только дескрипторами процесса.
+//
+// Протокол: одна команда на строку, ответ — одна строка JSON.
+//   stats                 общая статистика
+//   student <имя>         записи студента
+//   range <from> <to>     записи за период (YYYY-MM-DD или метки времени)
+//   reload                перечитать входной файл (ответ — номер нового снимка)
+class QueryServer {
+public:
+    // Параметры загрузки: каждый снимок, в том числе после reload,
+    // строится так же, как первый
+    struct LoadOptions {
+        bool dedup = false;
+        long long dedupWindow = 0;      // секунд, 0 — без окна
+    };
+
+    QueryServer(std::vector<std::string> inputs, LoadOptions options, size_t workerCount = 4);
+    ~QueryServer();
+
+    // Цикл приёма соединений и запросов; возвращается после stop() или Ctrl+C.
+    // Существующий файл по socketPath заменяется, только если это сокет.
+    void run(const std::string& socketPath);
+
+    // Остановить run() (из любого потока); запросы в работе дописываются
+    void stop() { stopRequested = true; }
+
+    std::string handleRequest(const std::string& line);
+
+private:
+    std::vector<std::string> inputs;
+    LoadOptions options;
+    size_t workerCount;
+
+    // Текущий снимок; старый освобождается, когда его отпускает последний запрос
+    std::atomic<std::shared_ptr<const AttendanceManager>> snapshot;
+    std::atomic<uint64_t> generation{ 0 };
+    std::mutex reloadMutex;     // перезагрузки выполняются по одной
+
+    struct Client;
+
+    std::vector<std::thread> workers;
+    std::deque<std::shared_ptr<Client>> readyClients;  // клиенты с необработанными строками
+    std::mutex queueMutex;
+    std::condition_variable queueCv;
+    bool stopping = false;
+    std::atomic<bool> stopRequested{ false };
+
+    // Возвращает номер опубликованного снимка
+    uint64_t reload();
+    void workerLoop();
+    void stopWorkers();
+    // Разобрать принятые байты на строки; false — клиента пора отключить
+    bool receive(const std::shared_ptr<Client>& client, const char* data, size_t size);
+};
\ No newline at end of file
@@ -0,0 +1,47 @@
+﻿#pragma once
+#include <string>
+#include <fstream>
+#include <vector>
+#include "attendance.hpp"
+
+// Потоковое чтение записей без построения DOM всего файла.
+// Выделяет из входа объекты верхнего уровня {...} и разбирает их по одному,
+// поэтому подходит и для JSON-массива, и для NDJSON.
+class ObjectSplitter {
+public:
+    // Добавить очередной фрагмент входных данных
+    void feed(const char* data, size_t size);
+
+    // Извлечь следующий полностью полученный объект; false — нужно больше данных
+    bool nextObject(std::string& out);
+
+private:
+    std::string buffer;
+    size_t scanPos = 0;
+    size_t objectStart = 0;
+    int depth = 0;
+    bool inString = false;
+    bool escaped = false;
+
+    void compact();
+};
+
+class RecordStreamReader {
+public:
+    explicit RecordStreamReader(const std::string& filename, size_t blockSize = 1 << 20);
+
+    // Следующая запись; false — файл закончился
+    bool next(AttendanceRecord& out);
+
+    size_t objectsRead() const { return objects; }
+    size_t bytesRead() const { return bytes; }
+
+private:
+    std::ifstream in;
+    std::vector<char> block;
+    ObjectSplitter splitter;
+    std::string objectText;
+    size_t objects = 0;
+    size_t bytes = 0;
+    bool eof = false;
+};
\ No newline at end of file
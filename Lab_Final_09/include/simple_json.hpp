@@ -1,5 +1,6 @@
 ﻿#pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 #include <variant>
@@ -57,6 +58,9 @@ namespace json {
 
         static std::string stringify(const Value& value, int indent = -1);
 
+        // Дописать строку в кавычках с экранированием, как в stringify
+        static void appendEscaped(std::string& out, std::string_view str);
+
     private:
         static Value parseValue(const std::string& str, size_t& pos);
         static Value parseObject(const std::string& str, size_t& pos);
@@ -0,0 +1,103 @@
+﻿#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include "attendance.hpp"
+
+// Вероятностные сводки фиксированного размера для приближённой статистики
+// по входу любого объёма (--approx). Память не зависит от числа записей;
+// сводки с одинаковыми параметрами объединяются (merge), поэтому файлы
+// обрабатываются независимо и параллельно.
+namespace sketch {
+
+    // 64-битный хеш ключа (FNV-1a с перемешиванием битов)
+    uint64_t hashKey(std::string_view key);
+
+    // HyperLogLog: число различных ключей по 2^precision однобайтовым регистрам
+    class HyperLogLog {
+    public:
+        explicit HyperLogLog(uint32_t precision = 14);
+
+        void add(uint64_t hash);
+        void merge(const HyperLogLog& other);
+
+        double estimate() const;
+        // Стандартная относительная ошибка: 1.04 / sqrt(2^precision)
+        double standardError() const;
+        size_t memoryBytes() const { return registers.size(); }
+
+    private:
+        uint32_t precision;
+        std::vector<uint8_t> registers;
+    };
+
+    // Count-Min: оценка частоты сверху. С вероятностью 1 - delta оценка
+    // превышает истинное значение не больше чем на epsilon * total()
+    class CountMin {
+    public:
+        CountMin(double epsilon = 0.001, double delta = 0.001);
+
+        void add(uint64_t hash, uint64_t count = 1);
+        uint64_t estimate(uint64_t hash) const;
+        void merge(const CountMin& other);
+
+        uint64_t total() const { return sum; }
+        double epsilon() const;
+        double delta() const;
+        size_t memoryBytes() const { return counters.size() * sizeof(uint64_t); }
+
+    private:
+        size_t width;
+        size_t depth;
+        std::vector<uint64_t> counters;  // depth строк по width счётчиков
+        uint64_t sum = 0;
+    };
+
+    // Частые ключи: Count-Min и min-куча из capacity кандидатов с наибольшей оценкой.
+    // Кандидаты ищутся линейно, поэтому capacity ограничена MAX_CAPACITY
+    class HeavyHitters {
+    public:
+        static constexpr size_t MAX_CAPACITY = 1000;
+
+        struct Item {
+            std::string key;
+            uint64_t hash;
+            uint64_t estimate;
+        };
+
+        explicit HeavyHitters(size_t capacity = 10, double epsilon = 0.001, double delta = 0.001);
+
+        void add(std::string_view key, uint64_t count = 1);
+        void merge(const HeavyHitters& other);
+
+        // Кандидаты по убыванию оценки
+        std::vector<Item> top() const;
+        const CountMin& counts() const { return sketch; }
+        size_t memoryBytes() const;
+
+    private:
+        size_t capacity;
+        CountMin sketch;
+        std::vector<Item> heap;
+
+        void offer(std::string_view key, uint64_t hash, uint64_t estimate);
+    };
+
+    // Сводка потока записей для --approx
+    struct Summary {
+        HyperLogLog students;
+        HeavyHitters absentees;
+        uint64_t records = 0;
+        uint64_t rejected = 0;
+        uint64_t absences = 0;
+
+        explicit Summary(size_t topK = 10) : absentees(topK) {}
+
+        // Невалидные записи только считаются
+        void add(const AttendanceRecord& rec);
+        void merge(const Summary& other);
+
+        size_t memoryBytes() const { return students.memoryBytes() + absentees.memoryBytes(); }
+    };
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+﻿#pragma once
+#include <atomic>
+#include <vector>
+#include <thread>
+#include <cstddef>
+#include <cstdint>
+
+// Ограниченная lock-free очередь "один производитель — один потребитель".
+// Когда очередь полна, производитель ждёт (обратное давление на предыдущую стадию);
+// когда пуста — ждёт потребитель. Ожидание без нагрузки на ядро: после
+// короткого опроса сторона засыпает на std::atomic::wait.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) : slots(capacity + 1) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    bool tryPush(T& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t nextT = increment(t);
+        if (nextT == head.load(std::memory_order_acquire)) return false;
+        slots[t] = std::move(value);
+        tail.store(nextT, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& out) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        out = std::move(slots[h]);
+        head.store(increment(h), std::memory_order_release);
+        return true;
+    }
+
+    // Блокирующее добавление; после cancel() значение отбрасывается
+    void push(T value) {
+        for (unsigned spins = 0;; ++spins) {
+            uint32_t seen = events.load(std::memory_order_acquire);
+            if (cancelled.load(std::memory_order_acquire)) return;
+            if (tryPush(value)) break;
+            wait(spins, seen);
+        }
+        signal();
+    }
+
+    // Блокирующее извлечение; false — очередь закрыта и пуста или отменена
+    bool pop(T& out) {
+        for (unsigned spins = 0;; ++spins) {
+            uint32_t seen = events.load(std::memory_order_acquire);
+            if (cancelled.load(std::memory_order_acquire)) return false;
+            if (tryPop(out)) break;
+            if (closed.load(std::memory_order_acquire)) {
+                if (!tryPop(out)) return false;
+                break;
+            }
+            wait(spins, seen);
+        }
+        signal();
+        return true;
+    }
+
+    // Производитель больше ничего не добавит
+    void close() {
+        closed.store(true, std::memory_order_release);
+        signal();
+    }
+
+    // Аварийная остановка: ждущие push и pop сразу возвращаются,
+    // оставшиеся в очереди значения больше не выдаются
+    void cancel() {
+        cancelled.store(true, std::memory_order_release);
+        closed.store(true, std::memory_order_release);
+        signal();
+    }
+
+private:
+    std::vector<T> slots;
+    alignas(64) std::atomic<size_t> head{ 0 };
+    alignas(64) std::atomic<size_t> tail{ 0 };
+    alignas(64) std::atomic<bool> closed{ false };
+    std::atomic<bool> cancelled{ false };
+    // Счётчик push, pop и close: по нему ждёт сторона, которой нечего делать
+    alignas(64) std::atomic<uint32_t> events{ 0 };
+
+    static constexpr unsigned SPIN_LIMIT = 64;
+
+    // Сначала короткое ожидание с уступкой процессора, затем сон до
+    // следующего действия другой стороны (events изменится после seen)
+    void wait(unsigned spins, uint32_t seen) {
+        if (spins < SPIN_LIMIT) std::this_thread::yield();
+        else events.wait(seen, std::memory_order_acquire);
+    }
+
+    void signal() {
+        events.fetch_add(1, std::memory_order_release);
+        events.notify_all();
+    }
+
+    size_t increment(size_t i) const { return (i + 1) == slots.size() ? 0 : i + 1; }
+};
\ No newline at end of file
@@ -0,0 +1,86 @@
+﻿#pragma once
+#include <climits>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include "attendance.hpp"
+#include "student_dictionary.hpp"
+
+// Инкрементальная статистика по студентам.
+// У каждого студента хранится только хвост последних событий, упорядоченный по
+// времени; всё, что раньше, свёрнуто в агрегат. Событие не раньше последнего
+// учитывается за O(1), опоздавшее в пределах хвоста — пересчётом хвоста от
+// ближайшей контрольной точки. Событие раньше свёрнутой части точно учесть
+// нельзя: add сообщает об этом, и статистику перестраивают по записям.
+class StatsEngine {
+public:
+    // Контрольная точка — состояние после каждых CHECKPOINT_EVERY событий
+    static constexpr size_t CHECKPOINT_EVERY = 256;
+    // Сколько последних событий студента остаётся доступно для опозданий
+    // (хвост держит от RETAINED_EVENTS до RETAINED_EVENTS + CHECKPOINT_EVERY событий)
+    static constexpr size_t RETAINED_EVENTS = 4 * CHECKPOINT_EVERY;
+
+    enum class AddResult {
+        Appended,   // событие дописано в конец
+        Replayed,   // опоздавшее событие, хвост пересчитан
+        Stale       // событие раньше свёрнутой истории: не учтено
+    };
+
+    AddResult add(const std::string& student, long long epoch, EventType type);
+
+    // Полная перестройка по сгруппированным и упорядоченным по времени записям
+    // (студенты считаются параллельно на общем пуле потоков)
+    void rebuild(const std::unordered_map<std::string, std::vector<const AttendanceRecord*>>& grouped);
+
+    // Слить состояние другого движка (например, собранного в другом потоке).
+    // События other должны попадать в хвосты этого движка, а свёрнутая история
+    // допустима только у студентов, которых здесь нет; иначе runtime_error,
+    // и движок не меняется
+    void merge(StatsEngine&& other);
+
+    void clear();
+
+    const StudentStat* find(const std::string& student) const;
+    size_t studentCount() const { return students.size(); }
+    // Сколько событий учтено всего и сколько из них хранится в хвостах
+    size_t eventCount() const;
+    size_t retainedEvents() const;
+
+    // Сколько событий пришлось пересчитать из-за опозданий
+    size_t replayedEvents() const { return replayed; }
+
+    // Таблица для отчётов
+    std::map<std::string, StudentStat> snapshot() const;
+
+    // Двоичный снимок: свёрнутый агрегат и хвост событий каждого студента;
+    // контрольные точки хвоста при загрузке пересчитываются
+    void save(const std::string& filename) const;
+    static StatsEngine load(const std::string& filename);
+
+    // Только фильтр Блума по именам из снимка: быстрый ответ "такого студента нет"
+    static BloomFilter readBloom(const std::string& filename);
+
+private:
+    struct Event {
+        long long epoch;
+        EventType type;
+    };
+
+    struct StudentState {
+        StudentStat sealed;                     // состояние после свёрнутых событий
+        long long sealedUntil = LLONG_MIN;      // время последнего свёрнутого события
+        std::vector<Event> events;              // хвост после свёрнутых событий
+        std::vector<StudentStat> checkpoints;   // checkpoints[j] — после (j + 1) * CHECKPOINT_EVERY событий хвоста
+        StudentStat stat;
+
+        void push(const Event& e);
+        // Пересчитать состояние начиная с события pos; возвращает число пересчитанных событий
+        size_t replayFrom(size_t pos);
+        // Свернуть начало хвоста, если он длиннее RETAINED_EVENTS + CHECKPOINT_EVERY
+        void trim();
+    };
+
+    std::unordered_map<std::string, StudentState> students;
+    size_t replayed = 0;
+};
\ No newline at end of file
@@ -0,0 +1,67 @@
+﻿#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+
+// Словарь имён студентов: каждое имя хранится один раз и получает номер.
+// Проверка существования — O(1), для промахов есть подбор похожих имён.
+class StudentDictionary {
+public:
+    static constexpr uint32_t NOT_FOUND = static_cast<uint32_t>(-1);
+
+    StudentDictionary() = default;
+
+    // Ключи ids указывают в собственный names: при копировании они указывали бы
+    // в чужой словарь. Перемещение deque сохраняет узлы, ключи остаются верными.
+    StudentDictionary(const StudentDictionary&) = delete;
+    StudentDictionary& operator=(const StudentDictionary&) = delete;
+    StudentDictionary(StudentDictionary&&) = default;
+    StudentDictionary& operator=(StudentDictionary&&) = default;
+
+    // Номер имени (новое имя добавляется)
+    uint32_t intern(std::string_view name);
+
+    // Номер имени или NOT_FOUND
+    uint32_t find(std::string_view name) const;
+    bool contains(std::string_view name) const { return find(name) != NOT_FOUND; }
+
+    const std::string& name(uint32_t id) const { return names[id]; }
+    size_t size() const { return names.size(); }
+
+    // Похожие имена для "Возможно, вы имели в виду": сначала имена,
+    // начинающиеся с запроса, затем по расстоянию Левенштейна (по символам UTF-8)
+    std::vector<std::string> suggest(std::string_view query, size_t limit = 5) const;
+
+    void clear();
+
+private:
+    // deque не перемещает элементы при добавлении, поэтому ключи-string_view валидны
+    std::deque<std::string> names;
+    std::unordered_map<std::string_view, uint32_t> ids;
+};
+
+// Фильтр Блума для проверки имён без загрузки данных: "точно нет" или "возможно, есть"
+class BloomFilter {
+public:
+    BloomFilter() = default;
+    BloomFilter(size_t expectedItems, double falsePositiveRate = 0.01);
+
+    void add(std::string_view key);
+    bool mightContain(std::string_view key) const;
+
+    bool empty() const { return bits.empty(); }
+    size_t bitCount() const { return bits.size() * 64; }
+    uint32_t hashCount() const { return hashes; }
+
+    void write(std::ostream& out) const;
+    static BloomFilter read(std::istream& in);
+
+private:
+    std::vector<uint64_t> bits;
+    uint32_t hashes = 0;
+};
\ No newline at end of file
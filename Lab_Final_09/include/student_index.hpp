@@ -0,0 +1,48 @@
+﻿#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "attendance.hpp"
+#include "mapped_file.hpp"
+
+// Индекс по студентам рядом с файлом данных (<файл>.idx): отсортированный
+// каталог имён с диапазонами байтов в двоичном хранилище записей, где записи
+// каждого студента лежат подряд в порядке времени. Для --student индекс
+// отображается в память и читаются только строки нужного студента.
+//
+// Формат: заголовок, каталог (записи фиксированного размера, по имени),
+// блок имён, блок строк (тип, epoch, длина метки, метка времени).
+class StudentIndex {
+public:
+    // Путь индекса для файла данных
+    static std::string pathFor(const std::string& dataFile);
+
+    // Записать индекс по сгруппированным и упорядоченным по времени записям.
+    // В заголовок попадают размер и время изменения dataFile.
+    static void write(const std::string& indexFile, const std::string& dataFile,
+        const std::unordered_map<std::string, std::vector<const AttendanceRecord*>>& grouped);
+
+    // Открыть индекс; false — индекса нет, он повреждён или устарел
+    // (файл данных изменился после построения)
+    bool open(const std::string& indexFile, const std::string& dataFile);
+
+    // Записи студента в порядке времени; false — студента нет
+    bool find(std::string_view student, std::vector<AttendanceRecord>& out) const;
+
+    // Все имена (для подсказок при промахе)
+    std::vector<std::string> names() const;
+
+    size_t studentCount() const { return students; }
+    size_t recordCount() const { return records; }
+
+private:
+    MappedFile file;
+    size_t students = 0;
+    size_t records = 0;
+    uint64_t namesOffset = 0;
+    uint64_t dataOffset = 0;
+
+    std::string_view nameAt(size_t i) const;
+};
\ No newline at end of file
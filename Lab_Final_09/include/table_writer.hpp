@@ -0,0 +1,62 @@
+﻿#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <ostream>
+
+// Вывод таблиц через переиспользуемый буфер: числа форматируются через
+// to_chars, выравнивание по ширине UTF-8 считается в том же проходе,
+// в поток данные уходят крупными блоками.
+class TableWriter {
+public:
+    enum class Format { Text, Csv, Tsv, Json };
+
+    struct Column {
+        std::string title;
+        int width;          // ширина в символах для Text
+    };
+
+    TableWriter(std::ostream& out, std::vector<Column> columns,
+        Format format = Format::Text, size_t flushBytes = 1 << 16);
+    ~TableWriter();
+
+    TableWriter(const TableWriter&) = delete;
+    TableWriter& operator=(const TableWriter&) = delete;
+
+    // Строка заголовков (в Json — начало массива)
+    void header();
+
+    TableWriter& cell(std::string_view s);
+    TableWriter& cell(long long v);
+    TableWriter& cell(int v) { return cell(static_cast<long long>(v)); }
+    TableWriter& cell(size_t v) { return cell(static_cast<long long>(v)); }
+    TableWriter& cell(double v, int precision = 2);
+    void endRow();
+
+    // Разделитель и произвольный текст — только в режиме Text
+    void rule(size_t width, char c = '-');
+    void text(std::string_view s);
+
+    bool isText() const { return format == Format::Text; }
+
+    // Закрыть таблицу (в Json — конец массива) и сбросить буфер
+    void finish();
+
+    // "text", "csv", "tsv", "json"
+    static bool parseFormat(const std::string& s, Format& out);
+
+private:
+    std::ostream& out;
+    std::vector<Column> columns;
+    Format format;
+    size_t flushBytes;
+    std::string buf;
+    size_t column = 0;
+    size_t rows = 0;         // строк данных (в Json — объектов)
+    bool opened = false;     // Json: массив открыт в header()
+    bool finished = false;
+
+    void beginCell();
+    void appendRaw(std::string_view s);
+    void flushIfFull();
+};
\ No newline at end of file
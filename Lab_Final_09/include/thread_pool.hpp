@@ -0,0 +1,67 @@
+﻿#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <condition_variable>
+
+// Общий пул потоков с перехватом задач (work stealing).
+// У каждого рабочего потока своя очередь: свои задачи он берёт с конца,
+// чужие — с начала. Поток, ожидающий parallelFor, сам выполняет куски
+// своего вызова, поэтому вложенные parallelFor не приводят к взаимоблокировке.
+// Чужие задачи ожидающий поток не берёт: он может держать блокировку
+// (например, мьютекс кэшей AttendanceManager), которую захватит чужая задача.
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    static ThreadPool& instance();
+
+    // Задать общее число потоков (включая вызывающий); 0 — по числу ядер.
+    // Вызывать, когда пул не занят.
+    static void configure(size_t threads);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t threadCount() const { return workers.size() + 1; }
+
+    // body(lo, hi) для поддиапазонов [begin, end) размером не меньше grain
+    void parallelFor(size_t begin, size_t end, size_t grain,
+        const std::function<void(size_t, size_t)>& body);
+
+private:
+    // batch — вызов parallelFor, которому принадлежит задача
+    struct Job {
+        Task task;
+        const void* batch = nullptr;
+    };
+
+    struct Worker {
+        std::deque<Job> tasks;
+        std::mutex mutex;
+    };
+
+    explicit ThreadPool(size_t threads);
+
+    std::vector<std::unique_ptr<Worker>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> pending{ 0 };
+    std::atomic<size_t> nextQueue{ 0 };
+    std::atomic<bool> stopping{ false };
+    std::mutex sleepMutex;
+    std::condition_variable sleepCv;
+
+    void submit(Task task, const void* batch);
+
+    // batch != nullptr — брать только задачи этого вызова parallelFor
+    bool runOneTask(const void* batch = nullptr);
+    void workerLoop(size_t index);
+
+    static std::unique_ptr<ThreadPool>& holder();
+};
\ No newline at end of file
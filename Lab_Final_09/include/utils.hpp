@@ -6,6 +6,8 @@
 #include <iostream>
 #include <stdexcept>
 #include <filesystem>
+#include <charconv>
+#include <cmath>
 
 #ifdef _WIN32
 #define NOMINMAX 
@@ -75,4 +77,27 @@ namespace utils {
         try { return std::filesystem::file_size(getPath(filename)); }
         catch (...) { return 0; }
     }
+
+    // Числовые значения опций командной строки; false (с сообщением в std::cerr),
+    // если значение не число целиком
+    inline bool parseCount(const std::string& option, const std::string& text, size_t& out) {
+        auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+        if (text.empty() || ec != std::errc() || end != text.data() + text.size()) {
+            std::cerr << "Ошибка: " << option << " ожидает целое неотрицательное число, получено '"
+                << text << "'.\n";
+            return false;
+        }
+        return true;
+    }
+
+    inline bool parseNonNegative(const std::string& option, const std::string& text, double& out) {
+        auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+        if (text.empty() || ec != std::errc() || end != text.data() + text.size()
+            || !std::isfinite(out) || out < 0.0) {
+            std::cerr << "Ошибка: " << option << " ожидает неотрицательное число, получено '"
+                << text << "'.\n";
+            return false;
+        }
+        return true;
+    }
 }
\ No newline at end of file
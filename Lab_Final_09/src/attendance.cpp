@@ -1,5 +1,17 @@
 ﻿#include "../include/attendance.hpp"
 #include "../include/utils.hpp"
+#include "../include/thread_pool.hpp"
+#include "../include/kernels.hpp"
+#include "../include/table_writer.hpp"
+#include "../include/stats_engine.hpp"
+#include "../include/filter.hpp"
+#include "../include/group_by.hpp"
+#include "../include/student_index.hpp"
+#include "../include/partition_store.hpp"
+#include "../include/columnar_store.hpp"
+#include "../include/sketch.hpp"
+#include "../include/dedup.hpp"
+#include "../include/heatmap.hpp"
 #include <iostream>
 #include <algorithm>
 #include <chrono>
@@ -7,6 +19,16 @@
 #include <map>
 #include <ctime>
 #include <cmath>
+#include <atomic>
+#include <sstream>
+#include <cstdio>
+#include <climits>
+#include <unordered_set>
+
+// Только числовые поля: sscanf_s и sscanf ведут себя одинаково
+#if !defined(_MSC_VER) && !defined(sscanf_s)
+#define sscanf_s sscanf
+#endif
 
 constexpr double EPS = 1e-6;
 
@@ -29,6 +51,10 @@ std::string AttendanceManager::typeToStr(EventType t) {
 }
 
 long long AttendanceRecord::parseTimestamp() const {
+    return parseTimestamp(timestamp);
+}
+
+long long AttendanceRecord::parseTimestamp(const std::string& timestamp) {
     int year, month, day, hour, minute, second;
 
     if (sscanf_s(timestamp.c_str(), "%d-%d-%dT%d:%d:%d",
@@ -52,28 +78,135 @@ long long AttendanceRecord::parseTimestamp() const {
         return 0;
     }
 
+    // mktime дорогой и внутри сериализуется, поэтому начало суток
+    // кэшируется на поток — в небольшой таблице по дате, так что метки
+    // не обязаны идти по дням подряд (1024 ячейки — почти три года без вытеснения).
+    // Если сутки не равны 24 часам (переход на летнее время), смещение
+    // меняется внутри дня, и такие метки переводятся через mktime целиком.
+    struct CachedDay {
+        int date = -1;
+        long long start = 0;
+        bool uniform = true;
+    };
+    thread_local CachedDay cachedDays[1024];
+
+    auto localEpoch = [](int y, int mo, int d, int h, int mi, int sec) {
+        std::tm tm = {};
+        tm.tm_year = y - 1900;
+        tm.tm_mon = mo - 1;
+        tm.tm_mday = d;
+        tm.tm_hour = h;
+        tm.tm_min = mi;
+        tm.tm_sec = sec;
+        tm.tm_isdst = -1;
+        return static_cast<long long>(mktime(&tm));
+    };
+
+    int dateKey = (year * 100 + month) * 100 + day;
+    CachedDay& cached = cachedDays[(year * 372 + month * 31 + day) & 1023];
+    if (cached.date != dateKey) {
+        cached.start = localEpoch(year, month, day, 0, 0, 0);
+        long long nextDay = localEpoch(year, month, day + 1, 0, 0, 0);
+        cached.uniform = cached.start != -1 && nextDay - cached.start == 86400;
+        cached.date = dateKey;
+    }
+
+    if (cached.start == -1) return -1;
+    if (!cached.uniform) return localEpoch(year, month, day, hour, minute, second);
+    return cached.start + hour * 3600LL + minute * 60LL + second;
+}
+
+std::string AttendanceRecord::formatTimestamp(long long epoch) {
+    std::time_t t = static_cast<std::time_t>(epoch);
     std::tm tm = {};
-    tm.tm_year = year - 1900;
-    tm.tm_mon = month - 1;
-    tm.tm_mday = day;
-    tm.tm_hour = hour;
-    tm.tm_min = minute;
-    tm.tm_sec = second;
-    tm.tm_isdst = -1;
+#ifdef _WIN32
+    localtime_s(&tm, &t);
+#else
+    localtime_r(&t, &tm);
+#endif
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &tm);
+    return buf;
+}
 
-    return static_cast<long long>(mktime(&tm));
+void StudentStat::absorb(long long epoch, EventType type) {
+    totalRecords++;
+    if (epoch == 0) return;
+
+    switch (type) {
+    case EventType::ABSENCE:
+        absences++;
+        lastIn = -1;
+        break;
+
+    case EventType::IN:
+        lastIn = epoch;
+        break;
+
+    case EventType::OUT:
+        if (lastIn != -1) {
+            double diffHours = static_cast<double>(epoch - lastIn) / 3600.0;
+            if (diffHours > EPS) {
+                hoursPresent += diffHours;
+            }
+            lastIn = -1;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+// Номер суток для корзин индекса по времени (деление с округлением вниз)
+static long long dayOf(long long epoch) {
+    const long long day = 24 * 3600;
+    return epoch >= 0 ? epoch / day : -((-epoch + day - 1) / day);
 }
 
 // --- Manager ---
 
-void AttendanceManager::loadFromJson(const json::Value& root) {
+AttendanceRecord AttendanceManager::recordFromJson(const json::ObjectType& obj, bool decodeTimestamp) {
+    AttendanceRecord rec;
+
+    auto studentIt = obj.find("student");
+    if (studentIt != obj.end() && studentIt->second.getType() == json::Type::String) {
+        rec.student = studentIt->second.asString();
+    }
+    else {
+        rec.student = "Unknown";
+    }
+
+    auto tsIt = obj.find("ts");
+    if (tsIt != obj.end() && tsIt->second.getType() == json::Type::String) {
+        rec.timestamp = tsIt->second.asString();
+    }
+    else {
+        rec.timestamp = "1970-01-01T00:00:00Z";
+    }
+
+    auto typeIt = obj.find("type");
+    if (typeIt != obj.end() && typeIt->second.getType() == json::Type::String) {
+        rec.type = strToType(typeIt->second.asString());
+    }
+    else {
+        rec.type = EventType::UNKNOWN;
+    }
+
+    if (decodeTimestamp) {
+        rec.epoch = rec.parseTimestamp();
+    }
+    return rec;
+}
+
+std::vector<AttendanceRecord> AttendanceManager::recordsFromJson(const json::Value& root) {
     if (root.getType() != json::Type::Array) {
         throw std::runtime_error("Root JSON must be an array");
     }
 
     const auto& arr = root.asArray();
-    records.clear();
-    records.reserve(arr.size());
+    std::vector<AttendanceRecord> result;
+    result.reserve(arr.size());
 
     for (const auto& item : arr) {
         if (item.getType() != json::Type::Object) {
@@ -81,213 +214,1164 @@ void AttendanceManager::loadFromJson(const json::Value& root) {
             continue;
         }
 
-        const auto& obj = item.asObject();
-        AttendanceRecord rec;
+        result.push_back(recordFromJson(item.asObject(), false));
+    }
 
-        auto studentIt = obj.find("student");
-        if (studentIt != obj.end() && studentIt->second.getType() == json::Type::String) {
-            rec.student = studentIt->second.asString();
-        }
-        else {
-            rec.student = "Unknown";
+    ThreadPool::instance().parallelFor(0, result.size(), 4096, [&result](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; ++i) {
+            result[i].epoch = result[i].parseTimestamp();
         }
+    });
 
-        auto tsIt = obj.find("ts");
-        if (tsIt != obj.end() && tsIt->second.getType() == json::Type::String) {
-            rec.timestamp = tsIt->second.asString();
-        }
-        else {
-            rec.timestamp = "1970-01-01T00:00:00Z";
+    return result;
+}
+
+void AttendanceManager::loadFromJson(const json::Value& root) {
+    ensureMutable();
+    records = recordsFromJson(root);
+    savedCount = 0;
+
+    version++;
+    std::cout << "Loaded " << records.size() << " records from JSON.\n";
+}
+
+void AttendanceManager::loadRecords(std::vector<AttendanceRecord>&& recs) {
+    ensureMutable();
+    records = std::move(recs);
+    savedCount = 0;
+
+    version++;
+    std::cout << "Loaded " << records.size() << " records.\n";
+}
+
+AttendanceManager::AttendanceManager() : engine(std::make_unique<StatsEngine>()) {
+}
+
+AttendanceManager::~AttendanceManager() = default;
+
+void AttendanceManager::ensureMutable() const {
+    if (frozen) throw std::logic_error("Attendance data is frozen and cannot be modified");
+}
+
+size_t AttendanceManager::appendRecords(std::vector<AttendanceRecord>&& recs) {
+    ensureMutable();
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    bool statsCurrent = statsVersion == version;
+
+    std::erase_if(recs, [](const AttendanceRecord& rec) { return !isValid(rec); });
+    if (deduper) duplicates += deduper->filter(recs);
+
+    size_t accepted = 0;
+    for (auto& rec : recs) {
+        // Движок учитывает событие за O(1), опоздавшее — пересчётом хвоста студента;
+        // в таблице обновляется только строка этого студента
+        // Событие раньше свёрнутой истории движка — полная перестройка при следующем запросе
+        if (statsCurrent) {
+            if (engine->add(rec.student, rec.epoch, rec.type) == StatsEngine::AddResult::Stale) {
+                statsCurrent = false;
+            }
+            else {
+                statsCache[rec.student] = *engine->find(rec.student);
+            }
         }
+        records.push_back(std::move(rec));
+        accepted++;
+    }
+
+    if (accepted > 0) {
+        version++;
+        if (statsCurrent) statsVersion = version;
+    }
+    return accepted;
+}
+
+static json::Value recordToJson(const AttendanceRecord& rec) {
+    json::ObjectType obj;
+    obj["student"] = json::Value(rec.student);
+    obj["ts"] = json::Value(rec.timestamp);
+    obj["type"] = json::Value(AttendanceManager::typeToStr(rec.type));
+    return json::Value(std::move(obj));
+}
 
-        auto typeIt = obj.find("type");
-        if (typeIt != obj.end() && typeIt->second.getType() == json::Type::String) {
-            rec.type = strToType(typeIt->second.asString());
+json::Value AttendanceManager::saveToJson() const {
+    json::ArrayType arr(records.size());
+
+    ThreadPool::instance().parallelFor(0, records.size(), 4096, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; ++i) {
+            arr[i] = recordToJson(records[i]);
         }
-        else {
-            rec.type = EventType::UNKNOWN;
+    });
+
+    return json::Value(std::move(arr));
+}
+
+// Запись в том же виде, что stringify(recordToJson(rec)): ключи по алфавиту
+static void appendRecordJson(std::string& out, const AttendanceRecord& rec) {
+    out += "{\"student\":";
+    json::Parser::appendEscaped(out, rec.student);
+    out += ",\"ts\":";
+    json::Parser::appendEscaped(out, rec.timestamp);
+    out += ",\"type\":";
+    json::Parser::appendEscaped(out, AttendanceManager::typeToStr(rec.type));
+    out += '}';
+}
+
+void AttendanceManager::writeJson(std::ostream& out) const {
+    // Окно из нескольких кусков сериализуется параллельно и пишется по порядку;
+    // буферы кусков переиспользуются, поэтому память не зависит от числа записей.
+    // Результат совпадает с json::Parser::stringify(saveToJson())
+    const size_t chunkSize = 16384;
+    size_t chunkCount = (records.size() + chunkSize - 1) / chunkSize;
+    size_t window = ThreadPool::instance().threadCount() * 2;
+    std::vector<std::string> buffers(std::min(window, std::max<size_t>(chunkCount, 1)));
+
+    out.put('[');
+    for (size_t first = 0; first < chunkCount; first += window) {
+        size_t last = std::min(chunkCount, first + window);
+
+        ThreadPool::instance().parallelFor(first, last, 1, [&](size_t lo, size_t hi) {
+            for (size_t c = lo; c < hi; ++c) {
+                std::string& buf = buffers[c - first];
+                buf.clear();
+                size_t end = std::min(records.size(), (c + 1) * chunkSize);
+                for (size_t i = c * chunkSize; i < end; ++i) {
+                    if (i > 0) buf += ',';
+                    appendRecordJson(buf, records[i]);
+                }
+            }
+        });
+
+        for (size_t c = first; c < last; ++c) {
+            const std::string& buf = buffers[c - first];
+            out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
         }
+    }
+    out.put(']');
+}
 
-        records.push_back(rec);
+void AttendanceManager::saveJsonFile(const std::string& filename) const {
+    std::string path = utils::getPath(filename);
+    if (!std::filesystem::exists(utils::DATA_DIR)) {
+        std::filesystem::create_directory(utils::DATA_DIR);
     }
 
-    std::cout << "Loaded " << records.size() << " records from JSON.\n";
+    std::ofstream out(path, std::ios::out | std::ios::binary);
+    if (!out.is_open()) throw std::runtime_error("Cannot open file for writing: " + path);
+
+    writeJson(out);
+    out.flush();
+    if (!out) throw std::runtime_error("Write failed: " + path);
 }
 
-json::Value AttendanceManager::saveToJson() const {
-    json::ArrayType arr;
-    arr.reserve(records.size());
+void AttendanceManager::saveColumnar(const std::string& filename) const {
+    if (!std::filesystem::exists(utils::DATA_DIR)) {
+        std::filesystem::create_directory(utils::DATA_DIR);
+    }
+    columnar::save(filename, records);
+}
 
-    for (const auto& rec : records) {
-        json::ObjectType obj;
-        obj["student"] = json::Value(rec.student);
-        obj["ts"] = json::Value(rec.timestamp);
-        obj["type"] = json::Value(typeToStr(rec.type));
-        arr.push_back(json::Value(std::move(obj)));
+size_t AttendanceManager::appendNdjson(const std::string& filename) {
+    std::string path = utils::getPath(filename);
+    if (!std::filesystem::exists(utils::DATA_DIR)) {
+        std::filesystem::create_directory(utils::DATA_DIR);
     }
 
-    return json::Value(std::move(arr));
+    std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::app);
+    if (!out.is_open()) throw std::runtime_error("Cannot open file for appending: " + path);
+
+    // После валидации записей может стать меньше
+    savedCount = std::min(savedCount, records.size());
+
+    std::string buf;
+    for (size_t i = savedCount; i < records.size(); ++i) {
+        appendRecordJson(buf, records[i]);
+        buf += '\n';
+        if (buf.size() >= (1 << 20)) {
+            out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+            buf.clear();
+        }
+    }
+    out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    out.flush();
+    if (!out) throw std::runtime_error("Write failed: " + path);
+
+    size_t appended = records.size() - savedCount;
+    savedCount = records.size();
+    return appended;
+}
+
+std::string AttendanceManager::serializeJson() const {
+    std::ostringstream out;
+    writeJson(out);
+    return std::move(out).str();
+}
+
+bool AttendanceManager::isValid(const AttendanceRecord& rec) {
+    if (rec.student.empty() || rec.student == "Unknown") {
+        return false;
+    }
+
+    if (rec.type == EventType::UNKNOWN) {
+        return false;
+    }
+
+    if (rec.timestamp.length() < 19) {
+        return false;
+    }
+
+    if (rec.epoch == 0) {
+        return false;
+    }
+
+    return true;
 }
 
 void AttendanceManager::validateData() {
+    ensureMutable();
     std::cout << "Validating " << records.size() << " records...\n";
 
     size_t initialCount = records.size();
-    size_t invalidCount = 0;
 
-    auto it = records.begin();
-    while (it != records.end()) {
-        bool invalid = false;
+    // Проверка параллельно, затем сжатие с сохранением порядка за один проход
+    std::vector<char> valid(records.size());
+    ThreadPool::instance().parallelFor(0, records.size(), 4096, [&](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; ++i) {
+            valid[i] = isValid(records[i]) ? 1 : 0;
+        }
+    });
 
-        if (it->student.empty() || it->student == "Unknown") {
-            invalid = true;
+    size_t kept = 0;
+    for (size_t i = 0; i < records.size(); ++i) {
+        if (valid[i]) {
+            if (kept != i) records[kept] = std::move(records[i]);
+            kept++;
         }
+    }
+    records.resize(kept);
+    size_t invalidCount = initialCount - kept;
+
+    version++;
+    if (dedupEnabled()) {
+        size_t duplicateRecords = removeDuplicates();
+        std::cout << "Validation complete. Removed " << invalidCount << " invalid records and "
+            << duplicateRecords << " duplicates (" << records.size() << " valid remain).\n";
+        return;
+    }
+    std::cout << "Validation complete. Removed " << invalidCount
+        << " invalid records (" << records.size() << " valid remain).\n";
+}
+
+void AttendanceManager::enableDedup(long long windowSeconds) {
+    deduper = std::make_unique<dedup::Deduplicator>(windowSeconds);
+}
+
+size_t AttendanceManager::removeDuplicates() {
+    ensureMutable();
+    if (!deduper) return 0;
+
+    deduper->clear();
+    size_t removed = deduper->filter(records);
+    if (removed > 0) version++;
+    duplicates += removed;
+    return removed;
+}
+
+bool AttendanceManager::hasStudent(const std::string& name) const {
+    return getDictionary().contains(name);
+}
+
+std::vector<std::string> AttendanceManager::suggestStudents(const std::string& name,
+    size_t limit) const {
+    return getDictionary().suggest(name, limit);
+}
 
-        if (it->type == EventType::UNKNOWN) {
-            invalid = true;
+void AttendanceManager::printSuggestions(const std::vector<std::string>& suggestions) {
+    if (suggestions.empty()) return;
+    std::cout << "Возможно, вы имели в виду:\n";
+    for (const auto& s : suggestions) {
+        std::cout << "  " << s << "\n";
+    }
+}
+
+void AttendanceManager::printReportByStudent(const std::string& name) const {
+    // Промах отвечается по словарю, без группировки записей
+    if (!hasStudent(name)) {
+        printReportTable(name, {});
+        printSuggestions(suggestStudents(name));
+        return;
+    }
+
+    const auto& grouped = getGrouped();
+    auto found = grouped.find(name);
+
+    if (found == grouped.end()) {
+        printReportTable(name, {});
+        return;
+    }
+
+    printReportTable(name, found->second);
+}
+
+std::vector<const AttendanceRecord*> AttendanceManager::rangeRecords(long long from,
+    long long to, size_t* scanned) const {
+    const auto& index = getTimeIndex();
+    if (scanned) *scanned = 0;
+    if (from > to) return {};
+
+    // Бинарный поиск по суткам, затем внутри крайних суток
+    size_t firstDay = std::lower_bound(index.days.begin(), index.days.end(), dayOf(from))
+        - index.days.begin();
+    size_t lastDay = std::upper_bound(index.days.begin(), index.days.end(), dayOf(to))
+        - index.days.begin();
+    if (firstDay >= lastDay) return {};
+
+    auto epochsBegin = index.epochs.begin();
+    size_t lo = std::lower_bound(epochsBegin + index.dayOffsets[firstDay],
+        epochsBegin + index.dayOffsets[firstDay + 1], from) - epochsBegin;
+    size_t hi = std::upper_bound(epochsBegin + index.dayOffsets[lastDay - 1],
+        epochsBegin + index.dayOffsets[lastDay], to) - epochsBegin;
+
+    if (scanned) *scanned = index.dayOffsets[lastDay] - index.dayOffsets[firstDay];
+    if (lo >= hi) return {};
+    return std::vector<const AttendanceRecord*>(index.byTime.begin() + lo, index.byTime.begin() + hi);
+}
+
+void AttendanceManager::printRangeReport(long long from, long long to) const {
+    getTimeIndex();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t scanned = 0;
+    auto rows = rangeRecords(from, to, &scanned);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    TableWriter table(*tableOut, {
+        { "Студент", 25 }, { "Время (UTC)", 25 }, { "Тип", 10 } }, tableFormat);
+
+    table.text("\n=== Записи за период: " + AttendanceRecord::formatTimestamp(from)
+        + " — " + AttendanceRecord::formatTimestamp(to) + " ===\n");
+    table.header();
+    table.rule(60);
+
+    if (rows.empty()) {
+        table.text("Записей не найдено.\n");
+    }
+    for (const auto* rec : rows) {
+        table.cell(rec->student).cell(rec->timestamp).cell(typeToStr(rec->type));
+        table.endRow();
+    }
+    table.finish();
+
+    if (table.isText()) {
+        std::cout << "\nВсего записей: " << rows.size()
+            << " (просмотрено " << scanned << " из " << records.size() << " строк, "
+            << std::chrono::duration<double, std::milli>(end - start).count() << " мс)\n";
+    }
+}
+
+std::vector<uint32_t> AttendanceManager::selectWhere(const filter::Expression& expr) const {
+    const auto& cols = columns();
+    filter::Predicate predicate(expr, getDictionary());
+    return predicate.select(cols);
+}
+
+void AttendanceManager::printWhereReport(const filter::Expression& expr) const {
+    columns();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    auto selection = selectWhere(expr);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    // Выборка в порядке записей; для вывода — по времени
+    std::stable_sort(selection.begin(), selection.end(), [&](uint32_t a, uint32_t b) {
+        return records[a].epoch < records[b].epoch;
+    });
+
+    size_t counts[4] = { 0, 0, 0, 0 };
+    TableWriter table(*tableOut, {
+        { "Студент", 25 }, { "Время (UTC)", 25 }, { "Тип", 10 } }, tableFormat);
+
+    table.text("\n=== Записи по условию: " + expr.text() + " ===\n");
+    table.header();
+    table.rule(60);
+
+    if (selection.empty()) {
+        table.text("Записей не найдено.\n");
+    }
+    for (uint32_t i : selection) {
+        const auto& rec = records[i];
+        counts[static_cast<int>(rec.type)]++;
+        table.cell(rec.student).cell(rec.timestamp).cell(typeToStr(rec.type));
+        table.endRow();
+    }
+    table.finish();
+
+    if (table.isText()) {
+        std::cout << "\nВсего записей: " << selection.size()
+            << " (in: " << counts[0] << ", out: " << counts[1] << ", absence: " << counts[2]
+            << "; просмотрено " << records.size() << " строк за один проход, "
+            << std::chrono::duration<double, std::milli>(end - start).count() << " мс)\n";
+    }
+}
+
+void AttendanceManager::printGroupReport(unsigned keys, const filter::Expression* where) const {
+    using namespace groupby;
+    using Report = GroupBy<Count, SumHours, MinEpoch, MaxEpoch, DistinctStudents>;
+
+    const auto& cols = columns();
+    const auto& dictionary = getDictionary();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<uint32_t> selection;
+    if (where) selection = selectWhere(*where);
+    Report::Table table = Report(keys).run(cols, where ? &selection : nullptr);
+
+    // Группы по студенту (по имени), дню, часу и типу
+    std::vector<std::pair<Key, const Report::State*>> groups;
+    groups.reserve(table.size());
+    for (const auto& [key, state] : table) groups.emplace_back(Key::unpack(key), &state);
+    std::sort(groups.begin(), groups.end(), [&](const auto& a, const auto& b) {
+        if (a.first.student != b.first.student) {
+            return dictionary.name(a.first.student) < dictionary.name(b.first.student);
         }
+        if (a.first.day != b.first.day) return a.first.day < b.first.day;
+        if (a.first.hour != b.first.hour) return a.first.hour < b.first.hour;
+        return a.first.type < b.first.type;
+    });
+    auto end = std::chrono::high_resolution_clock::now();
 
-        if (it->timestamp.length() < 19) {
-            invalid = true;
+    std::vector<TableWriter::Column> layout;
+    if (keys & Student) layout.push_back({ "Студент", 25 });
+    if (keys & Day) layout.push_back({ "День", 12 });
+    if (keys & Hour) layout.push_back({ "Час", 5 });
+    if (keys & Type) layout.push_back({ "Тип", 10 });
+    layout.push_back({ "Записей", 10 });
+    layout.push_back({ "Часов", 10 });
+    layout.push_back({ "Первая", 22 });
+    layout.push_back({ "Последняя", 22 });
+    if (!(keys & Student)) layout.push_back({ "Студентов", 10 });
+    size_t ruleWidth = 0;
+    for (const auto& col : layout) ruleWidth += static_cast<size_t>(col.width);
+
+    TableWriter out(*tableOut, std::move(layout), tableFormat);
+    out.text("\n=== Группировка" + (where ? " по условию: " + where->text() : std::string()) + " ===\n");
+    out.header();
+    out.rule(ruleWidth);
+
+    if (groups.empty()) {
+        out.text("Записей не найдено.\n");
+    }
+    for (const auto& [key, state] : groups) {
+        if (keys & Student) out.cell(dictionary.name(key.student));
+        if (keys & Day) {
+            char day[16];
+            std::snprintf(day, sizeof(day), "%04u-%02u-%02u", key.day / 10000, key.day / 100 % 100, key.day % 100);
+            out.cell(std::string_view(day));
         }
+        if (keys & Hour) out.cell(static_cast<long long>(key.hour));
+        if (keys & Type) out.cell(typeToStr(static_cast<EventType>(key.type)));
+        out.cell(static_cast<long long>(Report::get<Count>(*state)));
+        out.cell(Report::get<SumHours>(*state));
+        out.cell(AttendanceRecord::formatTimestamp(Report::get<MinEpoch>(*state)));
+        out.cell(AttendanceRecord::formatTimestamp(Report::get<MaxEpoch>(*state)));
+        if (!(keys & Student)) out.cell(Report::get<DistinctStudents>(*state).size());
+        out.endRow();
+    }
+    out.finish();
+
+    if (out.isText()) {
+        std::cout << "\nГрупп: " << groups.size() << " из "
+            << (where ? selection.size() : records.size()) << " записей ("
+            << std::chrono::duration<double, std::milli>(end - start).count() << " мс)\n";
+    }
+}
+
+// Имя файла отчёта: символы, недопустимые в путях, заменяются на '_'
+static std::string reportFileName(const std::string& student, const std::string& ext) {
+    std::string name;
+    name.reserve(student.size() + ext.size() + 1);
+    for (char c : student) {
+        bool bad = (c >= 0 && c < 32) || std::string("/\\:*?\"<>| ").find(c) != std::string::npos;
+        name += bad ? '_' : c;
+    }
+    if (name.empty() || name == "." || name == "..") name = "_";
+    return name + "." + ext;
+}
 
-        if (it->parseTimestamp() == 0) {
-            invalid = true;
+// Имена файлов отчётов для студентов (в том же порядке). После замены символов
+// разные студенты могут получить одно имя ("A B" и "A_B", "A/B" и "A:B"), а в
+// Windows совпадают и имена, различающиеся только регистром латиницы. Такие
+// имена получают короткий хеш исходного имени, чтобы отчёты не перезаписывали
+// друг друга; остальные имена не меняются.
+static std::vector<std::string> reportFileNames(const std::vector<const std::string*>& students,
+    const std::string& ext) {
+    auto folded = [](std::string name) {
+        for (char& c : name) {
+            if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
         }
+        return name;
+    };
+
+    std::vector<std::string> names;
+    names.reserve(students.size());
+    std::unordered_map<std::string, size_t> uses;
+    for (const auto* student : students) {
+        names.push_back(reportFileName(*student, ext));
+        uses[folded(names.back())]++;
+    }
 
-        if (invalid) {
-            it = records.erase(it);
-            invalidCount++;
+    std::unordered_set<std::string> taken;
+    for (size_t i = 0; i < names.size(); ++i) {
+        std::string name = names[i];
+        if (uses[folded(name)] > 1) {
+            char suffix[16];
+            std::snprintf(suffix, sizeof(suffix), "~%08x",
+                static_cast<unsigned>(sketch::hashKey(*students[i]) & 0xFFFFFFFFu));
+            name = name.substr(0, name.size() - ext.size() - 1) + suffix + "." + ext;
         }
-        else {
-            ++it;
+        // Совпадение и после хеша (в том числе с чужим неизменённым именем) — номер
+        std::string base = name.substr(0, name.size() - ext.size() - 1);
+        for (int n = 2; !taken.insert(folded(name)).second; ++n) {
+            name = base + "~" + std::to_string(n) + "." + ext;
         }
+        names[i] = std::move(name);
     }
+    return names;
+}
 
-    std::cout << "Validation complete. Removed " << invalidCount
-        << " invalid records (" << records.size() << " valid remain).\n";
+// Дописать s, дополнив пробелами до ширины width символов (UTF-8)
+static void appendPadded(std::string& out, const std::string& s, int width) {
+    out += s;
+    int pad = utils::u8_adjust(s, width) - static_cast<int>(s.size());
+    if (pad > 0) out.append(static_cast<size_t>(pad), ' ');
 }
 
-void AttendanceManager::printReportByStudent(const std::string& name) const {
-    std::cout << "\n=== Отчет для студента: " << name << " ===\n";
-    std::cout << std::left
-        << std::setw(25) << "Время (UTC)"
-        << std::setw(10) << "Тип"
-        << "\n";
-    std::cout << std::string(35, '-') << "\n";
+size_t AttendanceManager::exportReports(const std::string& dir, const std::string& format) const {
+    if (format != "txt" && format != "csv" && format != "json") {
+        throw std::invalid_argument("Unknown report format: " + format);
+    }
 
-    std::vector<const AttendanceRecord*> filtered;
-    filtered.reserve(records.size() / 10); // Предполагаем ~10% записей на студента
+    std::filesystem::path outDir = std::filesystem::path(dir).is_absolute()
+        ? std::filesystem::path(dir) : std::filesystem::path(utils::getPath(dir));
+    std::filesystem::create_directories(outDir);
+
+    // Одна группировка и сортировка на все отчёты; студенты по имени, чтобы
+    // имена файлов при совпадениях не зависели от порядка хеш-таблицы
+    const auto& grouped = getGrouped();
+    std::vector<const std::pair<const std::string, std::vector<const AttendanceRecord*>>*> groups;
+    groups.reserve(grouped.size());
+    for (const auto& entry : grouped) groups.push_back(&entry);
+    std::sort(groups.begin(), groups.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+
+    std::vector<const std::string*> students;
+    students.reserve(groups.size());
+    for (const auto* entry : groups) students.push_back(&entry->first);
+    const std::vector<std::string> fileNames = reportFileNames(students, format);
+
+    std::atomic<size_t> written{ 0 };
+    ThreadPool::instance().parallelFor(0, groups.size(), 16, [&](size_t lo, size_t hi) {
+        // Буфер переиспользуется для всех студентов куска
+        std::string buf;
+        for (size_t g = lo; g < hi; ++g) {
+            const std::string& name = groups[g]->first;
+            const auto& rows = groups[g]->second;
+            buf.clear();
+
+            if (format == "csv") {
+                buf += "student,ts,type\n";
+                for (const auto* rec : rows) {
+                    buf += '"';
+                    for (char c : name) {
+                        if (c == '"') buf += '"';
+                        buf += c;
+                    }
+                    buf += "\",";
+                    buf += rec->timestamp;
+                    buf += ',';
+                    buf += typeToStr(rec->type);
+                    buf += '\n';
+                }
+            }
+            else if (format == "json") {
+                buf += "{\"student\":";
+                json::Parser::appendEscaped(buf, name);
+                buf += ",\"count\":";
+                buf += std::to_string(rows.size());
+                buf += ",\"records\":[";
+                for (size_t i = 0; i < rows.size(); ++i) {
+                    if (i > 0) buf += ',';
+                    buf += "{\"ts\":";
+                    json::Parser::appendEscaped(buf, rows[i]->timestamp);
+                    buf += ",\"type\":\"";
+                    buf += typeToStr(rows[i]->type);
+                    buf += "\"}";
+                }
+                buf += "]}";
+            }
+            else {
+                buf += "=== Отчет для студента: " + name + " ===\n";
+                appendPadded(buf, "Время (UTC)", 25);
+                appendPadded(buf, "Тип", 10);
+                buf += '\n';
+                buf.append(35, '-');
+                buf += '\n';
+                for (const auto* rec : rows) {
+                    appendPadded(buf, rec->timestamp, 25);
+                    appendPadded(buf, typeToStr(rec->type), 10);
+                    buf += '\n';
+                }
+                buf += "\nВсего записей: " + std::to_string(rows.size()) + "\n";
+            }
 
-    for (const auto& rec : records) {
-        if (rec.student == name) {
-            filtered.push_back(&rec);
+            // Имена в UTF-8: путь строится из u8string, чтобы не зависеть от кодовой страницы
+            const std::string& fileName = fileNames[g];
+            std::u8string u8Name(reinterpret_cast<const char8_t*>(fileName.data()), fileName.size());
+            std::ofstream out(outDir / std::filesystem::path(u8Name), std::ios::out | std::ios::binary);
+            if (!out.is_open()) {
+                throw std::runtime_error("Cannot open report file for student: " + name);
+            }
+            out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+            written.fetch_add(1);
         }
-    }
+    });
+
+    return written.load();
+}
+
+void AttendanceManager::printReportTable(const std::string& name,
+    const std::vector<const AttendanceRecord*>& filtered) {
+    TableWriter table(*tableOut, { { "Время (UTC)", 25 }, { "Тип", 10 } }, tableFormat);
+
+    table.text("\n=== Отчет для студента: " + name + " ===\n");
+    table.header();
+    table.rule(35);
 
     if (filtered.empty()) {
-        std::cout << "Записей не найдено.\n";
+        table.text("Записей не найдено.\n");
         return;
     }
 
-    std::sort(filtered.begin(), filtered.end(),
-        [](const AttendanceRecord* a, const AttendanceRecord* b) {
-            return a->parseTimestamp() < b->parseTimestamp();
+    for (const auto& recPtr : filtered) {
+        table.cell(recPtr->timestamp).cell(typeToStr(recPtr->type));
+        table.endRow();
+    }
+
+    table.text("\nВсего записей: " + std::to_string(filtered.size()) + "\n");
+}
+
+// --- Cached aggregates ---
+
+std::vector<std::pair<std::string, std::vector<size_t>>> AttendanceManager::groupIndices() const {
+    // Частичные группировки по кускам массива, слитые в порядке кусков
+    using Partial = std::unordered_map<std::string, std::vector<size_t>>;
+    const size_t chunkSize = 65536;
+    size_t chunkCount = (records.size() + chunkSize - 1) / chunkSize;
+    std::vector<Partial> partials(chunkCount);
+
+    ThreadPool::instance().parallelFor(0, chunkCount, 1, [&](size_t lo, size_t hi) {
+        for (size_t c = lo; c < hi; ++c) {
+            size_t end = std::min(records.size(), (c + 1) * chunkSize);
+            for (size_t i = c * chunkSize; i < end; ++i) {
+                partials[c][records[i].student].push_back(i);
+            }
+        }
+    });
+
+    std::unordered_map<std::string, size_t> position;
+    std::vector<std::pair<std::string, std::vector<size_t>>> groups;
+    for (auto& partial : partials) {
+        for (auto& [student, indices] : partial) {
+            auto [it, inserted] = position.try_emplace(student, groups.size());
+            if (inserted) {
+                groups.emplace_back(student, std::move(indices));
+            }
+            else {
+                auto& dst = groups[it->second].second;
+                dst.insert(dst.end(), indices.begin(), indices.end());
+            }
+        }
+    }
+
+    return groups;
+}
+
+const std::map<std::string, StudentStat>& AttendanceManager::getStats() const {
+    if (frozen) return statsCache;
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        if (statsVersion == version) {
+            return statsCache;
+        }
+    }
+
+    // Группировка берётся до захвата мьютекса: она захватывает его сама.
+    // Сессии каждого студента считаются по времени, студенты — параллельно.
+    const auto& grouped = getGrouped();
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (statsVersion == version) {
+        return statsCache;
+    }
+
+    engine->rebuild(grouped);
+    statsCache = engine->snapshot();
+    statsVersion = version;
+    return statsCache;
+}
+
+const std::unordered_map<std::string, std::vector<const AttendanceRecord*>>&
+AttendanceManager::getGrouped() const {
+    if (frozen) return groupedCache;
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (groupedVersion == version) {
+        return groupedCache;
+    }
+
+    groupedCache.clear();
+    auto groups = groupIndices();
+
+    std::vector<std::vector<const AttendanceRecord*>> sorted(groups.size());
+    ThreadPool::instance().parallelFor(0, groups.size(), 1, [&](size_t lo, size_t hi) {
+        for (size_t g = lo; g < hi; ++g) {
+            auto& rows = sorted[g];
+            rows.reserve(groups[g].second.size());
+            for (size_t idx : groups[g].second) rows.push_back(&records[idx]);
+            std::stable_sort(rows.begin(), rows.end(),
+                [](const AttendanceRecord* a, const AttendanceRecord* b) {
+                    return a->epoch < b->epoch;
+                });
+        }
+    });
+
+    groupedCache.reserve(groups.size());
+    for (size_t g = 0; g < groups.size(); ++g) {
+        groupedCache.emplace(std::move(groups[g].first), std::move(sorted[g]));
+    }
+
+    groupedVersion = version;
+    return groupedCache;
+}
+
+const StudentDictionary& AttendanceManager::getDictionary() const {
+    if (frozen) return dictionaryCache;
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (dictionaryVersion == version) {
+        return dictionaryCache;
+    }
+
+    dictionaryCache.clear();
+    for (const auto& rec : records) {
+        dictionaryCache.intern(rec.student);
+    }
+
+    dictionaryVersion = version;
+    return dictionaryCache;
+}
+
+const TimeIndex& AttendanceManager::getTimeIndex() const {
+    if (frozen) return timeCache;
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (timeVersion == version) {
+        return timeCache;
+    }
+
+    TimeIndex index;
+    auto& rows = index.byTime;
+    rows.resize(records.size());
+    for (size_t i = 0; i < records.size(); ++i) rows[i] = &records[i];
+
+    auto byEpoch = [](const AttendanceRecord* a, const AttendanceRecord* b) {
+        return a->epoch < b->epoch;
+    };
+
+    // Куски сортируются параллельно, затем сливаются попарно по уровням
+    const size_t chunkSize = 65536;
+    size_t chunkCount = (rows.size() + chunkSize - 1) / chunkSize;
+    auto& pool = ThreadPool::instance();
+    pool.parallelFor(0, chunkCount, 1, [&](size_t lo, size_t hi) {
+        for (size_t c = lo; c < hi; ++c) {
+            size_t end = std::min(rows.size(), (c + 1) * chunkSize);
+            std::stable_sort(rows.begin() + c * chunkSize, rows.begin() + end, byEpoch);
+        }
+    });
+    for (size_t width = chunkSize; width < rows.size(); width *= 2) {
+        size_t pairs = (rows.size() + 2 * width - 1) / (2 * width);
+        pool.parallelFor(0, pairs, 1, [&](size_t lo, size_t hi) {
+            for (size_t p = lo; p < hi; ++p) {
+                size_t first = p * 2 * width;
+                size_t middle = std::min(rows.size(), first + width);
+                size_t last = std::min(rows.size(), first + 2 * width);
+                std::inplace_merge(rows.begin() + first, rows.begin() + middle,
+                    rows.begin() + last, byEpoch);
+            }
         });
+    }
 
-    for (const auto& recPtr : filtered) {
-        std::cout << std::left
-            << std::setw(25) << recPtr->timestamp
-            << std::setw(10) << typeToStr(recPtr->type)
-            << "\n";
+    index.epochs.resize(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        index.epochs[i] = rows[i]->epoch;
+        long long day = dayOf(index.epochs[i]);
+        if (index.days.empty() || index.days.back() != day) {
+            index.days.push_back(day);
+            index.dayOffsets.push_back(i);
+        }
     }
+    index.dayOffsets.push_back(rows.size());
 
-    std::cout << "\nВсего записей: " << filtered.size() << "\n";
+    timeCache = std::move(index);
+    timeVersion = version;
+    return timeCache;
+}
+
+const RecordColumns& AttendanceManager::columns() const {
+    if (frozen) return columnsCache;
+    // Группировка и словарь берутся до захвата мьютекса: они захватывают его сами
+    const auto& grouped = getGrouped();
+    const auto& dictionary = getDictionary();
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (columnsVersion == version) {
+        return columnsCache;
+    }
+
+    RecordColumns cols;
+    cols.types.resize(records.size());
+    cols.epochs.resize(records.size());
+    cols.students.resize(records.size());
+    std::mutex rangeMutex;
+    cols.minEpoch = records.empty() ? 0 : LLONG_MAX;
+    cols.maxEpoch = records.empty() ? 0 : LLONG_MIN;
+    ThreadPool::instance().parallelFor(0, records.size(), 16384, [&](size_t lo, size_t hi) {
+        long long lowest = LLONG_MAX, highest = LLONG_MIN;
+        for (size_t i = lo; i < hi; ++i) {
+            cols.types[i] = static_cast<uint8_t>(records[i].type);
+            cols.epochs[i] = records[i].epoch;
+            cols.students[i] = dictionary.find(records[i].student);
+            lowest = std::min(lowest, records[i].epoch);
+            highest = std::max(highest, records[i].epoch);
+        }
+        std::lock_guard<std::mutex> guard(rangeMutex);
+        cols.minEpoch = std::min(cols.minEpoch, lowest);
+        cols.maxEpoch = std::max(cols.maxEpoch, highest);
+    });
+
+    // Часы сессий — тем же absorb, что и в статистике, по записям студента во времени
+    cols.hours.assign(records.size(), 0.0);
+    for (const auto& [student, rows] : grouped) {
+        StudentStat stat;
+        for (const auto* rec : rows) {
+            double before = stat.hoursPresent;
+            stat.absorb(rec->epoch, rec->type);
+            cols.hours[static_cast<size_t>(rec - records.data())] = stat.hoursPresent - before;
+        }
+    }
+
+    columnsCache = std::move(cols);
+    columnsVersion = version;
+    return columnsCache;
 }
 
 void AttendanceManager::printGeneralStats() const {
-    struct StudentStat {
-        int absences = 0;
-        double hoursPresent = 0.0;
-        long long lastIn = -1;
-        int totalRecords = 0;
+    printStatsTable(getStats());
+}
+
+std::vector<std::pair<std::string, StudentStat>> AttendanceManager::topStudents(size_t k,
+    RankKey key) const {
+    const auto& stats = getStats();
+    if (k == 0 || stats.empty()) return {};
+
+    using Entry = const std::pair<const std::string, StudentStat>*;
+    std::vector<Entry> entries;
+    entries.reserve(stats.size());
+    for (const auto& entry : stats) entries.push_back(&entry);
+
+    // ahead(a, b) — a стоит в рейтинге выше b; при равенстве — по имени
+    auto ahead = [key](Entry a, Entry b) {
+        const StudentStat& x = a->second;
+        const StudentStat& y = b->second;
+        switch (key) {
+        case RankKey::Absences:
+            if (x.absences != y.absences) return x.absences > y.absences;
+            break;
+        case RankKey::Hours:
+            if (x.hoursPresent != y.hoursPresent) return x.hoursPresent < y.hoursPresent;
+            break;
+        case RankKey::Records:
+            if (x.totalRecords != y.totalRecords) return x.totalRecords < y.totalRecords;
+            break;
+        }
+        return a->first < b->first;
     };
 
-    std::cout << "\n=== Общая статистика посещаемости ===\n";
-    std::cout << "Всего студентов: ";
+    // Куча с вершиной — худшим из отобранных: новый кандидат вытесняет её,
+    // только если стоит выше
+    auto pushBounded = [&](std::vector<Entry>& heap, Entry e) {
+        if (heap.size() < k) {
+            heap.push_back(e);
+            std::push_heap(heap.begin(), heap.end(), ahead);
+        }
+        else if (ahead(e, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), ahead);
+            heap.back() = e;
+            std::push_heap(heap.begin(), heap.end(), ahead);
+        }
+    };
 
-    std::map<std::string, StudentStat> stats;
+    const size_t chunkSize = 16384;
+    size_t chunkCount = (entries.size() + chunkSize - 1) / chunkSize;
+    std::vector<std::vector<Entry>> heaps(chunkCount);
+
+    ThreadPool::instance().parallelFor(0, chunkCount, 1, [&](size_t lo, size_t hi) {
+        for (size_t c = lo; c < hi; ++c) {
+            size_t end = std::min(entries.size(), (c + 1) * chunkSize);
+            // k задаёт пользователь (--top): больше строк части куча не вместит
+            heaps[c].reserve(std::min(k, end - c * chunkSize));
+            for (size_t i = c * chunkSize; i < end; ++i) {
+                pushBounded(heaps[c], entries[i]);
+            }
+        }
+    });
 
-    for (const auto& rec : records) {
-        auto& stat = stats[rec.student];
-        stat.totalRecords++;
+    std::vector<Entry> merged;
+    for (const auto& heap : heaps) {
+        for (Entry e : heap) pushBounded(merged, e);
+    }
+    std::sort(merged.begin(), merged.end(), ahead);
 
-        long long timestamp = rec.parseTimestamp();
-        if (timestamp == 0) continue;
+    std::vector<std::pair<std::string, StudentStat>> result;
+    result.reserve(merged.size());
+    for (Entry e : merged) result.emplace_back(e->first, e->second);
+    return result;
+}
 
-        switch (rec.type) {
-        case EventType::ABSENCE:
-            stat.absences++;
-            stat.lastIn = -1;
-            break;
+void AttendanceManager::printTopStudents(size_t k, RankKey key) const {
+    auto top = topStudents(k, key);
+
+    const char* title = key == RankKey::Absences ? "больше всего прогулов"
+        : key == RankKey::Hours ? "меньше всего часов"
+        : "меньше всего записей";
+    TableWriter table(*tableOut, {
+        { "#", 5 }, { "Студент", 25 }, { "Прогулы", 15 }, { "Часов", 15 }, { "Записей", 10 } },
+        tableFormat);
+
+    table.text("\n=== Топ-" + std::to_string(k) + ": " + title + " ===\n");
+    table.header();
+    table.rule(70);
+
+    size_t place = 1;
+    for (const auto& [student, stat] : top) {
+        table.cell(place++).cell(student).cell(stat.absences)
+            .cell(stat.hoursPresent).cell(stat.totalRecords);
+        table.endRow();
+    }
 
-        case EventType::IN:
-            stat.lastIn = timestamp;
-            break;
+    if (top.empty()) {
+        table.text("Нет данных.\n");
+    }
+}
+
+void AttendanceManager::saveStatsSnapshot(const std::string& filename) const {
+    getStats();
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    engine->save(filename);
+}
+
+std::map<std::string, StudentStat> AttendanceManager::statsWithSnapshot(const std::string& filename,
+    const std::string& student) const {
+    StatsEngine combined;
+    if (student.empty() || StatsEngine::readBloom(filename).mightContain(student)) {
+        combined = StatsEngine::load(filename);
+    }
 
-        case EventType::OUT:
-            if (stat.lastIn != -1) {
-                double diffHours = static_cast<double>(timestamp - stat.lastIn) / 3600.0;
-                if (diffHours > EPS) {
-                    stat.hoursPresent += diffHours;
+    // Записи дописываются к хвостам снимка по времени; запись раньше свёрнутой
+    // истории снимка точно учесть нельзя
+    if (!records.empty()) {
+        for (const auto& [name, rows] : getGrouped()) {
+            if (!student.empty() && name != student) continue;
+            for (const auto* rec : rows) {
+                if (combined.add(name, rec->epoch, rec->type) == StatsEngine::AddResult::Stale) {
+                    throw std::runtime_error("Records predate the history kept in stats snapshot for student " + name);
                 }
-                stat.lastIn = -1;
             }
-            break;
-
-        default:
-            break;
         }
     }
 
-    std::string h1 = "Студент";
-    std::string h2 = "Прогулы";
-    std::string h3 = "Часов";
-    std::string h4 = "Записей";
+    auto stats = combined.snapshot();
+    if (!student.empty()) {
+        std::erase_if(stats, [&student](const auto& entry) { return entry.first != student; });
+    }
+    return stats;
+}
 
-    std::cout << stats.size() << "\n\n";
-    std::cout << std::left
-        << std::setw(utils::u8_adjust(h1, 25)) << h1
-        << std::setw(utils::u8_adjust(h2, 15)) << h2
-        << std::setw(utils::u8_adjust(h3, 15)) << h3
-        << std::setw(utils::u8_adjust(h4, 10)) << h4 << "\n";
+void AttendanceManager::saveStudentIndex(const std::string& indexFile,
+    const std::string& dataFile) const {
+    StudentIndex::write(indexFile, dataFile, getGrouped());
+}
 
-    std::cout << std::string(65, '-') << "\n";
+size_t AttendanceManager::savePartitions(const std::string& root, partition::WriteStats* stats) const {
+    return partition::write(root, records, stats);
+}
 
-    for (const auto& [student, stat] : stats) {
-        std::cout << std::left
-            << std::setw(utils::u8_adjust(student, 25)) << student
-            << std::setw(15) << stat.absences
-            << std::setw(15) << std::fixed << std::setprecision(2) << stat.hoursPresent
-            << std::setw(10) << stat.totalRecords << "\n";
+StudentStat AttendanceManager::totalStats() const {
+    StudentStat total;
+    for (const auto& [_, stat] : getStats()) {
+        total.absences += stat.absences;
+        total.hoursPresent += stat.hoursPresent;
+        total.totalRecords += stat.totalRecords;
     }
+    return total;
+}
+
+void AttendanceManager::printStatsTable(const std::map<std::string, StudentStat>& stats) {
+    TableWriter table(*tableOut, {
+        { "Студент", 25 }, { "Прогулы", 15 }, { "Часов", 15 }, { "Записей", 10 } }, tableFormat);
+
+    table.text("\n=== Общая статистика посещаемости ===\n");
+    table.text("Всего студентов: " + std::to_string(stats.size()) + "\n\n");
+    table.header();
+    table.rule(65);
 
     int totalAbsences = 0;
     double totalHours = 0.0;
     int totalRecords = 0;
 
-    for (const auto& [_, stat] : stats) {
+    for (const auto& [student, stat] : stats) {
+        table.cell(student).cell(stat.absences).cell(stat.hoursPresent).cell(stat.totalRecords);
+        table.endRow();
+
         totalAbsences += stat.absences;
         totalHours += stat.hoursPresent;
         totalRecords += stat.totalRecords;
     }
 
-    std::cout << std::string(65, '-') << "\n";
-    std::cout << std::left
-        << std::setw(utils::u8_adjust("Итого:", 25)) << "Итого:"
-        << std::setw(15) << totalAbsences
-        << std::setw(15) << std::fixed << std::setprecision(2) << totalHours
-        << std::setw(10) << totalRecords << "\n";
+    // Итоговая строка — только в текстовой таблице
+    if (table.isText()) {
+        table.rule(65);
+        table.cell("Итого:").cell(totalAbsences).cell(totalHours).cell(totalRecords);
+        table.endRow();
+    }
+}
+
+void AttendanceManager::printApproxTable(const sketch::Summary& summary) {
+    TableWriter table(*tableOut, {
+        { "Студент", 25 }, { "Прогулы (оценка)", 20 }, { "Не меньше", 12 } }, tableFormat);
+
+    const auto& counts = summary.absentees.counts();
+    double distinct = summary.students.estimate();
+    double error = summary.students.standardError();
+    // Завышение Count-Min: не больше epsilon * (всего прогулов) с вероятностью 1 - delta
+    long long slack = static_cast<long long>(std::ceil(counts.epsilon() * static_cast<double>(counts.total())));
+
+    std::ostringstream head;
+    head << std::fixed << std::setprecision(2);
+    head << "\n=== Приближённая статистика ===\n";
+    head << "Записей: " << summary.records << " (отброшено: " << summary.rejected
+        << "), прогулов: " << summary.absences << "\n";
+    head << "Различных студентов: ~" << std::llround(distinct)
+        << " (±" << std::llround(2.0 * error * distinct) << " с вероятностью ~95%, стандартная ошибка "
+        << error * 100.0 << "%)\n";
+    head << "Память сводок: " << summary.memoryBytes() / 1024 << " KB (не зависит от объёма входа)\n";
+    head << "Частые прогульщики: оценка завышена не больше чем на " << slack
+        << " с вероятностью " << (1.0 - counts.delta()) * 100.0 << "%\n\n";
+    table.text(head.str());
+
+    table.header();
+    table.rule(57);
+    for (const auto& item : summary.absentees.top()) {
+        long long estimate = static_cast<long long>(item.estimate);
+        table.cell(item.key).cell(estimate).cell(std::max(0LL, estimate - slack));
+        table.endRow();
+    }
+}
+
+void AttendanceManager::printHeatmap(const std::string& student) const {
+    static const char* const dayNames[heatmap::DAYS] = { "Пн", "Вт", "Ср", "Чт", "Пт", "Сб", "Вс" };
+
+    uint32_t id = heatmap::ALL_STUDENTS;
+    if (!student.empty()) {
+        if (!hasStudent(student)) {
+            std::cout << "Студент '" << student << "' не найден.\n";
+            printSuggestions(suggestStudents(student));
+            return;
+        }
+        id = getDictionary().find(student);
+    }
+
+    const auto& cols = columns();
+    auto start = std::chrono::high_resolution_clock::now();
+    heatmap::Grid grid = heatmap::build(cols, id);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    // CSV, TSV и JSON — числа по ячейкам; текст — компактная карта значками
+    if (tableFormat != TableWriter::Format::Text) {
+        std::vector<TableWriter::Column> layout = { { "День", 4 } };
+        for (size_t h = 0; h < heatmap::HOURS; ++h) {
+            char title[4];
+            std::snprintf(title, sizeof(title), "%02zu", h);
+            layout.push_back({ title, 6 });
+        }
+        layout.push_back({ "Всего", 8 });
+
+        TableWriter table(*tableOut, std::move(layout), tableFormat);
+        table.header();
+        for (size_t d = 0; d < heatmap::DAYS; ++d) {
+            long long dayTotal = 0;
+            table.cell(dayNames[d]);
+            for (size_t h = 0; h < heatmap::HOURS; ++h) {
+                table.cell(static_cast<long long>(grid.counts[d][h]));
+                dayTotal += static_cast<long long>(grid.counts[d][h]);
+            }
+            table.cell(dayTotal);
+            table.endRow();
+        }
+        return;
+    }
+
+    uint64_t peak = 0;
+    size_t peakDay = 0, peakHour = 0;
+    for (size_t d = 0; d < heatmap::DAYS; ++d) {
+        for (size_t h = 0; h < heatmap::HOURS; ++h) {
+            if (grid.counts[d][h] > peak) {
+                peak = grid.counts[d][h];
+                peakDay = d;
+                peakHour = h;
+            }
+        }
+    }
+
+    // Ноль — пробел, остальное — 9 ступеней до максимума
+    static const char shades[] = " .:-=+*#%@";
+    std::ostringstream out;
+    out << "\n=== Тепловая карта входов: " << (student.empty() ? "все студенты" : student) << " ===\n";
+    out << "Входов: " << grid.total << " (" << std::chrono::duration<double, std::milli>(end - start).count()
+        << " мс)\n\n";
+    out << "   ";
+    for (size_t h = 0; h < heatmap::HOURS; ++h) out << std::setw(3) << h;
+    out << "    Всего\n";
+    for (size_t d = 0; d < heatmap::DAYS; ++d) {
+        uint64_t dayTotal = 0;
+        out << dayNames[d] << " ";
+        for (size_t h = 0; h < heatmap::HOURS; ++h) {
+            uint64_t c = grid.counts[d][h];
+            size_t level = c == 0 ? 0 : 1 + static_cast<size_t>((c - 1) * 9 / std::max<uint64_t>(peak, 1));
+            out << "  " << shades[std::min<size_t>(level, 9)];
+            dayTotal += c;
+        }
+        out << "  " << std::setw(7) << dayTotal << "\n";
+    }
+    out << "\nШкала: ' ' — нет входов, '.' … '@' — до " << peak << " входов за час\n";
+    if (peak > 0) {
+        out << "Пик: " << dayNames[peakDay] << " " << std::setfill('0') << std::setw(2) << peakHour
+            << ":00–" << std::setw(2) << (peakHour + 1) % 24 << ":00 — " << peak << " входов\n";
+    }
+    std::cout << out.str();
+}
+
+void AttendanceManager::setTableFormat(TableWriter::Format format) {
+    tableFormat = format;
+}
+
+void AttendanceManager::setTableOutput(std::ostream& out) {
+    tableOut = &out;
 }
 
 void AttendanceManager::benchmarkAggregation() {
@@ -299,45 +1383,461 @@ void AttendanceManager::benchmarkAggregation() {
     std::cout << "\n=== Бенчмарк агрегации ===\n";
     std::cout << "Количество записей: " << records.size() << "\n";
 
-    // Замер 1: Группировка и сортировка
+    // Замер 1: Группировка и сортировка (повторно берётся из кэша)
+    bool cached = (groupedVersion == version);
     auto start = std::chrono::high_resolution_clock::now();
 
-    std::map<std::string, std::vector<const AttendanceRecord*>> grouped;
+    const auto& grouped = getGrouped();
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration<double, std::milli>(end - start);
+
+    std::cout << "[Benchmark] Группировка и сортировка: "
+        << duration.count() << " ms" << (cached ? " (из кэша)" : "") << "\n";
+    std::cout << "Студентов: " << grouped.size() << "\n";
+    if (!cached && duration.count() > 0) {
+        std::cout << "Записей в секунду: "
+            << (records.size() * 1000.0 / duration.count()) << "\n";
+    }
+
+    // Замер 2: Выборка прогулов тем же путём, что --where type=absence
+    columns();
+    auto absenceOnly = filter::Expression::parse("type=absence");
+    start = std::chrono::high_resolution_clock::now();
+
+    size_t totalAbsences = selectWhere(absenceOnly).size();
+
+    end = std::chrono::high_resolution_clock::now();
+    duration = end - start;
+
+    std::cout << "[Benchmark] Выборка прогулов: "
+        << duration.count() << " ms\n";
+    std::cout << "Прогулов всего: " << totalAbsences << "\n";
+
+    benchmarkKernels();
+    benchmarkTableOutput();
+    benchmarkIncremental();
+
+    std::cout << "=== Бенчмарк завершён ===\n";
+}
+
+void AttendanceManager::benchmarkKernels() const {
+    const auto& cols = columns();
+    const uint8_t absence = static_cast<uint8_t>(EventType::ABSENCE);
+    const size_t n = cols.types.size();
+    const int repeats = 20;
+
+    auto timeIt = [repeats](auto&& fn) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < repeats; ++r) fn();
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count() / repeats;
+    };
+    auto gbps = [n](double ms) { return ms > 0 ? n / (ms * 1e6) : 0.0; };
+
+    std::cout << "\n--- Ядра над колонкой типов (" << n << " байт, среднее из "
+        << repeats << ") ---\n";
+
+    volatile size_t sink = 0;
+    double structMs = timeIt([&] {
+        size_t count = 0;
+        for (const auto& rec : records) {
+            if (rec.type == EventType::ABSENCE) count++;
+        }
+        sink = count;
+    });
+    std::cout << "Цикл по AttendanceRecord:  " << structMs << " ms\n";
+
+    std::vector<uint64_t> bits((n + 63) / 64);
+    auto absenceOnly = filter::Expression::parse("type=absence");
+    kernels::Isa best = kernels::detectIsa();
+
+    for (kernels::Isa isa : { kernels::Isa::Scalar, kernels::Isa::SSE2, kernels::Isa::AVX2 }) {
+        if (static_cast<int>(isa) > static_cast<int>(best)) break;
+        kernels::setIsa(isa);
+
+        double bitmapMs = timeIt([&] { kernels::selectBitmap(cols.types.data(), n, absence, bits.data()); });
+        double whereMs = timeIt([&] { sink = selectWhere(absenceOnly).size(); });
+
+        std::cout << std::left << std::setw(8) << kernels::isaName(isa)
+            << " битовая маска: " << bitmapMs << " ms (" << gbps(bitmapMs) << " GB/s)"
+            << ", --where type=absence: " << whereMs << " ms\n";
+    }
+    kernels::setIsa(best);
+    (void)sink;
+}
+
+void AttendanceManager::benchmarkTableOutput() const {
+    std::cout << "\n--- Вывод таблицы (" << records.size() << " строк) ---\n";
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::ostringstream viaStream;
     for (const auto& rec : records) {
-        grouped[rec.student].push_back(&rec);
+        viaStream << std::left
+            << std::setw(utils::u8_adjust(rec.student, 25)) << rec.student
+            << std::setw(25) << rec.timestamp
+            << std::setw(10) << typeToStr(rec.type)
+            << std::setw(15) << std::fixed << std::setprecision(2) << rec.epoch / 3600.0
+            << "\n";
     }
+    auto end = std::chrono::high_resolution_clock::now();
+    double streamMs = std::chrono::duration<double, std::milli>(end - start).count();
 
-    for (auto& [student, studentRecords] : grouped) {
-        std::sort(studentRecords.begin(), studentRecords.end(),
-            [](const AttendanceRecord* a, const AttendanceRecord* b) {
-                return a->parseTimestamp() < b->parseTimestamp();
-            });
+    start = std::chrono::high_resolution_clock::now();
+    std::ostringstream viaWriter;
+    {
+        TableWriter table(viaWriter, {
+            { "Студент", 25 }, { "Время (UTC)", 25 }, { "Тип", 10 }, { "Часы", 15 } });
+        for (const auto& rec : records) {
+            table.cell(rec.student).cell(rec.timestamp).cell(typeToStr(rec.type))
+                .cell(rec.epoch / 3600.0);
+            table.endRow();
+        }
     }
+    end = std::chrono::high_resolution_clock::now();
+    double writerMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    double mb = viaWriter.str().size() / (1024.0 * 1024.0);
+    std::cout << "iostream + setw:  " << streamMs << " ms (" << mb / (streamMs / 1000.0) << " MB/s)\n";
+    std::cout << "TableWriter:      " << writerMs << " ms (" << mb / (writerMs / 1000.0) << " MB/s)\n";
+    std::cout << "Вывод совпадает: " << (viaStream.str() == viaWriter.str() ? "да" : "нет") << "\n";
+}
+
+void AttendanceManager::benchmarkIncremental() const {
+    const auto& grouped = getGrouped();
+    const size_t extra = 1000;
+    std::cout << "\n--- Инкрементальная статистика (" << records.size()
+        << " событий + " << extra << ") ---\n";
 
+    StatsEngine local;
+    auto start = std::chrono::high_resolution_clock::now();
+    local.rebuild(grouped);
     auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    double rebuildMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    // Новые события по кругу студентов: каждое десятое опаздывает на 15 минут
+    std::vector<std::string> names;
+    long long latest = 0;
+    for (const auto& [student, rows] : grouped) {
+        names.push_back(student);
+        if (!rows.empty()) latest = std::max(latest, rows.back()->epoch);
+    }
+    if (names.empty()) return;
 
-    std::cout << "[Benchmark] Группировка и сортировка: "
-        << duration.count() << " ms\n";
-    std::cout << "Записей в секунду: "
-        << (records.size() * 1000.0 / duration.count()) << "\n";
+    start = std::chrono::high_resolution_clock::now();
+    size_t late = 0;
+    for (size_t i = 0; i < extra; ++i) {
+        long long epoch = latest + static_cast<long long>(i) * 60;
+        if (i % 10 == 0) epoch -= 15 * 60;
+        EventType type = i % 2 == 0 ? EventType::IN : EventType::OUT;
+        if (local.add(names[i % names.size()], epoch, type) != StatsEngine::AddResult::Appended) late++;
+    }
+    end = std::chrono::high_resolution_clock::now();
+    double addUs = std::chrono::duration<double, std::micro>(end - start).count();
+
+    std::cout << "Полный пересчёт:  " << rebuildMs << " ms\n";
+    std::cout << "+" << extra << " событий: " << addUs << " мкс (опоздавших " << late
+        << ", пересчитано событий " << local.replayedEvents() << ")\n";
+}
+
+void AttendanceManager::benchmarkColumnar() const {
+    std::cout << "\n--- Колоночный снимок (" << records.size() << " записей) ---\n";
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::string jsonText = serializeJson();
+    auto end = std::chrono::high_resolution_clock::now();
+    double jsonMs = std::chrono::duration<double, std::milli>(end - start).count();
 
-    // Замер 2: Подсчёт статистики
     start = std::chrono::high_resolution_clock::now();
+    std::string packed = columnar::encode(records);
+    end = std::chrono::high_resolution_clock::now();
+    double encodeMs = std::chrono::duration<double, std::milli>(end - start).count();
 
-    int totalAbsences = 0;
-    for (const auto& rec : records) {
-        if (rec.type == EventType::ABSENCE) {
-            totalAbsences++;
-        }
+    start = std::chrono::high_resolution_clock::now();
+    auto parsed = recordsFromJson(json::Parser::parse(jsonText));
+    end = std::chrono::high_resolution_clock::now();
+    double parseMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    start = std::chrono::high_resolution_clock::now();
+    auto cols = columnar::decodeColumns(packed);
+    end = std::chrono::high_resolution_clock::now();
+    double columnsMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    start = std::chrono::high_resolution_clock::now();
+    auto decoded = columnar::decode(packed);
+    end = std::chrono::high_resolution_clock::now();
+    double decodeMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    // Снимок упорядочен по (студент, время): сравнение с тем же порядком
+    std::vector<const AttendanceRecord*> ordered;
+    ordered.reserve(records.size());
+    for (const auto& rec : records) ordered.push_back(&rec);
+    std::stable_sort(ordered.begin(), ordered.end(), [](const AttendanceRecord* a, const AttendanceRecord* b) {
+        if (a->student != b->student) return a->student < b->student;
+        return a->epoch < b->epoch;
+    });
+    bool same = decoded.size() == ordered.size();
+    for (size_t i = 0; same && i < ordered.size(); ++i) {
+        same = decoded[i].student == ordered[i]->student && decoded[i].timestamp == ordered[i]->timestamp
+            && decoded[i].type == ordered[i]->type && decoded[i].epoch == ordered[i]->epoch;
+    }
+
+    // Декодированные колонки: номер студента, epoch, тип
+    double columnBytes = static_cast<double>(cols.epochs.size())
+        * (sizeof(uint32_t) + sizeof(long long) + sizeof(uint8_t));
+    auto gbps = [](double bytes, double ms) { return ms > 0 ? bytes / (ms * 1e6) : 0.0; };
+    double mb = 1024.0 * 1024.0;
+
+    std::cout << "JSON:       " << jsonText.size() / mb << " MB (запись " << jsonMs << " ms, разбор "
+        << parseMs << " ms, " << gbps(static_cast<double>(jsonText.size()), parseMs) << " GB/s)\n";
+    std::cout << "Снимок:     " << packed.size() / mb << " MB, сжатие в "
+        << static_cast<double>(jsonText.size()) / std::max<size_t>(packed.size(), 1) << " раз"
+        << " (" << static_cast<double>(packed.size()) / std::max<size_t>(records.size(), 1) << " байт на запись)\n";
+    std::cout << "Кодирование:           " << encodeMs << " ms\n";
+    std::cout << "Декодирование колонок: " << columnsMs << " ms (" << gbps(columnBytes, columnsMs)
+        << " GB/s колонок, " << gbps(static_cast<double>(packed.size()), columnsMs) << " GB/s снимка)\n";
+    std::cout << "Декодирование записей: " << decodeMs << " ms (" << gbps(static_cast<double>(jsonText.size()), decodeMs)
+        << " GB/s в пересчёте на JSON)\n";
+    std::cout << "Без потерь: " << (same ? "да" : "нет") << "\n";
+}
+
+void AttendanceManager::benchmarkHeatmap() const {
+    const auto& cols = columns();
+    if (cols.epochs.empty()) return;
+
+    // Колонки повторяются до 10M+ событий, чтобы данные не помещались в кэш
+    const size_t target = 10'000'000;
+    size_t copies = (target + cols.epochs.size() - 1) / cols.epochs.size();
+    std::vector<long long> epochs;
+    std::vector<uint8_t> types;
+    epochs.reserve(copies * cols.epochs.size());
+    types.reserve(copies * cols.types.size());
+    for (size_t c = 0; c < copies; ++c) {
+        epochs.insert(epochs.end(), cols.epochs.begin(), cols.epochs.end());
+        types.insert(types.end(), cols.types.begin(), cols.types.end());
     }
+    const size_t n = epochs.size();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    heatmap::SlotTable table(cols.minEpoch, cols.maxEpoch);
+    auto end = std::chrono::high_resolution_clock::now();
+    double tableMs = std::chrono::duration<double, std::milli>(end - start).count();
 
+    const int repeats = 5;
+    heatmap::Grid grid;
+    start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < repeats; ++r) grid = heatmap::build(epochs.data(), types.data(), nullptr, n, table);
     end = std::chrono::high_resolution_clock::now();
-    duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    double histMs = std::chrono::duration<double, std::milli>(end - start).count() / repeats;
 
-    std::cout << "[Benchmark] Подсчёт прогулов: "
-        << duration.count() << " ms\n";
-    std::cout << "Прогулов всего: " << totalAbsences << "\n";
+    // Тот же подсчёт через localtime на каждую запись (без таблицы), на исходных данных
+    start = std::chrono::high_resolution_clock::now();
+    uint64_t naive[heatmap::DAYS][heatmap::HOURS] = {};
+    for (size_t i = 0; i < cols.epochs.size(); ++i) {
+        if (cols.types[i] != static_cast<uint8_t>(EventType::IN)) continue;
+        std::time_t t = static_cast<std::time_t>(cols.epochs[i]);
+        std::tm tm = {};
+#ifdef _WIN32
+        localtime_s(&tm, &t);
+#else
+        localtime_r(&t, &tm);
+#endif
+        naive[(tm.tm_wday + 6) % 7][tm.tm_hour]++;
+    }
+    end = std::chrono::high_resolution_clock::now();
+    double naiveMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    bool same = true;
+    for (size_t d = 0; d < heatmap::DAYS; ++d) {
+        for (size_t h = 0; h < heatmap::HOURS; ++h) {
+            same = same && grid.counts[d][h] == naive[d][h] * copies;
+        }
+    }
+
+    double bytes = static_cast<double>(n) * (sizeof(long long) + sizeof(uint8_t));
+    std::cout << "\n--- Тепловая карта (" << n << " событий, " << copies << " копий данных) ---\n";
+    std::cout << "Таблица интервалов: " << table.size() << " по " << kernels::SLOT_SECONDS
+        << " с (" << tableMs << " ms)\n";
+    std::cout << "Гистограмма: " << histMs << " ms (" << (histMs > 0 ? bytes / (histMs * 1e6) : 0.0)
+        << " GB/s, " << (histMs > 0 ? n / (histMs * 1e3) : 0.0) << " M событий/с)\n";
+    std::cout << "localtime на запись: " << naiveMs << " ms на " << cols.epochs.size()
+        << " событиях (" << (naiveMs > 0 ? cols.epochs.size() / (naiveMs * 1e3) : 0.0) << " M событий/с)\n";
+    std::cout << "Совпадает с localtime: " << (same ? "да" : "нет") << "\n";
+}
+
+void AttendanceManager::benchmarkScaling() {
+    if (records.empty()) {
+        std::cout << "Нет данных для бенчмарка.\n";
+        return;
+    }
+
+    std::cout << "\n=== Бенчмарк масштабирования ===\n";
+    std::cout << "Количество записей: " << records.size() << "\n\n";
+    std::cout << std::left
+        << std::setw(utils::u8_adjust("Потоки", 10)) << "Потоки"
+        << std::setw(utils::u8_adjust("Метки, мс", 14)) << "Метки, мс"
+        << std::setw(utils::u8_adjust("Валид., мс", 14)) << "Валид., мс"
+        << std::setw(utils::u8_adjust("Агрег., мс", 14)) << "Агрег., мс"
+        << std::setw(utils::u8_adjust("Сохр., мс", 14)) << "Сохр., мс" << "\n";
+    std::cout << std::string(66, '-') << "\n";
+
+    size_t originalThreads = ThreadPool::instance().threadCount();
+    const std::vector<AttendanceRecord> snapshot = records;
+
+    auto timeIt = [](auto&& fn) {
+        auto start = std::chrono::high_resolution_clock::now();
+        fn();
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    };
+
+    for (size_t threads : { 1, 2, 4, 8, 16 }) {
+        ThreadPool::configure(threads);
+        records = snapshot;
+
+        double decodeMs = timeIt([&] {
+            ThreadPool::instance().parallelFor(0, records.size(), 4096, [&](size_t lo, size_t hi) {
+                for (size_t i = lo; i < hi; ++i) records[i].epoch = records[i].parseTimestamp();
+            });
+        });
+
+        std::streambuf* saved = std::cout.rdbuf(nullptr);
+        double validateMs = timeIt([&] { validateData(); });
+        std::cout.rdbuf(saved);
+
+        double aggregateMs = timeIt([&] { getStats(); });
+        double saveMs = timeIt([&] { serializeJson(); });
 
+        std::cout << std::left << std::fixed << std::setprecision(2)
+            << std::setw(10) << threads
+            << std::setw(14) << decodeMs
+            << std::setw(14) << validateMs
+            << std::setw(14) << aggregateMs
+            << std::setw(14) << saveMs << "\n";
+    }
+
+    ThreadPool::configure(originalThreads);
+    records = snapshot;
+    version++;
     std::cout << "=== Бенчмарк завершён ===\n";
+}
+
+// --- JSON queries ---
+
+void AttendanceManager::warmCaches() const {
+    getStats();
+    getGrouped();
+    getTimeIndex();
+    getDictionary();
+}
+
+void AttendanceManager::freeze() {
+    warmCaches();
+    columns();
+    frozen = true;
+}
+
+json::Value AttendanceManager::statsToJson() const {
+    const auto& stats = getStats();
+
+    json::ObjectType perStudent;
+    int totalAbsences = 0;
+    double totalHours = 0.0;
+    int totalRecords = 0;
+
+    for (const auto& [student, stat] : stats) {
+        json::ObjectType obj;
+        obj["absences"] = json::Value(stat.absences);
+        obj["hours"] = json::Value(stat.hoursPresent);
+        obj["records"] = json::Value(stat.totalRecords);
+        perStudent[student] = json::Value(std::move(obj));
+
+        totalAbsences += stat.absences;
+        totalHours += stat.hoursPresent;
+        totalRecords += stat.totalRecords;
+    }
+
+    json::ObjectType total;
+    total["absences"] = json::Value(totalAbsences);
+    total["hours"] = json::Value(totalHours);
+    total["records"] = json::Value(totalRecords);
+
+    json::ObjectType result;
+    result["students"] = json::Value(static_cast<double>(stats.size()));
+    result["stats"] = json::Value(std::move(perStudent));
+    result["total"] = json::Value(std::move(total));
+    return json::Value(std::move(result));
+}
+
+json::Value AttendanceManager::studentToJson(const std::string& name) const {
+    const auto& grouped = getGrouped();
+
+    json::ArrayType arr;
+    auto found = grouped.find(name);
+    if (found != grouped.end()) {
+        arr.reserve(found->second.size());
+        for (const auto* rec : found->second) {
+            json::ObjectType obj;
+            obj["ts"] = json::Value(rec->timestamp);
+            obj["type"] = json::Value(typeToStr(rec->type));
+            arr.push_back(json::Value(std::move(obj)));
+        }
+    }
+
+    json::ObjectType result;
+    if (found == grouped.end()) {
+        json::ArrayType suggestions;
+        for (auto& s : suggestStudents(name)) suggestions.push_back(json::Value(s));
+        result["suggestions"] = json::Value(std::move(suggestions));
+    }
+    result["student"] = json::Value(name);
+    result["count"] = json::Value(static_cast<double>(arr.size()));
+    result["records"] = json::Value(std::move(arr));
+    return json::Value(std::move(result));
+}
+
+json::Value AttendanceManager::rangeToJson(long long from, long long to) const {
+    auto matched = rangeRecords(from, to);
+
+    json::ArrayType arr;
+    arr.reserve(matched.size());
+    for (const auto* rec : matched) {
+        json::ObjectType obj;
+        obj["student"] = json::Value(rec->student);
+        obj["ts"] = json::Value(rec->timestamp);
+        obj["type"] = json::Value(typeToStr(rec->type));
+        arr.push_back(json::Value(std::move(obj)));
+    }
+
+    json::ObjectType result;
+    result["from"] = json::Value(static_cast<double>(from));
+    result["to"] = json::Value(static_cast<double>(to));
+    result["count"] = json::Value(static_cast<double>(arr.size()));
+    result["records"] = json::Value(std::move(arr));
+    return json::Value(std::move(result));
+}
+
+long long AttendanceManager::parseDateBound(const std::string& s, bool endOfDay) {
+    if (s.length() == 10) {
+        long long dayStart = AttendanceRecord::parseTimestamp(s + "T00:00:00");
+        if (dayStart == 0 || !endOfDay) return dayStart;
+
+        // Конец суток — за секунду до следующей местной полуночи: в день
+        // перехода на летнее время в сутках 23 или 25 часов
+        std::time_t t = static_cast<std::time_t>(dayStart);
+        std::tm tm = {};
+#ifdef _WIN32
+        localtime_s(&tm, &t);
+#else
+        localtime_r(&t, &tm);
+#endif
+        tm.tm_mday += 1;
+        tm.tm_hour = 0;
+        tm.tm_min = 0;
+        tm.tm_sec = 0;
+        tm.tm_isdst = -1;
+        long long nextDay = static_cast<long long>(std::mktime(&tm));
+        return nextDay == -1 ? 0 : nextDay - 1;
+    }
+    return AttendanceRecord::parseTimestamp(s);
 }
\ No newline at end of file
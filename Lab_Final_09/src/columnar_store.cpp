@@ -0,0 +1,375 @@
+﻿#include "../include/columnar_store.hpp"
+#include "../include/thread_pool.hpp"
+#include "../include/utils.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <stdexcept>
+
+namespace columnar {
+
+    static const char MAGIC[4] = { 'A', 'T', 'C', 'S' };
+    static const uint32_t VERSION = 1;
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint64_t records;
+        uint32_t blocks;
+        uint32_t dictionarySize;
+    };
+
+    // Каталог блоков: смещение от начала файла, строк, байт
+    struct BlockRef {
+        uint64_t offset;
+        uint32_t rows;
+        uint32_t bytes;
+    };
+
+    static_assert(sizeof(Header) == 24, "Header layout");
+    static_assert(sizeof(BlockRef) == 16, "BlockRef layout");
+
+    // --- Varint ---
+
+    static void putVarint(std::string& out, uint64_t v) {
+        while (v >= 0x80) {
+            out += static_cast<char>(v | 0x80);
+            v >>= 7;
+        }
+        out += static_cast<char>(v);
+    }
+
+    static uint64_t getVarint(const char*& p, const char* end) {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p >= end) break;
+            uint8_t b = static_cast<uint8_t>(*p++);
+            v |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        throw std::runtime_error("Corrupted columnar snapshot");
+    }
+
+    static uint64_t zigzag(long long v) {
+        return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+    }
+
+    static long long unzigzag(uint64_t u) {
+        return static_cast<long long>(u >> 1) ^ -static_cast<long long>(u & 1);
+    }
+
+    // --- Timestamps ---
+
+    // "YYYY-MM-DDTHH:MM:SSZ" в местном времени, как AttendanceRecord::formatTimestamp.
+    // localtime вызывается только при смене часа: переводы часов происходят
+    // на границе часа, так что минуты и секунды считаются арифметикой
+    class TimestampFormatter {
+    public:
+        std::string_view format(long long epoch) {
+            if (epoch < hourStart || epoch >= hourStart + 3600) startHour(epoch);
+
+            long long secs = epoch - hourStart;
+            writeTwo(buf + 14, static_cast<int>(secs / 60));
+            writeTwo(buf + 17, static_cast<int>(secs % 60));
+            return { buf, 20 };
+        }
+
+    private:
+        long long hourStart = 0;
+        char buf[48] = {};
+
+        static void writeTwo(char* p, int v) {
+            p[0] = static_cast<char>('0' + v / 10);
+            p[1] = static_cast<char>('0' + v % 10);
+        }
+
+        void startHour(long long epoch) {
+            std::time_t t = static_cast<std::time_t>(epoch);
+            std::tm tm = {};
+#ifdef _WIN32
+            localtime_s(&tm, &t);
+#else
+            localtime_r(&t, &tm);
+#endif
+            hourStart = epoch - (tm.tm_min * 60LL + tm.tm_sec);
+            std::snprintf(buf, sizeof(buf), "%04d-%02d-%02dT%02d:00:00Z",
+                tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour);
+        }
+    };
+
+    // --- Encode ---
+
+    static std::string encodeBlock(const std::vector<const AttendanceRecord*>& rows,
+        const std::vector<uint32_t>& ids, size_t begin, size_t end) {
+        std::string out;
+        out.reserve((end - begin) * 3);
+
+        // Прогоны студентов
+        std::vector<std::pair<uint32_t, uint32_t>> runs;
+        for (size_t i = begin; i < end; ++i) {
+            if (runs.empty() || runs.back().first != ids[i]) runs.push_back({ ids[i], 0 });
+            runs.back().second++;
+        }
+        putVarint(out, runs.size());
+        for (const auto& [id, length] : runs) {
+            putVarint(out, id);
+            putVarint(out, length);
+        }
+
+        // Метки времени: разность с предыдущей меткой прогона
+        size_t i = begin;
+        for (const auto& [id, length] : runs) {
+            long long prev = 0;
+            for (uint32_t k = 0; k < length; ++k, ++i) {
+                putVarint(out, zigzag(rows[i]->epoch - prev));
+                prev = rows[i]->epoch;
+            }
+        }
+
+        // Типы по 2 бита
+        size_t typeStart = out.size();
+        out.append((end - begin + 3) / 4, '\0');
+        for (size_t j = begin; j < end; ++j) {
+            size_t r = j - begin;
+            out[typeStart + r / 4] |= static_cast<char>((static_cast<uint8_t>(rows[j]->type) & 3) << (r % 4 * 2));
+        }
+
+        // Исключения: метки, которые не совпадают с восстановленной из epoch
+        TimestampFormatter formatter;
+        std::string exceptions;
+        size_t exceptionCount = 0;
+        for (size_t j = begin; j < end; ++j) {
+            if (formatter.format(rows[j]->epoch) == rows[j]->timestamp) continue;
+            putVarint(exceptions, j - begin);
+            putVarint(exceptions, rows[j]->timestamp.size());
+            exceptions += rows[j]->timestamp;
+            exceptionCount++;
+        }
+        putVarint(out, exceptionCount);
+        out += exceptions;
+        return out;
+    }
+
+    std::string encode(const std::vector<AttendanceRecord>& records) {
+        std::vector<const AttendanceRecord*> rows(records.size());
+        for (size_t i = 0; i < records.size(); ++i) rows[i] = &records[i];
+        std::stable_sort(rows.begin(), rows.end(), [](const AttendanceRecord* a, const AttendanceRecord* b) {
+            if (a->student != b->student) return a->student < b->student;
+            return a->epoch < b->epoch;
+        });
+
+        // Словарь в порядке имён: номера прогонов возрастают
+        std::vector<std::string> dictionary;
+        std::vector<uint32_t> ids(rows.size());
+        for (size_t i = 0; i < rows.size(); ++i) {
+            if (dictionary.empty() || dictionary.back() != rows[i]->student) dictionary.push_back(rows[i]->student);
+            ids[i] = static_cast<uint32_t>(dictionary.size() - 1);
+        }
+
+        size_t blockCount = (rows.size() + BLOCK_ROWS - 1) / BLOCK_ROWS;
+        std::vector<std::string> blocks(blockCount);
+        ThreadPool::instance().parallelFor(0, blockCount, 1, [&](size_t lo, size_t hi) {
+            for (size_t b = lo; b < hi; ++b) {
+                blocks[b] = encodeBlock(rows, ids, b * BLOCK_ROWS, std::min(rows.size(), (b + 1) * BLOCK_ROWS));
+            }
+        });
+
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.records = rows.size();
+        header.blocks = static_cast<uint32_t>(blockCount);
+        header.dictionarySize = static_cast<uint32_t>(dictionary.size());
+
+        std::string names;
+        for (const auto& name : dictionary) {
+            putVarint(names, name.size());
+            names += name;
+        }
+
+        std::string out;
+        out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        out += names;
+
+        uint64_t offset = out.size() + blockCount * sizeof(BlockRef);
+        for (size_t b = 0; b < blockCount; ++b) {
+            BlockRef ref{ offset, static_cast<uint32_t>(std::min(BLOCK_ROWS, rows.size() - b * BLOCK_ROWS)),
+                static_cast<uint32_t>(blocks[b].size()) };
+            out.append(reinterpret_cast<const char*>(&ref), sizeof(ref));
+            offset += blocks[b].size();
+        }
+        for (const auto& block : blocks) out += block;
+        return out;
+    }
+
+    // --- Decode ---
+
+    struct Layout {
+        std::vector<std::string> dictionary;
+        std::vector<BlockRef> blocks;
+        std::vector<size_t> firstRow;   // номер первой строки блока
+        size_t records = 0;
+    };
+
+    static Layout readLayout(std::string_view data) {
+        Header header;
+        if (data.size() < sizeof(header)) throw std::runtime_error("Not a columnar snapshot");
+        std::memcpy(&header, data.data(), sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) throw std::runtime_error("Not a columnar snapshot");
+        if (header.version != VERSION) throw std::runtime_error("Unsupported columnar snapshot version");
+
+        Layout layout;
+        layout.records = static_cast<size_t>(header.records);
+        const char* p = data.data() + sizeof(header);
+        const char* end = data.data() + data.size();
+
+        layout.dictionary.reserve(header.dictionarySize);
+        for (uint32_t i = 0; i < header.dictionarySize; ++i) {
+            size_t length = static_cast<size_t>(getVarint(p, end));
+            if (static_cast<size_t>(end - p) < length) throw std::runtime_error("Corrupted columnar snapshot");
+            layout.dictionary.emplace_back(p, length);
+            p += length;
+        }
+
+        if (static_cast<size_t>(end - p) < header.blocks * sizeof(BlockRef)) {
+            throw std::runtime_error("Corrupted columnar snapshot");
+        }
+        layout.blocks.resize(header.blocks);
+        std::memcpy(layout.blocks.data(), p, header.blocks * sizeof(BlockRef));
+
+        size_t row = 0;
+        for (const auto& ref : layout.blocks) {
+            if (ref.offset + ref.bytes > data.size()) throw std::runtime_error("Corrupted columnar snapshot");
+            layout.firstRow.push_back(row);
+            row += ref.rows;
+        }
+        if (row != layout.records) throw std::runtime_error("Corrupted columnar snapshot");
+        return layout;
+    }
+
+    // Колонки блока; exceptions — метки-исключения (номер строки в блоке, текст)
+    static void decodeBlock(std::string_view data, const BlockRef& ref, size_t dictionarySize,
+        uint32_t* students, long long* epochs, uint8_t* types,
+        std::vector<std::pair<uint32_t, std::string_view>>* exceptions) {
+        const char* p = data.data() + ref.offset;
+        const char* end = p + ref.bytes;
+        const size_t rows = ref.rows;
+
+        size_t runCount = static_cast<size_t>(getVarint(p, end));
+        std::vector<std::pair<uint32_t, uint32_t>> runs(runCount);
+        size_t covered = 0;
+        for (auto& run : runs) {
+            run.first = static_cast<uint32_t>(getVarint(p, end));
+            run.second = static_cast<uint32_t>(getVarint(p, end));
+            if (run.first >= dictionarySize) throw std::runtime_error("Corrupted columnar snapshot");
+            covered += run.second;
+        }
+        if (covered != rows) throw std::runtime_error("Corrupted columnar snapshot");
+
+        size_t i = 0;
+        for (const auto& [id, length] : runs) {
+            long long prev = 0;
+            for (uint32_t k = 0; k < length; ++k, ++i) {
+                prev += unzigzag(getVarint(p, end));
+                students[i] = id;
+                epochs[i] = prev;
+            }
+        }
+
+        size_t typeBytes = (rows + 3) / 4;
+        if (static_cast<size_t>(end - p) < typeBytes) throw std::runtime_error("Corrupted columnar snapshot");
+        const uint8_t* packed = reinterpret_cast<const uint8_t*>(p);
+        for (size_t r = 0; r < rows; ++r) {
+            types[r] = (packed[r / 4] >> (r % 4 * 2)) & 3;
+        }
+        p += typeBytes;
+
+        size_t exceptionCount = static_cast<size_t>(getVarint(p, end));
+        if (!exceptions) return;
+        exceptions->reserve(exceptionCount);
+        for (size_t e = 0; e < exceptionCount; ++e) {
+            uint32_t row = static_cast<uint32_t>(getVarint(p, end));
+            size_t length = static_cast<size_t>(getVarint(p, end));
+            if (row >= rows || static_cast<size_t>(end - p) < length) {
+                throw std::runtime_error("Corrupted columnar snapshot");
+            }
+            exceptions->emplace_back(row, std::string_view(p, length));
+            p += length;
+        }
+    }
+
+    Columns decodeColumns(std::string_view data) {
+        Layout layout = readLayout(data);
+        Columns cols;
+        cols.students.resize(layout.records);
+        cols.epochs.resize(layout.records);
+        cols.types.resize(layout.records);
+
+        ThreadPool::instance().parallelFor(0, layout.blocks.size(), 1, [&](size_t lo, size_t hi) {
+            for (size_t b = lo; b < hi; ++b) {
+                size_t first = layout.firstRow[b];
+                decodeBlock(data, layout.blocks[b], layout.dictionary.size(),
+                    cols.students.data() + first, cols.epochs.data() + first, cols.types.data() + first, nullptr);
+            }
+        });
+
+        cols.dictionary = std::move(layout.dictionary);
+        return cols;
+    }
+
+    std::vector<AttendanceRecord> decode(std::string_view data) {
+        Layout layout = readLayout(data);
+        std::vector<AttendanceRecord> records(layout.records);
+
+        ThreadPool::instance().parallelFor(0, layout.blocks.size(), 1, [&](size_t lo, size_t hi) {
+            std::vector<uint32_t> students(BLOCK_ROWS);
+            std::vector<long long> epochs(BLOCK_ROWS);
+            std::vector<uint8_t> types(BLOCK_ROWS);
+            std::vector<std::pair<uint32_t, std::string_view>> exceptions;
+            TimestampFormatter formatter;
+
+            for (size_t b = lo; b < hi; ++b) {
+                const BlockRef& ref = layout.blocks[b];
+                if (ref.rows > BLOCK_ROWS) throw std::runtime_error("Corrupted columnar snapshot");
+                exceptions.clear();
+                decodeBlock(data, ref, layout.dictionary.size(),
+                    students.data(), epochs.data(), types.data(), &exceptions);
+
+                AttendanceRecord* out = records.data() + layout.firstRow[b];
+                size_t next = 0;
+                for (uint32_t r = 0; r < ref.rows; ++r) {
+                    AttendanceRecord& rec = out[r];
+                    rec.student = layout.dictionary[students[r]];
+                    rec.type = static_cast<EventType>(types[r]);
+                    rec.epoch = epochs[r];
+                    if (next < exceptions.size() && exceptions[next].first == r) {
+                        rec.timestamp = exceptions[next++].second;
+                    }
+                    else {
+                        rec.timestamp = formatter.format(epochs[r]);
+                    }
+                }
+            }
+        });
+
+        return records;
+    }
+
+    // --- Files ---
+
+    void save(const std::string& filename, const std::vector<AttendanceRecord>& records) {
+        std::string path = utils::getPath(filename);
+        std::string data = encode(records);
+        std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) throw std::runtime_error("Cannot open file for writing: " + path);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+        out.flush();
+        if (!out) throw std::runtime_error("Write failed: " + path);
+    }
+
+    std::vector<AttendanceRecord> load(const std::string& filename) {
+        return decode(utils::readFile(filename));
+    }
+}
\ No newline at end of file
@@ -0,0 +1,167 @@
+﻿#include "../include/dedup.hpp"
+#include "../include/sketch.hpp"
+#include "../include/thread_pool.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace dedup {
+
+    static uint64_t mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    uint64_t fingerprint(std::string_view student, long long epoch, EventType type) {
+        uint64_t h = sketch::hashKey(student);
+        h ^= mix((static_cast<uint64_t>(epoch) << 2) ^ static_cast<uint64_t>(type));
+        h = mix(h + 0x9e3779b97f4a7c15ULL);
+        return h == 0 ? 1 : h;  // 0 занят под пустую ячейку
+    }
+
+    // --- FingerprintSet ---
+
+    static constexpr size_t MIN_CAPACITY = 64;
+
+    // Заполнение не больше половины: короткие цепочки пробирования
+    static size_t capacityFor(size_t items) {
+        return std::max(MIN_CAPACITY, std::bit_ceil(items * 2 + 1));
+    }
+
+    FingerprintSet::FingerprintSet(size_t expected) : slots(capacityFor(expected), Slot{ 0, 0 }) {
+    }
+
+    void FingerprintSet::rehash(size_t capacity) {
+        std::vector<Slot> old(capacity, Slot{ 0, 0 });
+        old.swap(slots);
+        size_t mask = slots.size() - 1;
+        for (const auto& slot : old) {
+            if (slot.fp == 0) continue;
+            size_t i = static_cast<size_t>(slot.fp) & mask;
+            while (slots[i].fp != 0) i = (i + 1) & mask;
+            slots[i] = slot;
+        }
+    }
+
+    bool FingerprintSet::insert(uint64_t fp, long long epoch) {
+        if ((count + 1) * 2 > slots.size()) rehash(slots.size() * 2);
+
+        size_t mask = slots.size() - 1;
+        size_t i = static_cast<size_t>(fp) & mask;
+        while (slots[i].fp != 0) {
+            if (slots[i].fp == fp) return false;
+            i = (i + 1) & mask;
+        }
+        slots[i] = { fp, epoch };
+        count++;
+        return true;
+    }
+
+    size_t FingerprintSet::evictBefore(long long before) {
+        // Удаление из цепочек линейного пробирования требует сдвигов,
+        // поэтому оставшиеся отпечатки просто переносятся в новую таблицу
+        size_t kept = 0;
+        for (auto& slot : slots) {
+            if (slot.fp == 0) continue;
+            if (slot.epoch < before) slot.fp = 0;
+            else kept++;
+        }
+        size_t evicted = count - kept;
+        if (evicted == 0) return 0;
+
+        count = kept;
+        rehash(capacityFor(kept));
+        return evicted;
+    }
+
+    void FingerprintSet::clear() {
+        slots.assign(MIN_CAPACITY, Slot{ 0, 0 });
+        count = 0;
+    }
+
+    // --- Deduplicator ---
+
+    static size_t shardOf(uint64_t fp) {
+        // Младшие биты — позиция в таблице части, старшие — номер части
+        return static_cast<size_t>(fp >> 60) % Deduplicator::SHARDS;
+    }
+
+    Deduplicator::Deduplicator(long long windowSeconds)
+        : windowSeconds(std::max(0LL, windowSeconds)), shards(SHARDS) {
+    }
+
+    size_t Deduplicator::filter(std::vector<AttendanceRecord>& recs) {
+        if (recs.empty()) return 0;
+
+        std::vector<uint64_t> fps(recs.size());
+        ThreadPool::instance().parallelFor(0, recs.size(), 4096, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) {
+                fps[i] = fingerprint(recs[i].student, recs[i].epoch, recs[i].type);
+            }
+        });
+
+        // Индексы записей, разложенные по частям с сохранением порядка
+        std::vector<size_t> offsets(SHARDS + 1, 0);
+        for (uint64_t fp : fps) offsets[shardOf(fp) + 1]++;
+        for (size_t s = 0; s < SHARDS; ++s) offsets[s + 1] += offsets[s];
+        std::vector<uint32_t> order(recs.size());
+        std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < fps.size(); ++i) order[fill[shardOf(fps[i])]++] = static_cast<uint32_t>(i);
+
+        std::vector<char> keep(recs.size(), 0);
+        ThreadPool::instance().parallelFor(0, SHARDS, 1, [&](size_t lo, size_t hi) {
+            for (size_t s = lo; s < hi; ++s) {
+                for (size_t k = offsets[s]; k < offsets[s + 1]; ++k) {
+                    uint32_t i = order[k];
+                    keep[i] = shards[s].insert(fps[i], recs[i].epoch) ? 1 : 0;
+                }
+            }
+        });
+
+        size_t kept = 0;
+        for (size_t i = 0; i < recs.size(); ++i) {
+            if (!keep[i]) continue;
+            watermark = std::max(watermark, recs[i].epoch);
+            if (kept != i) recs[kept] = std::move(recs[i]);
+            kept++;
+        }
+        size_t removed = recs.size() - kept;
+        recs.resize(kept);
+
+        evict();
+        return removed;
+    }
+
+    void Deduplicator::evict() {
+        if (windowSeconds == 0 || watermark == LLONG_MIN) return;
+        // Перестройка таблиц стоит O(ёмкости), поэтому не чаще, чем через четверть окна
+        if (lastEviction != LLONG_MIN && watermark - lastEviction < std::max(1LL, windowSeconds / 4)) return;
+        lastEviction = watermark;
+
+        long long before = watermark - windowSeconds;
+        ThreadPool::instance().parallelFor(0, SHARDS, 1, [&](size_t lo, size_t hi) {
+            for (size_t s = lo; s < hi; ++s) shards[s].evictBefore(before);
+        });
+    }
+
+    void Deduplicator::clear() {
+        for (auto& shard : shards) shard.clear();
+        watermark = LLONG_MIN;
+        lastEviction = LLONG_MIN;
+    }
+
+    size_t Deduplicator::size() const {
+        size_t total = 0;
+        for (const auto& shard : shards) total += shard.size();
+        return total;
+    }
+
+    size_t Deduplicator::memoryBytes() const {
+        size_t total = 0;
+        for (const auto& shard : shards) total += shard.memoryBytes();
+        return total;
+    }
+}
\ No newline at end of file
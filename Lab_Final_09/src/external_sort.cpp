@@ -0,0 +1,248 @@
+﻿#include "../include/external_sort.hpp"
+#include <fstream>
+#include <algorithm>
+#include <queue>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+static bool entryLess(const ExternalStore::Entry& a, const ExternalStore::Entry& b) {
+    if (a.student != b.student) return a.student < b.student;
+    return a.epoch < b.epoch;
+}
+
+// Буферизованное чтение одного прогона
+class RunReader {
+public:
+    explicit RunReader(const std::filesystem::path& path) : in(path, std::ios::binary) {
+        if (!in.is_open()) throw std::runtime_error("Cannot open run file: " + path.string());
+        chunk.resize(4096);
+    }
+
+    bool next(ExternalStore::Entry& out) {
+        if (pos == count) {
+            in.read(reinterpret_cast<char*>(chunk.data()),
+                static_cast<std::streamsize>(chunk.size() * sizeof(ExternalStore::Entry)));
+            count = static_cast<size_t>(in.gcount()) / sizeof(ExternalStore::Entry);
+            pos = 0;
+            if (count == 0) return false;
+        }
+        out = chunk[pos++];
+        return true;
+    }
+
+private:
+    std::ifstream in;
+    std::vector<ExternalStore::Entry> chunk;
+    size_t pos = 0;
+    size_t count = 0;
+};
+
+// Буферизованная запись прогона
+class RunWriter {
+public:
+    explicit RunWriter(const std::filesystem::path& path) : path(path), out(path, std::ios::binary) {
+        if (!out.is_open()) throw std::runtime_error("Cannot create run file: " + path.string());
+        chunk.reserve(4096);
+    }
+
+    void push(const ExternalStore::Entry& e) {
+        chunk.push_back(e);
+        if (chunk.size() == chunk.capacity()) flush();
+    }
+
+    void close() {
+        flush();
+        out.close();
+        if (!out) throw std::runtime_error("Failed to write run file: " + path.string());
+    }
+
+private:
+    std::filesystem::path path;
+    std::ofstream out;
+    std::vector<ExternalStore::Entry> chunk;
+
+    void flush() {
+        out.write(reinterpret_cast<const char*>(chunk.data()),
+            static_cast<std::streamsize>(chunk.size() * sizeof(ExternalStore::Entry)));
+        if (!out) throw std::runtime_error("Failed to write run file: " + path.string());
+        chunk.clear();
+    }
+};
+
+// k-way слияние прогонов; при равных ключах раньше идёт запись из прогона
+// с меньшим номером, поэтому порядок добавления сохраняется
+static void mergeRuns(const std::vector<std::filesystem::path>& paths,
+    const std::function<void(const ExternalStore::Entry&)>& fn) {
+    struct Head {
+        ExternalStore::Entry entry;
+        size_t run;
+    };
+    auto later = [](const Head& a, const Head& b) {
+        if (entryLess(b.entry, a.entry)) return true;
+        if (entryLess(a.entry, b.entry)) return false;
+        return a.run > b.run;
+    };
+
+    std::vector<RunReader> readers;
+    readers.reserve(paths.size());
+    for (const auto& run : paths) readers.emplace_back(run);
+
+    std::priority_queue<Head, std::vector<Head>, decltype(later)> heap(later);
+    for (size_t i = 0; i < readers.size(); ++i) {
+        Head h{ {}, i };
+        if (readers[i].next(h.entry)) heap.push(h);
+    }
+
+    while (!heap.empty()) {
+        Head h = heap.top();
+        heap.pop();
+        fn(h.entry);
+        if (readers[h.run].next(h.entry)) heap.push(h);
+    }
+}
+
+ExternalStore::ExternalStore(size_t memoryBudgetBytes) {
+    maxBufferEntries = std::max<size_t>(1024, memoryBudgetBytes / sizeof(Entry));
+    buffer.reserve(std::min<size_t>(maxBufferEntries, 1 << 20));
+
+    auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    runPrefix = "attendance_run_" + std::to_string(stamp) + "_";
+}
+
+ExternalStore::~ExternalStore() {
+    for (const auto& run : runs) {
+        std::error_code ec;
+        std::filesystem::remove(run, ec);
+    }
+}
+
+void ExternalStore::add(const AttendanceRecord& rec) {
+    if (!AttendanceManager::isValid(rec)) {
+        rejected++;
+        return;
+    }
+
+    uint32_t id = dictionary.intern(rec.student);
+    buffer.push_back({ id, rec.epoch, static_cast<uint8_t>(rec.type) });
+    accepted++;
+
+    if (buffer.size() >= maxBufferEntries) {
+        flushRun();
+    }
+}
+
+void ExternalStore::finish() {
+    if (!buffer.empty()) flushRun();
+    buffer.shrink_to_fit();
+    cascadeRuns();
+}
+
+std::filesystem::path ExternalStore::nextRunPath() {
+    return std::filesystem::temp_directory_path() /
+        (runPrefix + std::to_string(nextRunId++) + ".bin");
+}
+
+void ExternalStore::flushRun() {
+    std::stable_sort(buffer.begin(), buffer.end(), entryLess);
+
+    auto path = nextRunPath();
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) throw std::runtime_error("Cannot create run file: " + path.string());
+
+    out.write(reinterpret_cast<const char*>(buffer.data()),
+        static_cast<std::streamsize>(buffer.size() * sizeof(Entry)));
+    if (!out) throw std::runtime_error("Failed to write run file: " + path.string());
+
+    runs.push_back(path);
+    spilled++;
+    buffer.clear();
+}
+
+void ExternalStore::cascadeRuns() {
+    // Соседние группы по MERGE_FAN_IN прогонов сливаются в промежуточные,
+    // пока прогонов не останется столько, что их можно открыть разом.
+    // Группы идут по порядку, поэтому порядок равных записей сохраняется.
+    while (runs.size() > MERGE_FAN_IN) {
+        std::vector<std::filesystem::path> next;
+        next.reserve((runs.size() + MERGE_FAN_IN - 1) / MERGE_FAN_IN);
+
+        for (size_t first = 0; first < runs.size(); first += MERGE_FAN_IN) {
+            size_t last = std::min(runs.size(), first + MERGE_FAN_IN);
+            std::vector<std::filesystem::path> group(runs.begin() + first, runs.begin() + last);
+            if (group.size() == 1) {
+                next.push_back(group.front());
+                continue;
+            }
+
+            auto path = nextRunPath();
+            try {
+                RunWriter writer(path);
+                mergeRuns(group, [&writer](const Entry& e) { writer.push(e); });
+                writer.close();
+            }
+            catch (...) {
+                // Недописанный прогон удаляется; слитые и оставшиеся прогоны
+                // по-прежнему в runs и удалятся деструктором
+                std::error_code ec;
+                std::filesystem::remove(path, ec);
+                runs.erase(runs.begin(), runs.begin() + first);
+                runs.insert(runs.begin(), next.begin(), next.end());
+                throw;
+            }
+
+            for (const auto& run : group) {
+                std::error_code ec;
+                std::filesystem::remove(run, ec);
+            }
+            next.push_back(path);
+        }
+
+        runs = std::move(next);
+    }
+}
+
+void ExternalStore::forEachMerged(const std::function<void(const Entry&)>& fn) const {
+    mergeRuns(runs, fn);
+}
+
+std::map<std::string, StudentStat> ExternalStore::aggregate() const {
+    // Слияние идёт по ID студента, поэтому статистика студента собирается
+    // целиком, прежде чем начнётся следующий
+    std::map<std::string, StudentStat> stats;
+    StudentStat current;
+    uint32_t currentId = 0;
+    bool hasCurrent = false;
+
+    forEachMerged([&](const Entry& e) {
+        if (!hasCurrent || e.student != currentId) {
+            if (hasCurrent) stats[dictionary.name(currentId)] = current;
+            current = StudentStat{};
+            currentId = e.student;
+            hasCurrent = true;
+        }
+        current.absorb(e.epoch, static_cast<EventType>(e.type));
+    });
+
+    if (hasCurrent) stats[dictionary.name(currentId)] = current;
+    return stats;
+}
+
+std::vector<AttendanceRecord> ExternalStore::studentRecords(const std::string& name) const {
+    std::vector<AttendanceRecord> result;
+    // Промах — сразу, без чтения прогонов
+    uint32_t id = dictionary.find(name);
+    if (id == StudentDictionary::NOT_FOUND) return result;
+
+    forEachMerged([&](const Entry& e) {
+        if (e.student != id) return;
+        AttendanceRecord rec;
+        rec.student = name;
+        rec.epoch = e.epoch;
+        rec.type = static_cast<EventType>(e.type);
+        rec.timestamp = AttendanceRecord::formatTimestamp(e.epoch);
+        result.push_back(std::move(rec));
+    });
+
+    return result;
+}
\ No newline at end of file
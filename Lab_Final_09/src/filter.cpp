@@ -0,0 +1,453 @@
+﻿#include "../include/filter.hpp"
+#include "../include/thread_pool.hpp"
+#include "../include/kernels.hpp"
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+namespace filter {
+
+    // --- Lexer ---
+
+    enum class TokenKind { Word, String, Op, LParen, RParen, End };
+
+    struct Token {
+        TokenKind kind;
+        std::string text;
+        size_t pos;
+    };
+
+    static bool isOpChar(char c) {
+        return c == '=' || c == '!' || c == '<' || c == '>' || c == '~';
+    }
+
+    static std::vector<Token> tokenize(const std::string& s) {
+        std::vector<Token> tokens;
+        size_t i = 0;
+
+        while (i < s.size()) {
+            char c = s[i];
+            if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+                i++;
+                continue;
+            }
+
+            size_t start = i;
+            if (c == '(' || c == ')') {
+                tokens.push_back({ c == '(' ? TokenKind::LParen : TokenKind::RParen, std::string(1, c), start });
+                i++;
+            }
+            else if (c == '"') {
+                std::string value;
+                i++;
+                while (i < s.size() && s[i] != '"') {
+                    if (s[i] == '\\' && i + 1 < s.size()) i++;
+                    value += s[i++];
+                }
+                if (i >= s.size()) {
+                    throw std::invalid_argument("Unterminated string at position " + std::to_string(start));
+                }
+                i++;
+                tokens.push_back({ TokenKind::String, std::move(value), start });
+            }
+            else if (isOpChar(c)) {
+                while (i < s.size() && isOpChar(s[i])) i++;
+                tokens.push_back({ TokenKind::Op, s.substr(start, i - start), start });
+            }
+            else {
+                while (i < s.size() && !isOpChar(s[i]) && s[i] != '(' && s[i] != ')' && s[i] != '"'
+                    && s[i] != ' ' && s[i] != '\t' && s[i] != '\r' && s[i] != '\n') {
+                    i++;
+                }
+                tokens.push_back({ TokenKind::Word, s.substr(start, i - start), start });
+            }
+        }
+
+        tokens.push_back({ TokenKind::End, "", s.size() });
+        return tokens;
+    }
+
+    static std::string lower(std::string s) {
+        for (char& c : s) {
+            if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+        }
+        return s;
+    }
+
+    // --- Parser ---
+
+    using Dnf = std::vector<std::vector<Condition>>;
+
+    // Предел числа термов после раскрытия скобок
+    static const size_t MAX_TERMS = 256;
+
+    class Parser {
+    public:
+        explicit Parser(const std::string& text) : tokens(tokenize(text)) {}
+
+        Dnf parseAll() {
+            Dnf result = parseOr();
+            if (peek().kind != TokenKind::End) fail("unexpected '" + peek().text + "'");
+            return result;
+        }
+
+    private:
+        std::vector<Token> tokens;
+        size_t at = 0;
+
+        const Token& peek() const { return tokens[at]; }
+        const Token& next() { return tokens[at < tokens.size() - 1 ? at++ : at]; }
+
+        [[noreturn]] void fail(const std::string& what) const {
+            throw std::invalid_argument("Filter syntax error at position "
+                + std::to_string(peek().pos) + ": " + what);
+        }
+
+        bool acceptKeyword(const char* word) {
+            if (peek().kind == TokenKind::Word && lower(peek().text) == word) {
+                at++;
+                return true;
+            }
+            return false;
+        }
+
+        Dnf parseOr() {
+            Dnf result = parseAnd();
+            while (acceptKeyword("or")) {
+                Dnf rhs = parseAnd();
+                result.insert(result.end(), rhs.begin(), rhs.end());
+                if (result.size() > MAX_TERMS) fail("expression too complex");
+            }
+            return result;
+        }
+
+        // (a or b) and (c or d) раскрывается в ac, ad, bc, bd
+        Dnf parseAnd() {
+            Dnf result = parsePrimary();
+            while (acceptKeyword("and")) {
+                Dnf rhs = parsePrimary();
+                if (result.size() * rhs.size() > MAX_TERMS) fail("expression too complex");
+
+                Dnf product;
+                product.reserve(result.size() * rhs.size());
+                for (const auto& left : result) {
+                    for (const auto& right : rhs) {
+                        auto term = left;
+                        term.insert(term.end(), right.begin(), right.end());
+                        product.push_back(std::move(term));
+                    }
+                }
+                result = std::move(product);
+            }
+            return result;
+        }
+
+        Dnf parsePrimary() {
+            if (peek().kind == TokenKind::LParen) {
+                next();
+                Dnf inner = parseOr();
+                if (peek().kind != TokenKind::RParen) fail("expected ')'");
+                next();
+                return inner;
+            }
+            return { { parseCondition() } };
+        }
+
+        Condition parseCondition() {
+            if (peek().kind != TokenKind::Word) fail("expected field name");
+            std::string name = lower(next().text);
+
+            Field field;
+            if (name == "type") field = Field::Type;
+            else if (name == "ts" || name == "time") field = Field::Time;
+            else if (name == "student" || name == "name") field = Field::Student;
+            else {
+                at--;
+                fail("unknown field '" + name + "' (type, ts, student)");
+            }
+
+            if (peek().kind != TokenKind::Op) fail("expected operator");
+            std::string opText = peek().text;
+            Op op;
+            if (opText == "=" || opText == "==") op = Op::Eq;
+            else if (opText == "!=") op = Op::Ne;
+            else if (opText == "<") op = Op::Lt;
+            else if (opText == "<=") op = Op::Le;
+            else if (opText == ">") op = Op::Gt;
+            else if (opText == ">=") op = Op::Ge;
+            else if (opText == "~") op = Op::Contains;
+            else fail("unknown operator '" + opText + "'");
+
+            bool ordered = op == Op::Lt || op == Op::Le || op == Op::Gt || op == Op::Ge;
+            if ((ordered && field != Field::Time) || (op == Op::Contains && field != Field::Student)) {
+                fail("operator '" + opText + "' is not supported for field '" + name + "'");
+            }
+            next();
+
+            if (peek().kind != TokenKind::Word && peek().kind != TokenKind::String) fail("expected value");
+            std::string value = next().text;
+
+            if (field == Field::Type && AttendanceManager::strToType(lower(value)) == EventType::UNKNOWN) {
+                at--;
+                fail("unknown event type '" + value + "' (in, out, absence)");
+            }
+            if (field == Field::Time && AttendanceManager::parseDateBound(value, false) == 0) {
+                at--;
+                fail("invalid date '" + value + "'");
+            }
+
+            return { field, op, field == Field::Type ? lower(value) : value };
+        }
+    };
+
+    Expression Expression::parse(const std::string& text) {
+        Expression expr;
+        expr.source = text;
+        expr.dnf = Parser(text).parseAll();
+        return expr;
+    }
+
+    // --- Compilation ---
+
+    bool Conjunct::empty() const {
+        if (typeMask == 0 || from > to) return true;
+        if (studentMode == StudentMode::Set) {
+            return std::find(studentAllowed.begin(), studentAllowed.end(), 1) == studentAllowed.end();
+        }
+        return false;
+    }
+
+    // Студенты, допустимые условием (по номерам словаря)
+    static std::vector<uint8_t> studentSet(const Condition& cond, const StudentDictionary& dict) {
+        std::vector<uint8_t> allowed(dict.size(), 0);
+        if (cond.op == Op::Contains) {
+            for (uint32_t id = 0; id < dict.size(); ++id) {
+                allowed[id] = dict.name(id).find(cond.value) != std::string::npos;
+            }
+            return allowed;
+        }
+
+        uint32_t id = dict.find(cond.value);
+        if (cond.op == Op::Ne) {
+            std::fill(allowed.begin(), allowed.end(), 1);
+            if (id != StudentDictionary::NOT_FOUND) allowed[id] = 0;
+        }
+        else if (id != StudentDictionary::NOT_FOUND) {
+            allowed[id] = 1;
+        }
+        return allowed;
+    }
+
+    static void restrictStudents(Conjunct& c, const Condition& cond, const StudentDictionary& dict) {
+        using Mode = Conjunct::StudentMode;
+
+        if (cond.op == Op::Eq && c.studentMode == Mode::Any) {
+            uint32_t id = dict.find(cond.value);
+            if (id == StudentDictionary::NOT_FOUND) {
+                c.studentMode = Mode::Set;
+                c.studentAllowed.assign(dict.size(), 0);
+            }
+            else {
+                c.studentMode = Mode::One;
+                c.studentId = id;
+            }
+            return;
+        }
+
+        std::vector<uint8_t> allowed = studentSet(cond, dict);
+        if (c.studentMode == Mode::One) {
+            uint32_t id = c.studentId;
+            c.studentAllowed.assign(dict.size(), 0);
+            c.studentAllowed[id] = allowed[id];
+            c.studentMode = Mode::Set;
+        }
+        else if (c.studentMode == Mode::Set) {
+            for (size_t i = 0; i < allowed.size(); ++i) c.studentAllowed[i] &= allowed[i];
+        }
+        else {
+            c.studentAllowed = std::move(allowed);
+            c.studentMode = Mode::Set;
+        }
+    }
+
+    // Применить условие к конъюнкции; ts!=D делит её на "до" и "после"
+    static void apply(std::vector<Conjunct>& out, const Condition& cond, const StudentDictionary& dict) {
+        if (cond.field == Field::Type) {
+            uint8_t bit = static_cast<uint8_t>(1u << static_cast<int>(AttendanceManager::strToType(cond.value)));
+            for (auto& c : out) {
+                c.typeMask &= cond.op == Op::Eq ? bit : static_cast<uint8_t>(~bit & 0x0F);
+            }
+            return;
+        }
+
+        if (cond.field == Field::Student) {
+            for (auto& c : out) restrictStudents(c, cond, dict);
+            return;
+        }
+
+        // Для даты без времени — весь день, для полной метки — одна секунда
+        long long first = AttendanceManager::parseDateBound(cond.value, false);
+        long long last = AttendanceManager::parseDateBound(cond.value, true);
+
+        if (cond.op == Op::Ne) {
+            std::vector<Conjunct> split;
+            split.reserve(out.size() * 2);
+            for (const auto& c : out) {
+                Conjunct before = c;
+                before.to = std::min(before.to, first - 1);
+                Conjunct after = c;
+                after.from = std::max(after.from, last + 1);
+                split.push_back(std::move(before));
+                split.push_back(std::move(after));
+            }
+            out = std::move(split);
+            return;
+        }
+
+        for (auto& c : out) {
+            switch (cond.op) {
+            case Op::Eq: c.from = std::max(c.from, first); c.to = std::min(c.to, last); break;
+            case Op::Lt: c.to = std::min(c.to, first - 1); break;
+            case Op::Le: c.to = std::min(c.to, last); break;
+            case Op::Gt: c.from = std::max(c.from, last + 1); break;
+            case Op::Ge: c.from = std::max(c.from, first); break;
+            default: break;
+            }
+        }
+    }
+
+    Predicate::Predicate(const Expression& expr, const StudentDictionary& dict) {
+        for (const auto& term : expr.terms()) {
+            std::vector<Conjunct> compiled(1);
+            for (const auto& cond : term) apply(compiled, cond, dict);
+            for (auto& c : compiled) {
+                if (!c.empty()) parts.push_back(std::move(c));
+            }
+        }
+    }
+
+    // --- Kernels ---
+    // Индекс пишется всегда, счётчик сдвигается на результат сравнения:
+    // в цикле нет ветвлений, зависящих от данных
+
+    using Mode = Conjunct::StudentMode;
+
+    template <bool ByType, bool ByTime, Mode Students>
+    static size_t scanChunk(const Conjunct& c, const RecordColumns& cols,
+        size_t lo, size_t hi, uint32_t* out) {
+        const uint8_t* types = cols.types.data();
+        const long long* epochs = cols.epochs.data();
+        const uint32_t* students = cols.students.data();
+        const uint8_t* allowed = c.studentAllowed.data();
+        const uint8_t mask = c.typeMask;
+        const uint64_t from = static_cast<uint64_t>(c.from);
+        const uint64_t span = static_cast<uint64_t>(c.to) - from;
+        const uint32_t id = c.studentId;
+
+        size_t n = 0;
+        for (size_t i = lo; i < hi; ++i) {
+            unsigned keep = 1;
+            if constexpr (ByType) keep &= (mask >> types[i]) & 1u;
+            // from <= e <= to одним беззнаковым сравнением
+            if constexpr (ByTime) keep &= (static_cast<uint64_t>(epochs[i]) - from) <= span;
+            if constexpr (Students == Mode::One) keep &= students[i] == id;
+            if constexpr (Students == Mode::Set) keep &= allowed[students[i]];
+            out[n] = static_cast<uint32_t>(i);
+            n += keep;
+        }
+        return n;
+    }
+
+    // Условие только на один тип: сравнение векторным ядром в битовую маску,
+    // затем индексы установленных битов
+    static size_t scanOneType(const Conjunct& c, const RecordColumns& cols,
+        size_t lo, size_t hi, uint32_t* out) {
+        thread_local std::vector<uint64_t> bits;
+        bits.resize((hi - lo + 63) / 64);
+        const uint8_t value = static_cast<uint8_t>(std::countr_zero(c.typeMask));
+        kernels::selectBitmap(cols.types.data() + lo, hi - lo, value, bits.data());
+
+        size_t n = 0;
+        for (size_t w = 0; w < bits.size(); ++w) {
+            for (uint64_t word = bits[w]; word != 0; word &= word - 1) {
+                out[n++] = static_cast<uint32_t>(lo + w * 64 + std::countr_zero(word));
+            }
+        }
+        return n;
+    }
+
+    using ScanFn = size_t(*)(const Conjunct&, const RecordColumns&, size_t, size_t, uint32_t*);
+
+    template <bool ByType, bool ByTime>
+    static ScanFn pickByStudents(Mode mode) {
+        switch (mode) {
+        case Mode::One: return scanChunk<ByType, ByTime, Mode::One>;
+        case Mode::Set: return scanChunk<ByType, ByTime, Mode::Set>;
+        default: return scanChunk<ByType, ByTime, Mode::Any>;
+        }
+    }
+
+    // Экземпляр без лишних проверок: условия, не сужающие выборку, не компилируются
+    static ScanFn pickKernel(const Conjunct& c) {
+        bool byType = c.typeMask != 0x0F;
+        bool byTime = c.from != LLONG_MIN || c.to != LLONG_MAX;
+        if (byType && !byTime && c.studentMode == Mode::Any && std::has_single_bit(c.typeMask)) {
+            return scanOneType;
+        }
+        if (byType && byTime) return pickByStudents<true, true>(c.studentMode);
+        if (byType) return pickByStudents<true, false>(c.studentMode);
+        if (byTime) return pickByStudents<false, true>(c.studentMode);
+        return pickByStudents<false, false>(c.studentMode);
+    }
+
+    std::vector<uint32_t> Predicate::select(const RecordColumns& cols) const {
+        const size_t n = cols.types.size();
+        if (parts.empty() || n == 0) return {};
+
+        std::vector<ScanFn> kernels;
+        kernels.reserve(parts.size());
+        for (const auto& c : parts) kernels.push_back(pickKernel(c));
+
+        // Куски обрабатываются параллельно, выборки склеиваются по порядку
+        const size_t chunkSize = 65536;
+        size_t chunkCount = (n + chunkSize - 1) / chunkSize;
+        std::vector<std::vector<uint32_t>> partial(chunkCount);
+
+        ThreadPool::instance().parallelFor(0, chunkCount, 1, [&](size_t lo, size_t hi) {
+            std::vector<uint32_t> scratch;
+            std::vector<uint8_t> hit;
+            for (size_t chunk = lo; chunk < hi; ++chunk) {
+                size_t begin = chunk * chunkSize;
+                size_t end = std::min(n, begin + chunkSize);
+                auto& sel = partial[chunk];
+                sel.resize(end - begin);
+
+                if (kernels.size() == 1) {
+                    sel.resize(kernels[0](parts[0], cols, begin, end, sel.data()));
+                    continue;
+                }
+
+                // Несколько термов: объединение через байтовую маску куска
+                hit.assign(end - begin, 0);
+                scratch.resize(end - begin);
+                for (size_t k = 0; k < kernels.size(); ++k) {
+                    size_t found = kernels[k](parts[k], cols, begin, end, scratch.data());
+                    for (size_t j = 0; j < found; ++j) hit[scratch[j] - begin] = 1;
+                }
+                size_t count = 0;
+                for (size_t j = 0; j < hit.size(); ++j) {
+                    sel[count] = static_cast<uint32_t>(begin + j);
+                    count += hit[j];
+                }
+                sel.resize(count);
+            }
+        });
+
+        size_t total = 0;
+        for (const auto& sel : partial) total += sel.size();
+        std::vector<uint32_t> result;
+        result.reserve(total);
+        for (const auto& sel : partial) result.insert(result.end(), sel.begin(), sel.end());
+        return result;
+    }
+}
\ No newline at end of file
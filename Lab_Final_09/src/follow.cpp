@@ -0,0 +1,117 @@
+﻿#include "../include/follow.hpp"
+#include "../include/record_stream.hpp"
+#include "../include/utils.hpp"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace follow {
+
+    static std::atomic<bool> interrupted{ false };
+
+    static void onInterrupt(int) {
+        interrupted = true;
+    }
+
+    Stats run(AttendanceManager& manager, const std::string& filename, int pollMs) {
+        std::string path = utils::getPath(filename);
+        std::ifstream in(path, std::ios::in | std::ios::binary);
+        if (!in.is_open()) throw std::runtime_error("Cannot open file: " + path);
+
+        interrupted = false;
+        auto previous = std::signal(SIGINT, onInterrupt);
+
+        Stats stats;
+        ObjectSplitter splitter;
+        std::vector<char> block(1 << 20);
+        std::string objectText;
+        std::vector<AttendanceRecord> batch;
+
+        std::cout << "Слежение за " << path << " (Ctrl+C — выход)\n";
+
+        // Разобрать полностью полученные объекты и добавить их одной пачкой.
+        // Ошибки разбора считаются; первая в пачке печатается в stderr
+        auto drain = [&]() {
+            size_t parsed = 0;
+            std::string firstError;
+            while (splitter.nextObject(objectText)) {
+                parsed++;
+                try {
+                    json::Value value = json::Parser::parse(objectText);
+                    batch.push_back(AttendanceManager::recordFromJson(value.asObject()));
+                }
+                catch (const std::exception& e) {
+                    stats.malformed++;
+                    if (firstError.empty()) firstError = e.what();
+                }
+            }
+            if (!firstError.empty()) {
+                std::cerr << "[follow] Объект не разобран: " << firstError << "\n";
+            }
+
+            size_t duplicatesBefore = manager.duplicateCount();
+            size_t accepted = manager.appendRecords(std::move(batch));
+            batch.clear();
+            stats.accepted += accepted;
+            stats.rejected += parsed - accepted;
+            stats.duplicates += manager.duplicateCount() - duplicatesBefore;
+            return parsed;
+        };
+
+        while (!interrupted) {
+            // Новые байты дочитываются блоками; неполный объект в конце
+            // остаётся в splitter до следующей порции
+            size_t acceptedBefore = stats.accepted;
+            size_t rejectedBefore = stats.rejected;
+            size_t malformedBefore = stats.malformed;
+            size_t duplicatesBefore = stats.duplicates;
+            size_t parsed = 0;
+            size_t got = 0;
+            do {
+                in.read(block.data(), static_cast<std::streamsize>(block.size()));
+                got = static_cast<size_t>(in.gcount());
+                if (got > 0) {
+                    stats.bytes += got;
+                    splitter.feed(block.data(), got);
+                    parsed += drain();
+                }
+            } while (got == block.size() && !interrupted);
+
+            if (parsed > 0) {
+                stats.batches++;
+                StudentStat total = manager.totalStats();
+                std::cout << "[follow] +" << (stats.accepted - acceptedBefore)
+                    << " событий (отброшено " << (stats.rejected - rejectedBefore)
+                    << ", из них не разобрано " << (stats.malformed - malformedBefore)
+                    << ", повторов " << (stats.duplicates - duplicatesBefore)
+                    << "), всего " << manager.recordCount()
+                    << ", прогулов " << total.absences
+                    << ", часов " << total.hoursPresent << "\n";
+            }
+
+            // Конец файла сбрасывает флаги потока, чтобы читать дописанное.
+            // Если файл укоротили (ротация), читаем его заново с начала.
+            in.clear();
+            std::error_code ec;
+            auto size = std::filesystem::file_size(path, ec);
+            if (!ec && size < stats.bytes) {
+                std::cout << "[follow] Файл укорочен, чтение с начала\n";
+                in.seekg(0);
+                stats.bytes = 0;
+                splitter = ObjectSplitter();
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(pollMs));
+        }
+
+        std::signal(SIGINT, previous);
+        std::cout << "\nСлежение остановлено: принято " << stats.accepted
+            << ", отброшено " << stats.rejected << " (не разобрано " << stats.malformed
+            << ", повторов " << stats.duplicates << "), прочитано " << stats.bytes << " байт\n";
+        return stats;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+﻿#include "../include/group_by.hpp"
+#include <ctime>
+#include <sstream>
+
+namespace groupby {
+
+    bool parseKeys(const std::string& s, unsigned& mask) {
+        mask = 0;
+        std::stringstream ss(s);
+        std::string part;
+        while (std::getline(ss, part, ',')) {
+            if (part == "student") mask |= Student;
+            else if (part == "day") mask |= Day;
+            else if (part == "hour") mask |= Hour;
+            else if (part == "type") mask |= Type;
+            else return false;
+        }
+        return mask != 0;
+    }
+
+    static std::tm localTime(long long epoch) {
+        std::time_t t = static_cast<std::time_t>(epoch);
+        std::tm tm = {};
+#ifdef _WIN32
+        localtime_s(&tm, &t);
+#else
+        localtime_r(&t, &tm);
+#endif
+        return tm;
+    }
+
+    // Местная полночь суток tm, сдвинутых на shift дней
+    static long long localMidnight(std::tm tm, int shift) {
+        tm.tm_mday += shift;
+        tm.tm_hour = 0;
+        tm.tm_min = 0;
+        tm.tm_sec = 0;
+        tm.tm_isdst = -1;
+        return static_cast<long long>(std::mktime(&tm));
+    }
+
+    void Calendar::split(long long epoch, uint32_t& day, uint32_t& hour) {
+        if (epoch < dayStart || epoch >= dayEnd) {
+            std::tm tm = localTime(epoch);
+            dayStart = localMidnight(tm, 0);
+            dayEnd = localMidnight(tm, 1);
+            uniform = dayEnd - dayStart == 24 * 3600;
+            // mktime не смог: кэшируется только эта метка, час — из localtime
+            if (dayStart == -1 || dayStart > epoch || dayEnd <= epoch) {
+                dayStart = epoch;
+                dayEnd = epoch + 1;
+                uniform = false;
+            }
+            dayKey = static_cast<uint32_t>(((tm.tm_year + 1900) * 100 + tm.tm_mon + 1) * 100 + tm.tm_mday);
+        }
+
+        day = dayKey;
+        if (!uniform) {
+            hour = static_cast<uint32_t>(localTime(epoch).tm_hour);
+            return;
+        }
+        long long h = (epoch - dayStart) / 3600;
+        hour = static_cast<uint32_t>(h > 23 ? 23 : h);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+﻿#include "../include/heatmap.hpp"
+#include "../include/kernels.hpp"
+#include "../include/thread_pool.hpp"
+#include <algorithm>
+#include <ctime>
+#include <mutex>
+#include <stdexcept>
+
+namespace heatmap {
+
+    // 8M интервалов по 15 минут — около 240 лет
+    static constexpr size_t MAX_SLOTS = size_t(1) << 23;
+    static constexpr long long DAY_SECONDS = 86400;
+
+    static long long floorDiv(long long a, long long b) {
+        long long q = a / b;
+        return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+    }
+
+    // Номер суток от 1970-01-01 для даты григорианского календаря
+    static long long daysFromCivil(long long y, unsigned m, unsigned d) {
+        y -= m <= 2;
+        long long era = floorDiv(y, 400);
+        unsigned yoe = static_cast<unsigned>(y - era * 400);
+        unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<long long>(doe) - 719468;
+    }
+
+    // Смещение местного времени от UTC в момент epoch, секунд
+    static long long localOffset(long long epoch) {
+        std::time_t t = static_cast<std::time_t>(epoch);
+        std::tm tm = {};
+#ifdef _WIN32
+        localtime_s(&tm, &t);
+#else
+        localtime_r(&t, &tm);
+#endif
+        long long local = daysFromCivil(tm.tm_year + 1900LL, static_cast<unsigned>(tm.tm_mon + 1),
+            static_cast<unsigned>(tm.tm_mday)) * DAY_SECONDS
+            + tm.tm_hour * 3600LL + tm.tm_min * 60LL + tm.tm_sec;
+        return local - epoch;
+    }
+
+    // --- SlotTable ---
+
+    SlotTable::SlotTable(long long from, long long to) {
+        const long long slot = kernels::SLOT_SECONDS;
+        start = floorDiv(from, slot) * slot;
+        unsigned long long span = to >= start ? static_cast<unsigned long long>(to - start) / slot + 1 : 1;
+        if (span > MAX_SLOTS) throw std::runtime_error("Time range is too wide for a heatmap");
+        bins.resize(static_cast<size_t>(span));
+
+        // Смещение берётся на границах суток; если за сутки оно изменилось
+        // (переход на летнее время), эти сутки пересчитываются по интервалам
+        const size_t perDay = static_cast<size_t>(DAY_SECONDS / slot);
+        long long offset = localOffset(start);
+        for (size_t s = 0; s < bins.size(); s += perDay) {
+            size_t end = std::min(s + perDay, bins.size());
+            long long next = localOffset(start + static_cast<long long>(end - 1) * slot);
+            bool uniform = next == offset;
+
+            for (size_t k = s; k < end; ++k) {
+                long long t = start + static_cast<long long>(k) * slot;
+                long long local = t + (uniform ? offset : localOffset(t));
+                long long day = floorDiv(local, DAY_SECONDS);
+                long long hour = (local - day * DAY_SECONDS) / 3600;
+                // 1970-01-01 — четверг (3, если понедельник — 0)
+                long long weekday = (day % 7 + 7 + 3) % 7;
+                bins[k] = static_cast<uint8_t>(weekday * HOURS + hour);
+            }
+            offset = next;
+        }
+    }
+
+    // --- Build ---
+
+    Grid build(const long long* epochs, const uint8_t* types, const uint32_t* students, size_t n,
+        const SlotTable& table, uint32_t student) {
+        const uint8_t in = static_cast<uint8_t>(EventType::IN);
+        const uint32_t* filter = student == ALL_STUDENTS ? nullptr : students;
+
+        std::mutex mergeMutex;
+        uint64_t merged[DAYS * HOURS] = {};
+        ThreadPool::instance().parallelFor(0, n, 1 << 16, [&](size_t lo, size_t hi) {
+            uint64_t local[DAYS * HOURS] = {};
+            kernels::histogramBySlot(epochs + lo, types + lo, filter ? filter + lo : nullptr, hi - lo,
+                in, student, table.base(), table.data(), table.size(), local, DAYS * HOURS);
+
+            std::lock_guard<std::mutex> lock(mergeMutex);
+            for (size_t b = 0; b < DAYS * HOURS; ++b) merged[b] += local[b];
+        });
+
+        Grid grid;
+        for (size_t b = 0; b < DAYS * HOURS; ++b) {
+            grid.counts[b / HOURS][b % HOURS] = merged[b];
+            grid.total += merged[b];
+        }
+        return grid;
+    }
+
+    Grid build(const RecordColumns& cols, uint32_t student) {
+        if (cols.epochs.empty()) return {};
+        SlotTable table(cols.minEpoch, cols.maxEpoch);
+        return build(cols.epochs.data(), cols.types.data(), cols.students.data(), cols.epochs.size(),
+            table, student);
+    }
+}
\ No newline at end of file
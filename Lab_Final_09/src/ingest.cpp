@@ -0,0 +1,226 @@
+﻿#include "../include/ingest.hpp"
+#include "../include/utils.hpp"
+#include "../include/thread_pool.hpp"
+#include "../include/record_stream.hpp"
+#include "../include/columnar_store.hpp"
+#include <iostream>
+#include <algorithm>
+#include <queue>
+#include <chrono>
+
+namespace ingest {
+
+    // Сравнение имени файла с шаблоном ('*' — любая подстрока, '?' — один байт)
+    static bool wildcardMatch(const std::string& name, const std::string& pattern) {
+        size_t n = 0, p = 0;
+        size_t starP = std::string::npos, starN = 0;
+
+        while (n < name.size()) {
+            if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+                n++;
+                p++;
+            }
+            else if (p < pattern.size() && pattern[p] == '*') {
+                starP = p++;
+                starN = n;
+            }
+            else if (starP != std::string::npos) {
+                p = starP + 1;
+                n = ++starN;
+            }
+            else {
+                return false;
+            }
+        }
+
+        while (p < pattern.size() && pattern[p] == '*') p++;
+        return p == pattern.size();
+    }
+
+    static bool isDataFile(const std::filesystem::path& p) {
+        auto ext = p.extension().string();
+        return ext == ".json" || ext == ".ndjson" || ext == ".atc";
+    }
+
+    bool isNdjson(const std::string& path) {
+        return std::filesystem::path(path).extension() == ".ndjson";
+    }
+
+    bool isColumnar(const std::string& path) {
+        return std::filesystem::path(path).extension() == ".atc";
+    }
+
+    static bool hasWildcard(const std::string& s) {
+        return s.find_first_of("*?") != std::string::npos;
+    }
+
+    bool isMultiInput(const std::vector<std::string>& inputs) {
+        if (inputs.size() != 1) return true;
+        const std::string& only = inputs.front();
+        return hasWildcard(only) || std::filesystem::is_directory(utils::getPath(only));
+    }
+
+    std::vector<std::string> expandInputs(const std::vector<std::string>& inputs) {
+        std::vector<std::string> paths;
+
+        for (const auto& input : inputs) {
+            std::filesystem::path full = utils::getPath(input);
+
+            if (hasWildcard(input)) {
+                std::filesystem::path dir = full.parent_path();
+                std::string pattern = full.filename().string();
+                if (dir.empty()) dir = ".";
+                if (!std::filesystem::is_directory(dir)) continue;
+
+                std::vector<std::string> matched;
+                for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+                    if (entry.is_regular_file() && wildcardMatch(entry.path().filename().string(), pattern)) {
+                        matched.push_back(entry.path().string());
+                    }
+                }
+                std::sort(matched.begin(), matched.end());
+                paths.insert(paths.end(), matched.begin(), matched.end());
+            }
+            else if (std::filesystem::is_directory(full)) {
+                std::vector<std::string> matched;
+                for (const auto& entry : std::filesystem::directory_iterator(full)) {
+                    if (entry.is_regular_file() && isDataFile(entry.path())) {
+                        matched.push_back(entry.path().string());
+                    }
+                }
+                std::sort(matched.begin(), matched.end());
+                paths.insert(paths.end(), matched.begin(), matched.end());
+            }
+            else {
+                paths.push_back(full.string());
+            }
+        }
+
+        return paths;
+    }
+
+    static void parseOne(FileResult& result) {
+        auto start = std::chrono::high_resolution_clock::now();
+        try {
+            if (isColumnar(result.path)) {
+                result.records = columnar::load(result.path);
+            }
+            else if (isNdjson(result.path)) {
+                RecordStreamReader reader(result.path);
+                AttendanceRecord rec;
+                while (reader.next(rec)) result.records.push_back(std::move(rec));
+            }
+            else {
+                std::string content = utils::readFile(result.path);
+                json::Value root = json::Parser::parse(content);
+                content.clear();
+                content.shrink_to_fit();
+
+                result.records = AttendanceManager::recordsFromJson(root);
+            }
+            std::stable_sort(result.records.begin(), result.records.end(),
+                [](const AttendanceRecord& a, const AttendanceRecord& b) {
+                    if (a.student != b.student) return a.student < b.student;
+                    return a.epoch < b.epoch;
+                });
+        }
+        catch (const std::exception& e) {
+            result.records.clear();
+            result.error = e.what();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        result.millis = std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    std::vector<FileResult> parseFiles(const std::vector<std::string>& paths) {
+        std::vector<FileResult> results(paths.size());
+        for (size_t i = 0; i < paths.size(); ++i) {
+            results[i].path = paths[i];
+        }
+
+        ThreadPool::instance().parallelFor(0, results.size(), 1, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) {
+                parseOne(results[i]);
+            }
+        });
+
+        return results;
+    }
+
+    std::vector<AttendanceRecord> mergeSorted(std::vector<FileResult>& results) {
+        struct Cursor {
+            size_t file;
+            size_t pos;
+        };
+
+        auto later = [&results](const Cursor& a, const Cursor& b) {
+            const auto& ra = results[a.file].records[a.pos];
+            const auto& rb = results[b.file].records[b.pos];
+            if (ra.student != rb.student) return ra.student > rb.student;
+            if (ra.epoch != rb.epoch) return ra.epoch > rb.epoch;
+            return a.file > b.file;
+        };
+
+        size_t total = 0;
+        std::priority_queue<Cursor, std::vector<Cursor>, decltype(later)> heap(later);
+        for (size_t f = 0; f < results.size(); ++f) {
+            total += results[f].records.size();
+            if (!results[f].records.empty()) heap.push({ f, 0 });
+        }
+
+        std::vector<AttendanceRecord> merged;
+        merged.reserve(total);
+
+        while (!heap.empty()) {
+            Cursor c = heap.top();
+            heap.pop();
+            merged.push_back(std::move(results[c.file].records[c.pos]));
+            if (++c.pos < results[c.file].records.size()) heap.push(c);
+        }
+
+        for (auto& r : results) {
+            r.records.clear();
+            r.records.shrink_to_fit();
+        }
+
+        return merged;
+    }
+
+    Summary loadInto(AttendanceManager& manager, const std::vector<std::string>& inputs) {
+        auto start = std::chrono::high_resolution_clock::now();
+        Summary summary;
+
+        auto paths = expandInputs(inputs);
+        summary.filesTotal = paths.size();
+        if (paths.empty()) {
+            throw std::runtime_error("No input files matched");
+        }
+
+        std::cout << "Файлов к загрузке: " << paths.size() << "\n";
+        auto results = parseFiles(paths);
+
+        for (const auto& r : results) {
+            if (!r.error.empty()) {
+                summary.filesFailed++;
+                std::cerr << "Ошибка в файле " << r.path << ": " << r.error << "\n";
+            }
+        }
+
+        if (summary.filesFailed == summary.filesTotal) {
+            throw std::runtime_error("None of the input files could be loaded");
+        }
+
+        auto merged = mergeSorted(results);
+        summary.recordsLoaded = merged.size();
+
+        manager.loadRecords(std::move(merged));
+        manager.validateData();
+
+        auto end = std::chrono::high_resolution_clock::now();
+        summary.millis = std::chrono::duration<double, std::milli>(end - start).count();
+
+        std::cout << "Загружено файлов: " << (summary.filesTotal - summary.filesFailed)
+            << " из " << summary.filesTotal << " за " << summary.millis << " мс\n";
+        return summary;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,196 @@
+﻿#include "../include/kernels.hpp"
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define KERNELS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(KERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+namespace kernels {
+
+    // --- Scalar ---
+
+    static void selectBitmapScalar(const uint8_t* types, size_t n, uint8_t value, uint64_t* bits) {
+        size_t words = (n + 63) / 64;
+        for (size_t w = 0; w < words; ++w) {
+            uint64_t word = 0;
+            size_t base = w * 64;
+            size_t limit = (n - base < 64) ? n - base : 64;
+            for (size_t j = 0; j < limit; ++j) {
+                word |= static_cast<uint64_t>(types[base + j] == value) << j;
+            }
+            bits[w] = word;
+        }
+    }
+
+#ifdef KERNELS_X86
+
+    // --- SSE2 ---
+    // Сравнение даёт 0xFF на совпадениях, movemask собирает старшие биты байтов
+
+    static void selectBitmapSse2(const uint8_t* types, size_t n, uint8_t value, uint64_t* bits) {
+        const __m128i needle = _mm_set1_epi8(static_cast<char>(value));
+        size_t full = n / 64;
+
+        for (size_t w = 0; w < full; ++w) {
+            const uint8_t* p = types + w * 64;
+            uint64_t word = 0;
+            for (int k = 0; k < 4; ++k) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + k * 16));
+                uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, needle)));
+                word |= static_cast<uint64_t>(mask) << (k * 16);
+            }
+            bits[w] = word;
+        }
+
+        if (full * 64 < n) {
+            selectBitmapScalar(types + full * 64, n - full * 64, value, bits + full);
+        }
+    }
+
+    // --- AVX2 ---
+
+    TARGET_AVX2
+    static void selectBitmapAvx2(const uint8_t* types, size_t n, uint8_t value, uint64_t* bits) {
+        const __m256i needle = _mm256_set1_epi8(static_cast<char>(value));
+        size_t full = n / 64;
+
+        for (size_t w = 0; w < full; ++w) {
+            const uint8_t* p = types + w * 64;
+            __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+            uint32_t maskLo = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, needle)));
+            uint32_t maskHi = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, needle)));
+            bits[w] = static_cast<uint64_t>(maskLo) | (static_cast<uint64_t>(maskHi) << 32);
+        }
+
+        if (full * 64 < n) {
+            selectBitmapScalar(types + full * 64, n - full * 64, value, bits + full);
+        }
+    }
+
+    static bool cpuHasAvx2() {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx) return false;
+        if ((_xgetbv(0) & 0x6) != 0x6) return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+#endif // KERNELS_X86
+
+    // --- Dispatch ---
+
+    Isa detectIsa() {
+#ifdef KERNELS_X86
+        static const Isa best = cpuHasAvx2() ? Isa::AVX2 : Isa::SSE2;
+        return best;
+#else
+        return Isa::Scalar;
+#endif
+    }
+
+    static Isa& currentIsa() {
+        static Isa isa = detectIsa();
+        return isa;
+    }
+
+    Isa activeIsa() {
+        return currentIsa();
+    }
+
+    void setIsa(Isa isa) {
+        // Нельзя включить набор инструкций, которого нет у процессора
+        if (static_cast<int>(isa) > static_cast<int>(detectIsa())) isa = detectIsa();
+        currentIsa() = isa;
+    }
+
+    const char* isaName(Isa isa) {
+        switch (isa) {
+        case Isa::AVX2: return "AVX2";
+        case Isa::SSE2: return "SSE2";
+        default: return "Scalar";
+        }
+    }
+
+    void selectBitmap(const uint8_t* types, size_t n, uint8_t value, uint64_t* bits) {
+#ifdef KERNELS_X86
+        switch (currentIsa()) {
+        case Isa::AVX2: selectBitmapAvx2(types, n, value, bits); return;
+        case Isa::SSE2: selectBitmapSse2(types, n, value, bits); return;
+        default: break;
+        }
+#endif
+        selectBitmapScalar(types, n, value, bits);
+    }
+
+    // --- Histogram ---
+    // Неподходящие элементы идут в лишнюю ячейку binCount, поэтому ветвлений нет.
+    // Четыре копии гистограммы разрывают зависимость между инкрементами одной
+    // ячейки подряд (частый случай: события одного часа идут друг за другом).
+
+    template <bool ByStudent>
+    static void histogramImpl(const long long* epochs, const uint8_t* types, const uint32_t* students,
+        size_t n, uint8_t value, uint32_t student, long long base,
+        const uint8_t* slotBins, size_t slots, uint64_t* bins, size_t binCount) {
+        const size_t stride = binCount + 1;
+        std::vector<uint32_t> lanes(4 * stride, 0);
+
+        auto binOf = [&](size_t i) -> size_t {
+            // Отрицательная разность становится большим беззнаковым и не проходит проверку
+            uint64_t slot = static_cast<uint64_t>(epochs[i] - base) / static_cast<uint64_t>(SLOT_SECONDS);
+            bool inside = slot < slots;
+            bool hit = inside & (types[i] == value);
+            if constexpr (ByStudent) hit = hit & (students[i] == student);
+            size_t bin = slotBins[inside ? slot : 0];
+            return hit ? bin : binCount;
+        };
+
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            lanes[binOf(i)]++;
+            lanes[stride + binOf(i + 1)]++;
+            lanes[2 * stride + binOf(i + 2)]++;
+            lanes[3 * stride + binOf(i + 3)]++;
+        }
+        for (; i < n; ++i) lanes[binOf(i)]++;
+
+        for (size_t b = 0; b < binCount; ++b) {
+            bins[b] += static_cast<uint64_t>(lanes[b]) + lanes[stride + b]
+                + lanes[2 * stride + b] + lanes[3 * stride + b];
+        }
+    }
+
+    void histogramBySlot(const long long* epochs, const uint8_t* types, const uint32_t* students,
+        size_t n, uint8_t value, uint32_t student, long long base,
+        const uint8_t* slotBins, size_t slots, uint64_t* bins, size_t binCount) {
+        if (n == 0 || slots == 0) return;
+        if (students) {
+            histogramImpl<true>(epochs, types, students, n, value, student, base, slotBins, slots, bins, binCount);
+        }
+        else {
+            histogramImpl<false>(epochs, types, nullptr, n, value, student, base, slotBins, slots, bins, binCount);
+        }
+    }
+}
\ No newline at end of file
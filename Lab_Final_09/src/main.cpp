@@ -3,23 +3,151 @@
 #include <vector>
 #include <limits>
 #include <chrono>
+#include <optional>
 #include "../include/simple_json.hpp"
 #include "../include/attendance.hpp"
 #include "../include/utils.hpp"
+#include "../include/query_server.hpp"
+#include "../include/ingest.hpp"
+#include "../include/record_stream.hpp"
+#include "../include/external_sort.hpp"
+#include "../include/pipeline.hpp"
+#include "../include/thread_pool.hpp"
+#include "../include/follow.hpp"
+#include "../include/filter.hpp"
+#include "../include/group_by.hpp"
+#include "../include/student_index.hpp"
+#include "../include/partition_store.hpp"
+#include "../include/columnar_store.hpp"
+#include "../include/sketch.hpp"
+#include "../include/dedup.hpp"
 
 void printHelp() {
     std::cout << "Attendance CLI Tool - Учёт посещаемости\n"
         << "Использование: app [опции]\n\n"
         << "Опции:\n"
         << "  --help              Показать эту справку\n"
-        << "  --input <файл>      Загрузить JSON файл при запуске\n"
+        << "  --input <файлы>     Загрузить JSON файл(ы): пути, каталог или шаблон\n"
         << "  --student <имя>     Показать отчёт для студента и выйти\n"
         << "  --bench             Запустить бенчмарк и выйти\n"
-        << "  --validate-only     Только валидировать данные и выйти\n\n"
+        << "  --bench-threads     Бенчмарк масштабирования на 1/2/4/8/16 потоках\n"
+        << "  --bench-atc         Бенчмарк колоночного снимка (.atc): сжатие и скорость\n"
+        << "  --bench-heatmap     Бенчмарк тепловой карты на 10M событий\n"
+        << "  --threads <N>       Число потоков (по умолчанию — по числу ядер)\n"
+        << "  --validate-only     Только валидировать данные и выйти\n"
+        << "  --serve <сокет>     Режим сервера запросов через Unix-сокет\n"
+        << "  --max-memory <МБ>   Обработка больше памяти: внешняя сортировка\n"
+        << "  --dedup             Отбрасывать повторы событий (тот же студент, время и тип)\n"
+        << "  --dedup-window <ч>  Помнить события только за последние <ч> часов:\n"
+        << "                      память ограничена для --follow и --max-memory\n"
+        << "  --approx            Приближённая статистика потоковым чтением в памяти\n"
+        << "                      фиксированного размера: число студентов (HyperLogLog),\n"
+        << "                      частые прогульщики (Count-Min, их число — --top)\n"
+        << "  --pipeline          Конвейерная загрузка (чтение/парсинг/валидация параллельно)\n"
+        << "  --from <дата>       Начало периода (YYYY-MM-DD или YYYY-MM-DDTHH:MM:SS)\n"
+        << "  --to <дата>         Конец периода (дата без времени — до конца дня)\n"
+        << "  --top <K>           K худших студентов по критерию --by\n"
+        << "  --by <критерий>     absences (больше прогулов), hours (меньше часов),\n"
+        << "                      records (меньше записей); по умолчанию absences\n"
+        << "  --export-reports <каталог>  Отчёты по всем студентам, файл на студента\n"
+        << "  --export-format <f> Формат отчётов: txt (по умолчанию), csv, json\n"
+        << "  --format <f>        Формат таблиц: text (по умолчанию), csv, tsv, json\n"
+        << "                      (кроме text: в stdout только таблица, сообщения — в stderr)\n"
+        << "  --where <условие>   Записи по условию: поля type, ts, student;\n"
+        << "                      операторы = != < <= > >= ~ (подстрока), and, or, скобки\n"
+        << "  --heatmap <имя|all> Тепловая карта входов: день недели × час\n"
+        << "                      (со --format csv/tsv/json — числа по ячейкам)\n"
+        << "  --group-by <ключи>  Группировка: student, day, hour, type через запятую\n"
+        << "                      (вместе с --where — только выбранные записи)\n"
+        << "  --follow            Следить за дописыванием входного файла (JSON/NDJSON)\n"
+        << "  --stats-snapshot <файл>  Сохранить двоичный снимок статистики\n"
+        << "  --stats-from <файл> Статистика со снимка; записи из --input (если есть)\n"
+        << "                      добавляются к событиям снимка\n"
+        << "  --build-index       Построить (обновить) индекс <файл>.idx для быстрых --student\n"
+        << "  --no-index          Не использовать индекс <файл>.idx для --student\n"
+        << "  --partition-out <каталог>  Дописать загруженные записи в хранилище по разделам\n"
+        << "                      (<каталог>/YYYY-MM/part-XX.bin)\n"
+        << "  --save-columnar <файл>  Сохранить сжатый колоночный снимок (.atc);\n"
+        << "                      загружается обратно через --input <файл>.atc\n"
+        << "  --partitions <каталог>  Читать из хранилища по разделам вместо --input;\n"
+        << "                      --student, --from, --to пропускают неподходящие разделы\n\n"
         << "Примеры:\n"
         << "  app --input data.json\n"
         << "  app --input data.json --student \"Иванов И.И.\"\n"
-        << "  app --input data.json --bench\n";
+        << "  app --input data.json --build-index\n"
+        << "  app --input data.json --bench\n"
+        << "  app --input data.json --from 2025-10-01 --to 2025-10-15\n"
+        << "  app --input data.json --top 10 --by hours --format csv\n"
+        << "  app --input data.json --where \"type=absence and ts>=2025-10-01 and student~Иванов\"\n"
+        << "  app --input data.json --where type=absence --group-by day,student\n"
+        << "  app --input data.json --export-reports reports --export-format csv\n"
+        << "  app --input data/2025-10 \"data/extra-*.json\"\n"
+        << "  app --input data/2025-10 --approx --top 10\n"
+        << "  app --input october.json --stats-snapshot stats.bin\n"
+        << "  app --input november.json --stats-from stats.bin\n"
+        << "  app --input data.json --serve /tmp/attendance.sock\n"
+        << "  app --input huge.json --max-memory 64\n"
+        << "  app --input data/2025-10 --partition-out history\n"
+        << "  app --partitions history --from 2025-10-20 --to 2025-10-27\n"
+        << "  app --input turnstile.ndjson --follow\n";
+}
+
+// Ввод границ периода; false, если дата не распознана
+bool parseRange(const std::string& fromStr, const std::string& toStr,
+    long long& from, long long& to) {
+    from = fromStr.empty() ? std::numeric_limits<long long>::min()
+        : AttendanceManager::parseDateBound(fromStr, false);
+    to = toStr.empty() ? std::numeric_limits<long long>::max()
+        : AttendanceManager::parseDateBound(toStr, true);
+
+    if (from == 0 || to == 0) {
+        std::cerr << "Ошибка: неверный формат даты (ожидается YYYY-MM-DD).\n";
+        return false;
+    }
+    return true;
+}
+
+bool parseRankKey(const std::string& s, RankKey& key) {
+    if (s == "absences") key = RankKey::Absences;
+    else if (s == "hours") key = RankKey::Hours;
+    else if (s == "records") key = RankKey::Records;
+    else return false;
+    return true;
+}
+
+// Разобрать условие --where; false при синтаксической ошибке
+bool parseWhere(const std::string& text, filter::Expression& expr) {
+    try {
+        expr = filter::Expression::parse(text);
+    }
+    catch (const std::invalid_argument& e) {
+        std::cerr << "Ошибка в условии: " << e.what() << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool printWhere(const AttendanceManager& manager, const std::string& text) {
+    filter::Expression expr;
+    if (!parseWhere(text, expr)) return false;
+    manager.printWhereReport(expr);
+    return true;
+}
+
+// Группировка по ключам "student,day,..." с необязательным условием
+bool printGroups(const AttendanceManager& manager, const std::string& keysText,
+    const std::string& whereText) {
+    unsigned keys;
+    if (!groupby::parseKeys(keysText, keys)) {
+        std::cerr << "Ошибка: неизвестные ключи группировки '" << keysText
+            << "' (student, day, hour, type).\n";
+        return false;
+    }
+
+    filter::Expression expr;
+    if (!whereText.empty() && !parseWhere(whereText, expr)) return false;
+    manager.printGroupReport(keys, whereText.empty() ? nullptr : &expr);
+    return true;
 }
 
 bool askConfirmation(const std::string& message) {
@@ -38,6 +166,11 @@ void interactiveMenu(AttendanceManager& manager) {
         std::cout << "3. Сохранить данные в JSON\n";
         std::cout << "4. Запустить бенчмарк\n";
         std::cout << "5. Информация о данных\n";
+        std::cout << "6. Записи за период\n";
+        std::cout << "7. Дописать новые записи в NDJSON\n";
+        std::cout << "8. Записи по условию (type, ts, student)\n";
+        std::cout << "9. Группировка (student, day, hour, type)\n";
+        std::cout << "10. Тепловая карта входов (день недели × час)\n";
         std::cout << "0. Выход\n";
         std::cout << "Выберите действие: ";
 
@@ -96,9 +229,8 @@ void interactiveMenu(AttendanceManager& manager) {
             }
 
             try {
-                auto jsonVal = manager.saveToJson();
-                std::string jsonStr = json::Parser::stringify(jsonVal, 2);
-                utils::writeFile(path, jsonStr);
+                if (ingest::isColumnar(path)) manager.saveColumnar(path);
+                else manager.saveJsonFile(path);
                 std::cout << "Данные успешно сохранены в " << fullPath << "\n";
             }
             catch (const std::exception& e) {
@@ -117,6 +249,89 @@ void interactiveMenu(AttendanceManager& manager) {
             break;
         }
 
+        case 6: {
+            std::string fromStr, toStr;
+            std::cout << "Начало периода (YYYY-MM-DD): ";
+            std::getline(std::cin, fromStr);
+            std::cout << "Конец периода (YYYY-MM-DD): ";
+            std::getline(std::cin, toStr);
+
+            if (!fromStr.empty() && fromStr.back() == '\r') fromStr.pop_back();
+            if (!toStr.empty() && toStr.back() == '\r') toStr.pop_back();
+
+            long long from, to;
+            if (parseRange(fromStr, toStr, from, to)) {
+                manager.printRangeReport(from, to);
+            }
+            break;
+        }
+
+        case 7: {
+            std::cout << "Введите имя NDJSON-файла: ";
+            std::string path;
+            std::getline(std::cin, path);
+
+            if (!path.empty() && path.back() == '\r') {
+                path.pop_back();
+            }
+
+            if (path.empty()) {
+                std::cout << "Отменено.\n";
+                break;
+            }
+
+            try {
+                size_t appended = manager.appendNdjson(path);
+                std::cout << "Дописано записей: " << appended << " в " << utils::getPath(path) << "\n";
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Ошибка сохранения: " << e.what() << "\n";
+            }
+            break;
+        }
+
+        case 8: {
+            std::cout << "Условие (например, type=absence and ts>=2025-10-01): ";
+            std::string text;
+            std::getline(std::cin, text);
+
+            if (!text.empty() && text.back() == '\r') {
+                text.pop_back();
+            }
+
+            if (text.empty()) {
+                std::cout << "Отменено.\n";
+                break;
+            }
+
+            printWhere(manager, text);
+            break;
+        }
+
+        case 9: {
+            std::string keysText, whereText;
+            std::cout << "Ключи через запятую (например, day,student): ";
+            std::getline(std::cin, keysText);
+            std::cout << "Условие (пусто — все записи): ";
+            std::getline(std::cin, whereText);
+
+            if (!keysText.empty() && keysText.back() == '\r') keysText.pop_back();
+            if (!whereText.empty() && whereText.back() == '\r') whereText.pop_back();
+
+            printGroups(manager, keysText, whereText);
+            break;
+        }
+
+        case 10: {
+            std::cout << "Имя студента (пусто — все): ";
+            std::string name;
+            std::getline(std::cin, name);
+            if (!name.empty() && name.back() == '\r') name.pop_back();
+
+            manager.printHeatmap(name);
+            break;
+        }
+
         case 0:
             std::cout << "Выход из программы.\n";
             return;
@@ -127,45 +342,511 @@ void interactiveMenu(AttendanceManager& manager) {
     }
 }
 
-int main(int argc, char* argv[]) {
-    utils::setupConsoleEncoding();
+// Действия после загрузки данных (без них открывается меню)
+struct Actions {
+    bool validateOnly = false;
+    bool runBench = false;
+    bool benchThreads = false;
+    bool benchColumnar = false;
+    bool benchHeatmap = false;
+    std::string targetStudent = "";
+    std::string fromStr = "";
+    std::string toStr = "";
+    size_t topK = 0;
+    std::string topBy = "absences";
+    std::string exportDir = "";
+    std::string exportFormat = "txt";
+    std::string snapshotPath = "";
+    std::string snapshotFrom = "";
+    std::string whereExpr = "";
+    std::string groupKeys = "";
+    std::string indexSource = "";  // файл данных, для которого сохранить индекс (--build-index)
+    std::string partitionOut = "";
+    std::string columnarOut = "";
+    std::string heatmapStudent = "";  // "all" — все студенты
+};
+
+int runActions(AttendanceManager& manager, const Actions& actions) {
+    if (actions.validateOnly) {
+        std::cout << "\nВалидация завершена. Программа завершает работу.\n";
+        return 0;
+    }
+
+    if (actions.runBench) {
+        manager.benchmarkAggregation();
+        return 0;
+    }
+
+    if (actions.benchThreads) {
+        manager.benchmarkScaling();
+        return 0;
+    }
+
+    if (actions.benchColumnar || actions.benchHeatmap) {
+        if (manager.recordCount() == 0) {
+            std::cout << "Нет данных для бенчмарка.\n";
+            return 0;
+        }
+        if (actions.benchColumnar) manager.benchmarkColumnar();
+        if (actions.benchHeatmap) manager.benchmarkHeatmap();
+        return 0;
+    }
+
+    if (!actions.indexSource.empty() || !actions.targetStudent.empty()) {
+        if (!actions.indexSource.empty()) {
+            std::string indexFile = StudentIndex::pathFor(actions.indexSource);
+            try {
+                manager.saveStudentIndex(indexFile, actions.indexSource);
+                std::cout << "Индекс по студентам сохранён: " << utils::getPath(indexFile) << "\n";
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Предупреждение: индекс не сохранён: " << e.what() << "\n";
+            }
+        }
+        if (!actions.targetStudent.empty()) manager.printReportByStudent(actions.targetStudent);
+        return 0;
+    }
+
+    if (!actions.snapshotPath.empty()) {
+        manager.saveStatsSnapshot(actions.snapshotPath);
+        std::cout << "Снимок статистики сохранён в " << utils::getPath(actions.snapshotPath)
+            << " (" << utils::getFileSize(actions.snapshotPath) << " байт)\n";
+        return 0;
+    }
+
+    if (!actions.columnarOut.empty()) {
+        auto start = std::chrono::high_resolution_clock::now();
+        manager.saveColumnar(actions.columnarOut);
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "Колоночный снимок сохранён в " << utils::getPath(actions.columnarOut)
+            << " (" << utils::getFileSize(actions.columnarOut) << " байт, "
+            << std::chrono::duration<double, std::milli>(end - start).count() << " мс)\n";
+        return 0;
+    }
+
+    if (!actions.partitionOut.empty()) {
+        auto start = std::chrono::high_resolution_clock::now();
+        partition::WriteStats written;
+        size_t parts = manager.savePartitions(actions.partitionOut, &written);
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "Записей: " << written.appended << " дописано в " << parts
+            << " разделов каталога " << actions.partitionOut
+            << ", повторов пропущено: " << written.skipped
+            << " (" << std::chrono::duration<double, std::milli>(end - start).count() << " мс)\n";
+        return 0;
+    }
+
+    if (!actions.exportDir.empty()) {
+        auto start = std::chrono::high_resolution_clock::now();
+        size_t files = manager.exportReports(actions.exportDir, actions.exportFormat);
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "Отчётов записано: " << files << " в " << actions.exportDir
+            << " (" << std::chrono::duration<double, std::milli>(end - start).count() << " мс)\n";
+        return 0;
+    }
+
+    if (!actions.heatmapStudent.empty()) {
+        manager.printHeatmap(actions.heatmapStudent == "all" ? "" : actions.heatmapStudent);
+        return 0;
+    }
+
+    if (!actions.groupKeys.empty()) {
+        return printGroups(manager, actions.groupKeys, actions.whereExpr) ? 0 : 1;
+    }
+
+    if (!actions.whereExpr.empty()) {
+        return printWhere(manager, actions.whereExpr) ? 0 : 1;
+    }
+
+    if (actions.topK > 0) {
+        RankKey key;
+        if (!parseRankKey(actions.topBy, key)) {
+            std::cerr << "Ошибка: неизвестный критерий '" << actions.topBy
+                << "' (absences, hours или records).\n";
+            return 1;
+        }
+        manager.printTopStudents(actions.topK, key);
+        return 0;
+    }
+
+    if (!actions.fromStr.empty() || !actions.toStr.empty()) {
+        long long from, to;
+        if (!parseRange(actions.fromStr, actions.toStr, from, to)) return 1;
+        manager.printRangeReport(from, to);
+        return 0;
+    }
+
+    interactiveMenu(manager);
+    return 0;
+}
+
+// Статистика со снимка (--stats-from): события снимка сливаются с загруженными
+// записями, данные, из которых построен снимок, заново не разбираются
+int runStatsFrom(const AttendanceManager& manager, const Actions& actions) {
+    auto start = std::chrono::high_resolution_clock::now();
+    auto stats = manager.statsWithSnapshot(actions.snapshotFrom, actions.targetStudent);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "Статистика со снимка " << utils::getPath(actions.snapshotFrom)
+        << " (" << std::chrono::duration<double, std::milli>(end - start).count() << " мс)\n";
+
+    if (!actions.targetStudent.empty()) {
+        auto found = stats.find(actions.targetStudent);
+        if (found == stats.end()) {
+            std::cout << "Студент '" << actions.targetStudent << "' не найден.\n";
+            return 0;
+        }
+        AttendanceManager::printStatsTable({ *found });
+        return 0;
+    }
+
+    AttendanceManager::printStatsTable(stats);
+    return 0;
+}
+
+// --student по индексу рядом с файлом данных, без разбора самого файла.
+// false — индекса нет или он устарел.
+bool answerFromIndex(const std::string& dataFile, const std::string& student) {
+    auto start = std::chrono::high_resolution_clock::now();
+    StudentIndex index;
+    if (!index.open(StudentIndex::pathFor(dataFile), dataFile)) return false;
+
+    std::vector<AttendanceRecord> rows;
+    bool found = index.find(student, rows);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::cout << "Ответ по индексу " << utils::getPath(StudentIndex::pathFor(dataFile))
+        << " (" << std::chrono::duration<double, std::milli>(end - start).count() << " мс)\n";
+
+    if (!found) {
+        StudentDictionary names;
+        for (const auto& name : index.names()) names.intern(name);
+        AttendanceManager::printReportTable(student, {});
+        AttendanceManager::printSuggestions(names.suggest(student));
+        return true;
+    }
+
+    std::vector<const AttendanceRecord*> ptrs;
+    ptrs.reserve(rows.size());
+    for (const auto& r : rows) ptrs.push_back(&r);
+    AttendanceManager::printReportTable(student, ptrs);
+    return true;
+}
+
+// Запрос к хранилищу по разделам: читаются только разделы, которые по сводке
+// могут содержать студента и период; найденные записи идут в обычные отчёты
+int runPartitions(AttendanceManager& manager, const std::string& root, const Actions& actions) {
+    partition::Query query;
+    query.student = actions.targetStudent;
+    if (!actions.fromStr.empty() || !actions.toStr.empty()) {
+        if (!parseRange(actions.fromStr, actions.toStr, query.from, query.to)) return 1;
+    }
+
+    partition::ScanStats stats;
+    auto rows = partition::scan(root, query, &stats);
+    std::cout << "Разделов: " << stats.partitions << ", пропущено по сводкам: " << stats.pruned
+        << ", прочитано строк: " << stats.rowsRead << ", подходит: " << rows.size()
+        << " (" << stats.millis << " мс)\n";
+
+    manager.loadRecords(std::move(rows));
+    return runActions(manager, actions);
+}
+
+// Приближённая статистика: каждый файл читается потоково в свою сводку
+// фиксированного размера, сводки файлов затем объединяются
+int runApprox(const std::vector<std::string>& inputs, size_t topK) {
+    if (topK > sketch::HeavyHitters::MAX_CAPACITY) {
+        std::cerr << "В режиме --approx --top не больше " << sketch::HeavyHitters::MAX_CAPACITY
+            << ", используется " << sketch::HeavyHitters::MAX_CAPACITY << ".\n";
+        topK = sketch::HeavyHitters::MAX_CAPACITY;
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    auto paths = ingest::expandInputs(inputs);
+    std::vector<sketch::Summary> parts(paths.size(), sketch::Summary(topK));
+    std::vector<std::string> errors(paths.size());
+
+    ThreadPool::instance().parallelFor(0, paths.size(), 1, [&](size_t lo, size_t hi) {
+        for (size_t f = lo; f < hi; ++f) {
+            try {
+                if (ingest::isColumnar(paths[f])) {
+                    for (const auto& rec : columnar::load(paths[f])) parts[f].add(rec);
+                    continue;
+                }
+                RecordStreamReader reader(paths[f]);
+                AttendanceRecord rec;
+                while (reader.next(rec)) parts[f].add(rec);
+            }
+            catch (const std::exception& e) {
+                errors[f] = e.what();
+            }
+        }
+    });
+
+    sketch::Summary summary(topK);
+    size_t failed = 0;
+    for (size_t f = 0; f < paths.size(); ++f) {
+        if (!errors[f].empty()) {
+            std::cerr << "Ошибка в " << paths[f] << ": " << errors[f] << "\n";
+            failed++;
+            continue;
+        }
+        summary.merge(parts[f]);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "Файлов: " << paths.size() - failed << " из " << paths.size()
+        << " (" << std::chrono::duration<double, std::milli>(end - start).count() << " мс)\n";
+    if (failed == paths.size()) return 1;
+
+    AttendanceManager::printApproxTable(summary);
+    return 0;
+}
+
+// deduper — устранение повторов пакетами по мере чтения (nullptr — выключено)
+int runOutOfCore(const std::vector<std::string>& inputs, size_t budgetBytes,
+    const std::string& targetStudent, dedup::Deduplicator* deduper) {
+    auto start = std::chrono::high_resolution_clock::now();
+    ExternalStore store(budgetBytes);
+    size_t duplicates = 0;
+
+    std::vector<AttendanceRecord> batch;
+    auto flush = [&]() {
+        if (deduper) duplicates += deduper->filter(batch);
+        for (const auto& r : batch) store.add(r);
+        batch.clear();
+    };
+
+    for (const auto& path : ingest::expandInputs(inputs)) {
+        std::cout << "Потоковое чтение: " << path << "\n";
+        RecordStreamReader reader(path);
+        AttendanceRecord rec;
+        while (reader.next(rec)) {
+            if (!AttendanceManager::isValid(rec)) {
+                store.add(rec);  // учитывается как отброшенная
+                continue;
+            }
+            batch.push_back(std::move(rec));
+            if (batch.size() >= 65536) flush();
+        }
+    }
+    flush();
+    store.finish();
+
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "Принято записей: " << store.recordCount()
+        << ", отброшено: " << store.rejectedCount();
+    if (deduper) std::cout << ", повторов: " << duplicates;
+    std::cout << ", прогонов на диске: " << store.runCount();
+    if (store.spilledRunCount() > store.runCount()) {
+        std::cout << " (сброшено " << store.spilledRunCount() << ", слиты каскадом)";
+    }
+    std::cout << " (" << std::chrono::duration<double, std::milli>(end - start).count() << " мс)\n";
+
+    if (!targetStudent.empty()) {
+        if (!store.students().contains(targetStudent)) {
+            AttendanceManager::printReportTable(targetStudent, {});
+            AttendanceManager::printSuggestions(store.students().suggest(targetStudent));
+            return 0;
+        }
 
+        auto rows = store.studentRecords(targetStudent);
+        std::vector<const AttendanceRecord*> ptrs;
+        ptrs.reserve(rows.size());
+        for (const auto& r : rows) ptrs.push_back(&r);
+        AttendanceManager::printReportTable(targetStudent, ptrs);
+        return 0;
+    }
+
+    AttendanceManager::printStatsTable(store.aggregate());
+    return 0;
+}
+
+void printBanner() {
     std::cout << "=== Attendance CLI Tool ===\n";
     std::cout << "Учёт посещаемости студентов\n\n";
+}
+
+// Для --format csv|tsv|json в stdout идут только таблицы: пока объект жив,
+// std::cout (баннер, ход загрузки, замеры) направлен в stderr
+class DiagnosticsToStderr {
+public:
+    DiagnosticsToStderr() : tables(std::cout.rdbuf()) {
+        AttendanceManager::setTableOutput(tables);
+        std::cout.rdbuf(std::cerr.rdbuf());
+    }
+
+    ~DiagnosticsToStderr() {
+        tables.flush();
+        std::cout.rdbuf(tables.rdbuf());
+        AttendanceManager::setTableOutput(std::cout);
+    }
+
+    DiagnosticsToStderr(const DiagnosticsToStderr&) = delete;
+    DiagnosticsToStderr& operator=(const DiagnosticsToStderr&) = delete;
+
+private:
+    std::ostream tables;
+};
+
+int main(int argc, char* argv[]) {
+    utils::setupConsoleEncoding();
 
     AttendanceManager manager;
-    std::string inputFile = "";
-    std::string targetStudent = "";
-    bool runBench = false;
-    bool validateOnly = false;
+    std::vector<std::string> inputFiles;
+    Actions actions;
+    std::string socketPath = "";
+    size_t maxMemoryMb = 0;
+    bool usePipeline = false;
+    size_t threadCount = 0;
+    bool followMode = false;
+    bool approxMode = false;
+    bool dedupMode = false;
+    long long dedupWindow = 0;
+    bool useIndex = true;
+    bool buildIndex = false;
+    std::string partitionRoot = "";
+    bool tablesOnlyOnStdout = false;
 
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
 
         if (arg == "--help") {
+            printBanner();
             printHelp();
             return 0;
         }
         else if (arg == "--input" && i + 1 < argc) {
-            inputFile = argv[++i];
+            while (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0) {
+                inputFiles.push_back(argv[++i]);
+            }
         }
         else if (arg == "--student" && i + 1 < argc) {
-            targetStudent = argv[++i];
+            actions.targetStudent = argv[++i];
         }
         else if (arg == "--bench") {
-            runBench = true;
+            actions.runBench = true;
         }
         else if (arg == "--validate-only") {
-            validateOnly = true;
+            actions.validateOnly = true;
+        }
+        else if (arg == "--serve" && i + 1 < argc) {
+            socketPath = argv[++i];
+        }
+        else if (arg == "--max-memory" && i + 1 < argc) {
+            if (!utils::parseCount(arg, argv[++i], maxMemoryMb)) return 1;
+        }
+        else if (arg == "--dedup") {
+            dedupMode = true;
+        }
+        else if (arg == "--dedup-window" && i + 1 < argc) {
+            dedupMode = true;
+            double hours = 0.0;
+            if (!utils::parseNonNegative(arg, argv[++i], hours)) return 1;
+            dedupWindow = static_cast<long long>(hours * 3600.0);
+        }
+        else if (arg == "--approx") {
+            approxMode = true;
+        }
+        else if (arg == "--pipeline") {
+            usePipeline = true;
+        }
+        else if (arg == "--bench-threads") {
+            actions.benchThreads = true;
+        }
+        else if (arg == "--bench-atc") {
+            actions.benchColumnar = true;
+        }
+        else if (arg == "--bench-heatmap") {
+            actions.benchHeatmap = true;
+        }
+        else if (arg == "--stats-snapshot" && i + 1 < argc) {
+            actions.snapshotPath = argv[++i];
+        }
+        else if (arg == "--stats-from" && i + 1 < argc) {
+            actions.snapshotFrom = argv[++i];
+        }
+        else if (arg == "--partition-out" && i + 1 < argc) {
+            actions.partitionOut = argv[++i];
+        }
+        else if (arg == "--save-columnar" && i + 1 < argc) {
+            actions.columnarOut = argv[++i];
+        }
+        else if (arg == "--partitions" && i + 1 < argc) {
+            partitionRoot = argv[++i];
+        }
+        else if (arg == "--no-index") {
+            useIndex = false;
+        }
+        else if (arg == "--build-index") {
+            buildIndex = true;
+        }
+        else if (arg == "--follow") {
+            followMode = true;
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            if (!utils::parseCount(arg, argv[++i], threadCount)) return 1;
+        }
+        else if (arg == "--from" && i + 1 < argc) {
+            actions.fromStr = argv[++i];
+        }
+        else if (arg == "--to" && i + 1 < argc) {
+            actions.toStr = argv[++i];
+        }
+        else if (arg == "--top" && i + 1 < argc) {
+            if (!utils::parseCount(arg, argv[++i], actions.topK)) return 1;
+        }
+        else if (arg == "--by" && i + 1 < argc) {
+            actions.topBy = argv[++i];
+        }
+        else if (arg == "--export-reports" && i + 1 < argc) {
+            actions.exportDir = argv[++i];
+        }
+        else if (arg == "--where" && i + 1 < argc) {
+            actions.whereExpr = argv[++i];
+        }
+        else if (arg == "--heatmap" && i + 1 < argc) {
+            actions.heatmapStudent = argv[++i];
+        }
+        else if (arg == "--group-by" && i + 1 < argc) {
+            actions.groupKeys = argv[++i];
+        }
+        else if (arg == "--export-format" && i + 1 < argc) {
+            actions.exportFormat = argv[++i];
+        }
+        else if (arg == "--format" && i + 1 < argc) {
+            TableWriter::Format format;
+            if (!TableWriter::parseFormat(argv[++i], format)) {
+                std::cerr << "Ошибка: неизвестный формат '" << argv[i]
+                    << "' (text, csv, tsv или json).\n";
+                return 1;
+            }
+            AttendanceManager::setTableFormat(format);
+            tablesOnlyOnStdout = format != TableWriter::Format::Text;
         }
         else {
             std::cerr << "Предупреждение: неизвестный аргумент '" << arg << "'\n";
         }
     }
 
+    std::optional<DiagnosticsToStderr> diagnostics;
+    if (tablesOnlyOnStdout) diagnostics.emplace();
+    printBanner();
+
+    ThreadPool::configure(threadCount);
+    if (dedupMode) manager.enableDedup(dedupWindow);
+    std::cout << "Потоков: " << ThreadPool::instance().threadCount() << "\n";
+
     try {
-        if (inputFile.empty()) {
-            inputFile = "example_valid.json";
+        if (!partitionRoot.empty()) {
+            return runPartitions(manager, partitionRoot, actions);
+        }
+
+        if (!actions.snapshotFrom.empty()) {
+            if (!inputFiles.empty()) ingest::loadInto(manager, inputFiles);
+            return runStatsFrom(manager, actions);
+        }
+
+        if (inputFiles.empty()) {
+            std::string inputFile = "example_valid.json";
             std::cout << "Файл не указан. Используется: " << inputFile << "\n";
 
             if (!std::filesystem::exists(utils::getPath(inputFile))) {
@@ -173,10 +854,66 @@ int main(int argc, char* argv[]) {
                 std::cout << "Создайте файл example_valid.json в папке data/\n";
                 return 1;
             }
+            inputFiles.push_back(inputFile);
+        }
+
+        if (!socketPath.empty()) {
+            std::cout << "Запуск сервера...\n";
+            QueryServer server(inputFiles, { dedupMode, dedupWindow });
+            server.run(socketPath);
+            return 0;
+        }
+
+        if (followMode) {
+            follow::run(manager, inputFiles.front());
+            manager.printGeneralStats();
+            return 0;
+        }
+
+        if (approxMode) {
+            return runApprox(inputFiles, actions.topK > 0 ? actions.topK : 10);
+        }
+
+        if (maxMemoryMb > 0) {
+            std::unique_ptr<dedup::Deduplicator> deduper;
+            if (dedupMode) deduper = std::make_unique<dedup::Deduplicator>(dedupWindow);
+            return runOutOfCore(inputFiles, maxMemoryMb * 1024 * 1024, actions.targetStudent, deduper.get());
+        }
+
+        if (ingest::isMultiInput(inputFiles) || ingest::isNdjson(inputFiles.front())
+            || ingest::isColumnar(inputFiles.front())) {
+            if (buildIndex) {
+                std::cerr << "Предупреждение: индекс строится только для одного JSON-файла.\n";
+            }
+            ingest::loadInto(manager, inputFiles);
+            return runActions(manager, actions);
+        }
+
+        const std::string& inputFile = inputFiles.front();
+
+        // Отчёт по одному студенту: сначала индекс (если он есть и не устарел),
+        // иначе файл разбирается целиком. Индекс хранит записи без повторов
+        // и фильтров, поэтому с --dedup, --where, --from, --to не используется.
+        bool filtered = dedupMode || !actions.whereExpr.empty()
+            || !actions.fromStr.empty() || !actions.toStr.empty();
+        if (buildIndex) {
+            if (dedupMode) {
+                std::cerr << "Ошибка: --build-index нельзя сочетать с --dedup.\n";
+                return 1;
+            }
+            actions.indexSource = inputFile;
+        }
+        else if (!actions.targetStudent.empty() && useIndex && !filtered) {
+            if (answerFromIndex(inputFile, actions.targetStudent)) return 0;
         }
 
         std::cout << "Загрузка файла: " << inputFile << "\n";
 
+        if (usePipeline) {
+            pipeline::loadFile(manager, inputFile);
+            return runActions(manager, actions);
+        }
+
         std::string content;
         try {
             size_t fileSize = utils::getFileSize(inputFile);
@@ -221,22 +958,7 @@ int main(int argc, char* argv[]) {
 
         manager.validateData();
 
-        if (validateOnly) {
-            std::cout << "\nВалидация завершена. Программа завершает работу.\n";
-            return 0;
-        }
-
-        if (runBench) {
-            manager.benchmarkAggregation();
-            return 0;
-        }
-
-        if (!targetStudent.empty()) {
-            manager.printReportByStudent(targetStudent);
-            return 0;
-        }
-
-        interactiveMenu(manager);
+        return runActions(manager, actions);
     }
     catch (const std::exception& e) {
         std::cerr << "\n!!! Критическая ошибка: " << e.what() << "\n";
@@ -0,0 +1,300 @@
+﻿#include "../include/partition_store.hpp"
+#include "../include/group_by.hpp"
+#include "../include/dedup.hpp"
+#include "../include/student_dictionary.hpp"
+#include "../include/thread_pool.hpp"
+#include "../include/utils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <unordered_set>
+
+namespace partition {
+
+    static const char FOOTER_MAGIC[4] = { 'A', 'T', 'P', 'F' };
+    static const uint32_t FOOTER_VERSION = 2;
+
+    static_assert(sizeof(Footer) == 48, "Footer layout");
+
+    uint64_t studentHash(std::string_view name) {
+        uint64_t h = 1469598103934665603ULL;
+        for (char c : name) {
+            h ^= static_cast<uint8_t>(c);
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+
+    static std::filesystem::path rootPath(const std::string& root) {
+        return std::filesystem::path(root).is_absolute()
+            ? std::filesystem::path(root) : std::filesystem::path(utils::getPath(root));
+    }
+
+    static std::string partName(uint32_t bucket) {
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "part-%02u.bin", bucket);
+        return buf;
+    }
+
+    // Номер раздела из имени part-XX.bin; BUCKETS — не раздел
+    static uint32_t bucketOf(const std::filesystem::path& file) {
+        unsigned bucket = 0;
+        std::string name = file.filename().string();
+        if (name.size() != 11 || std::sscanf(name.c_str(), "part-%2u.bin", &bucket) != 1) return BUCKETS;
+        return bucket < BUCKETS ? bucket : BUCKETS;
+    }
+
+    // --- Rows ---
+    // Строка: длина имени (2), имя, тип (1), epoch (8), длина метки (2), метка
+
+    template <typename T>
+    static void put(std::string& out, T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    static T take(const char*& p, const char* end) {
+        if (p + sizeof(T) > end) throw std::runtime_error("Corrupted partition");
+        T value;
+        std::memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+        return value;
+    }
+
+    static void appendRow(std::string& out, const AttendanceRecord& rec) {
+        put(out, static_cast<uint16_t>(rec.student.size()));
+        out += rec.student;
+        put(out, static_cast<uint8_t>(rec.type));
+        put(out, static_cast<int64_t>(rec.epoch));
+        put(out, static_cast<uint16_t>(rec.timestamp.size()));
+        out += rec.timestamp;
+    }
+
+    static std::string takeString(const char*& p, const char* end) {
+        uint16_t length = take<uint16_t>(p, end);
+        if (p + length > end) throw std::runtime_error("Corrupted partition");
+        std::string s(p, length);
+        p += length;
+        return s;
+    }
+
+    static void readRows(const std::string& data, std::vector<AttendanceRecord>& out) {
+        const char* p = data.data();
+        const char* end = p + data.size();
+        while (p < end) {
+            AttendanceRecord rec;
+            rec.student = takeString(p, end);
+            rec.type = static_cast<EventType>(take<uint8_t>(p, end));
+            rec.epoch = take<int64_t>(p, end);
+            rec.timestamp = takeString(p, end);
+            out.push_back(std::move(rec));
+        }
+    }
+
+    // --- Files ---
+
+    // Сводка проверяется по размеру файла: части раздела должны занимать его целиком
+    static bool readFooter(const std::filesystem::path& file, Footer& footer) {
+        std::error_code ec;
+        uint64_t size = std::filesystem::file_size(file, ec);
+        if (ec || size < sizeof(Footer)) return false;
+
+        std::ifstream in(file, std::ios::in | std::ios::binary);
+        if (!in.is_open()) return false;
+        in.seekg(-static_cast<std::streamoff>(sizeof(Footer)), std::ios::end);
+        in.read(reinterpret_cast<char*>(&footer), sizeof(Footer));
+        if (!in || std::memcmp(footer.magic, FOOTER_MAGIC, sizeof(FOOTER_MAGIC)) != 0
+            || footer.version != FOOTER_VERSION) {
+            return false;
+        }
+        uint64_t body = size - sizeof(Footer);
+        return footer.dataBytes <= body && footer.bloomBytes == body - footer.dataBytes;
+    }
+
+    static std::string readData(const std::filesystem::path& file, const Footer& footer) {
+        std::ifstream in(file, std::ios::in | std::ios::binary);
+        if (!in.is_open()) throw std::runtime_error("Cannot open file: " + file.string());
+        std::string data(static_cast<size_t>(footer.dataBytes), '\0');
+        in.read(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!in) throw std::runtime_error("Truncated partition: " + file.string());
+        return data;
+    }
+
+    static BloomFilter readBloom(const std::filesystem::path& file, const Footer& footer) {
+        std::ifstream in(file, std::ios::in | std::ios::binary);
+        if (!in.is_open()) throw std::runtime_error("Cannot open file: " + file.string());
+        in.seekg(static_cast<std::streamoff>(footer.dataBytes));
+        return BloomFilter::read(in);
+    }
+
+    // Возвращает число дописанных строк
+    static size_t writePartition(const std::filesystem::path& file,
+        const std::vector<const AttendanceRecord*>& fresh) {
+        // Прежние строки раздела сохраняются, новые дописываются в конец
+        std::string data;
+        std::vector<AttendanceRecord> existing;
+        Footer old{};
+        if (std::filesystem::exists(file)) {
+            if (!readFooter(file, old)) throw std::runtime_error("Corrupted partition: " + file.string());
+            data = readData(file, old);
+            readRows(data, existing);
+        }
+
+        // Отпечатки уже записанных строк: повторная загрузка не дублирует их
+        dedup::FingerprintSet seen(existing.size() + fresh.size());
+        for (const auto& rec : existing) seen.insert(dedup::fingerprint(rec.student, rec.epoch, rec.type), rec.epoch);
+
+        std::vector<const AttendanceRecord*> added;
+        added.reserve(fresh.size());
+        for (const auto* rec : fresh) {
+            if (seen.insert(dedup::fingerprint(rec->student, rec->epoch, rec->type), rec->epoch)) {
+                added.push_back(rec);
+            }
+        }
+        if (added.empty()) return 0;
+
+        Footer footer{};
+        footer.minEpoch = LLONG_MAX;
+        footer.maxEpoch = LLONG_MIN;
+        std::unordered_set<std::string_view> names;
+        auto account = [&](const AttendanceRecord& rec) {
+            footer.minEpoch = std::min<int64_t>(footer.minEpoch, rec.epoch);
+            footer.maxEpoch = std::max<int64_t>(footer.maxEpoch, rec.epoch);
+            footer.recordCount++;
+            names.insert(rec.student);
+        };
+        for (const auto& rec : existing) account(rec);
+        for (const auto* rec : added) {
+            account(*rec);
+            appendRow(data, *rec);
+        }
+
+        BloomFilter bloom(names.size());
+        for (auto name : names) bloom.add(name);
+        std::ostringstream bloomOut(std::ios::binary);
+        bloom.write(bloomOut);
+        std::string bloomBytes = bloomOut.str();
+
+        footer.dataBytes = data.size();
+        footer.bloomBytes = bloomBytes.size();
+        footer.version = FOOTER_VERSION;
+        std::memcpy(footer.magic, FOOTER_MAGIC, sizeof(FOOTER_MAGIC));
+
+        std::filesystem::path tmp = file;
+        tmp += ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) throw std::runtime_error("Cannot open file for writing: " + tmp.string());
+            out.write(data.data(), static_cast<std::streamsize>(data.size()));
+            out.write(bloomBytes.data(), static_cast<std::streamsize>(bloomBytes.size()));
+            out.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+            out.flush();
+            if (!out) throw std::runtime_error("Write failed: " + tmp.string());
+        }
+        std::filesystem::rename(tmp, file);
+        return added.size();
+    }
+
+    size_t write(const std::string& root, const std::vector<AttendanceRecord>& records,
+        WriteStats* stats) {
+        // (YYYYMM, раздел) -> записи
+        std::map<std::pair<uint32_t, uint32_t>, std::vector<const AttendanceRecord*>> groups;
+        groupby::Calendar calendar;
+        for (const auto& rec : records) {
+            uint32_t day = 0, hour = 0;
+            calendar.split(rec.epoch, day, hour);
+            uint32_t bucket = static_cast<uint32_t>(studentHash(rec.student) % BUCKETS);
+            groups[{ day / 100, bucket }].push_back(&rec);
+        }
+
+        std::filesystem::path base = rootPath(root);
+        std::vector<std::pair<std::filesystem::path, const std::vector<const AttendanceRecord*>*>> work;
+        for (const auto& [key, rows] : groups) {
+            char month[16];
+            std::snprintf(month, sizeof(month), "%04u-%02u", key.first / 100, key.first % 100);
+            std::filesystem::path dir = base / month;
+            std::filesystem::create_directories(dir);
+            work.emplace_back(dir / partName(key.second), &rows);
+        }
+
+        std::vector<size_t> appended(work.size(), 0);
+        ThreadPool::instance().parallelFor(0, work.size(), 1, [&](size_t lo, size_t hi) {
+            for (size_t w = lo; w < hi; ++w) appended[w] = writePartition(work[w].first, *work[w].second);
+        });
+
+        size_t rewritten = 0;
+        WriteStats local;
+        for (size_t w = 0; w < work.size(); ++w) {
+            if (appended[w] > 0) rewritten++;
+            local.appended += appended[w];
+        }
+        local.skipped = records.size() - local.appended;
+        if (stats) *stats = local;
+        return rewritten;
+    }
+
+    std::vector<AttendanceRecord> scan(const std::string& root, const Query& query, ScanStats* stats) {
+        auto start = std::chrono::high_resolution_clock::now();
+        ScanStats local;
+
+        std::filesystem::path base = rootPath(root);
+        if (!std::filesystem::is_directory(base)) {
+            throw std::runtime_error("Partition directory not found: " + base.string());
+        }
+
+        bool byStudent = !query.student.empty();
+        uint64_t id = byStudent ? studentHash(query.student) : 0;
+        uint32_t wantedBucket = static_cast<uint32_t>(id % BUCKETS);
+
+        std::vector<std::filesystem::path> files;
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(base)) {
+            if (entry.is_regular_file() && bucketOf(entry.path()) < BUCKETS) files.push_back(entry.path());
+        }
+        std::sort(files.begin(), files.end());
+        local.partitions = files.size();
+
+        // Отбор по имени файла, сводке и фильтру Блума: данные таких разделов не читаются
+        std::vector<std::pair<std::filesystem::path, Footer>> candidates;
+        for (const auto& file : files) {
+            if (byStudent && bucketOf(file) != wantedBucket) continue;
+
+            Footer footer;
+            if (!readFooter(file, footer)) throw std::runtime_error("Corrupted partition: " + file.string());
+            if (footer.maxEpoch < query.from || footer.minEpoch > query.to) continue;
+            if (byStudent && !readBloom(file, footer).mightContain(query.student)) continue;
+            candidates.emplace_back(file, footer);
+        }
+        local.pruned = files.size() - candidates.size();
+
+        std::vector<std::vector<AttendanceRecord>> parts(candidates.size());
+        std::vector<size_t> rowsRead(candidates.size(), 0);
+        ThreadPool::instance().parallelFor(0, candidates.size(), 1, [&](size_t lo, size_t hi) {
+            for (size_t c = lo; c < hi; ++c) {
+                std::vector<AttendanceRecord> rows;
+                readRows(readData(candidates[c].first, candidates[c].second), rows);
+                rowsRead[c] = rows.size();
+                for (auto& rec : rows) {
+                    if (rec.epoch < query.from || rec.epoch > query.to) continue;
+                    if (byStudent && rec.student != query.student) continue;
+                    parts[c].push_back(std::move(rec));
+                }
+            }
+        });
+
+        std::vector<AttendanceRecord> result;
+        for (size_t c = 0; c < parts.size(); ++c) {
+            local.rowsRead += rowsRead[c];
+            std::move(parts[c].begin(), parts[c].end(), std::back_inserter(result));
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        local.millis = std::chrono::duration<double, std::milli>(end - start).count();
+        if (stats) *stats = local;
+        return result;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,214 @@
+﻿#include "../include/pipeline.hpp"
+#include "../include/spsc_queue.hpp"
+#include "../include/record_stream.hpp"
+#include "../include/utils.hpp"
+#include "../include/thread_pool.hpp"
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+
+namespace pipeline {
+
+    using Clock = std::chrono::high_resolution_clock;
+
+    static double millisSince(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // Объекты JSON подряд в одном буфере; ends — концы объектов
+    struct TextBatch {
+        std::string text;
+        std::vector<size_t> ends;
+    };
+
+    struct RecordBatch {
+        std::vector<AttendanceRecord> records;
+        std::string error;
+    };
+
+    constexpr size_t OBJECTS_PER_BATCH = 4096;
+    constexpr size_t QUEUE_CAPACITY = 8;
+    constexpr size_t READ_BLOCK = 1 << 20;
+
+    Stats loadFile(AttendanceManager& manager, const std::string& filename, size_t parserThreads) {
+        if (parserThreads == 0) {
+            size_t threads = ThreadPool::instance().threadCount();
+            parserThreads = threads > 2 ? threads - 2 : 1;
+        }
+
+        Stats stats;
+        auto wallStart = Clock::now();
+
+        std::string path = utils::getPath(filename);
+        std::ifstream in(path, std::ios::in | std::ios::binary);
+        if (!in.is_open()) throw std::runtime_error("Cannot open file: " + path);
+
+        std::vector<std::unique_ptr<SpscQueue<TextBatch>>> textQueues;
+        std::vector<std::unique_ptr<SpscQueue<RecordBatch>>> recordQueues;
+        std::vector<double> parseBusy(parserThreads, 0.0);
+        for (size_t i = 0; i < parserThreads; ++i) {
+            textQueues.push_back(std::make_unique<SpscQueue<TextBatch>>(QUEUE_CAPACITY));
+            recordQueues.push_back(std::make_unique<SpscQueue<RecordBatch>>(QUEUE_CAPACITY));
+        }
+
+        // Сбой любой стадии отменяет все очереди: остальные стадии выходят из
+        // ожидания, потоки присоединяются, первая ошибка пробрасывается
+        std::exception_ptr stageError;
+        std::mutex errorMutex;
+        auto cancelStages = [&](std::exception_ptr error) {
+            {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!stageError) stageError = error;
+            }
+            for (auto& q : textQueues) q->cancel();
+            for (auto& q : recordQueues) q->cancel();
+        };
+        // Тело потока стадии: исключение отменяет конвейер вместо std::terminate
+        auto guarded = [&cancelStages](auto body) {
+            return [&cancelStages, body]() {
+                try {
+                    body();
+                }
+                catch (...) {
+                    cancelStages(std::current_exception());
+                }
+            };
+        };
+
+        // Стадия 1: чтение блоков и нарезка на объекты.
+        // Пакеты раздаются парсерам по кругу, в том же порядке их забирает загрузчик.
+        auto readStage = [&]() {
+            ObjectSplitter splitter;
+            std::vector<char> block(READ_BLOCK);
+            std::string object;
+            TextBatch batch;
+            size_t target = 0;
+            auto busyStart = Clock::now();
+
+            auto send = [&]() {
+                stats.readMs += millisSince(busyStart);
+                textQueues[target]->push(std::move(batch));
+                busyStart = Clock::now();
+                batch = TextBatch{};
+                target = (target + 1) % textQueues.size();
+            };
+
+            while (in.read(block.data(), static_cast<std::streamsize>(block.size())) || in.gcount() > 0) {
+                size_t got = static_cast<size_t>(in.gcount());
+                stats.bytes += got;
+                splitter.feed(block.data(), got);
+
+                while (splitter.nextObject(object)) {
+                    batch.text += object;
+                    batch.ends.push_back(batch.text.size());
+                    if (batch.ends.size() == OBJECTS_PER_BATCH) send();
+                }
+            }
+            if (!batch.ends.empty()) send();
+            stats.readMs += millisSince(busyStart);
+
+            for (auto& q : textQueues) q->close();
+        };
+
+        // Стадия 2: парсеры объектов в записи
+        auto parseStage = [&](size_t w) {
+            TextBatch batch;
+            while (textQueues[w]->pop(batch)) {
+                auto busyStart = Clock::now();
+                RecordBatch out;
+                out.records.reserve(batch.ends.size());
+                try {
+                    size_t begin = 0;
+                    for (size_t end : batch.ends) {
+                        json::Value value = json::Parser::parse(batch.text.substr(begin, end - begin));
+                        out.records.push_back(AttendanceManager::recordFromJson(value.asObject()));
+                        begin = end;
+                    }
+                }
+                catch (const std::exception& e) {
+                    out.records.clear();
+                    out.error = e.what();
+                }
+                parseBusy[w] += millisSince(busyStart);
+                recordQueues[w]->push(std::move(out));
+            }
+            recordQueues[w]->close();
+        };
+
+        std::thread reader;
+        std::vector<std::thread> parsers;
+        auto joinStages = [&]() {
+            if (reader.joinable()) reader.join();
+            for (auto& t : parsers) {
+                if (t.joinable()) t.join();
+            }
+        };
+
+        std::vector<AttendanceRecord> loaded;
+        std::string firstError;
+
+        try {
+            reader = std::thread(guarded(readStage));
+            for (size_t w = 0; w < parserThreads; ++w) {
+                parsers.emplace_back(guarded([&parseStage, w]() { parseStage(w); }));
+            }
+
+            // Стадия 3: валидация и загрузка в текущем потоке.
+            // Пакеты раздавались по кругу, поэтому первая закрытая и пустая
+            // очередь означает, что пакетов больше нет ни в одной из очередей
+            RecordBatch batch;
+            size_t source = 0;
+            while (recordQueues[source]->pop(batch)) {
+                auto busyStart = Clock::now();
+                if (!batch.error.empty() && firstError.empty()) {
+                    firstError = batch.error;
+                }
+                for (auto& rec : batch.records) {
+                    if (AttendanceManager::isValid(rec)) {
+                        loaded.push_back(std::move(rec));
+                    }
+                    else {
+                        stats.invalid++;
+                    }
+                }
+                stats.loadMs += millisSince(busyStart);
+                source = (source + 1) % recordQueues.size();
+            }
+        }
+        catch (...) {
+            // Сбой загрузчика или создания потока: потоки не должны остаться
+            // неприсоединёнными (std::terminate) или ждать в полных очередях
+            cancelStages(std::current_exception());
+            joinStages();
+            throw;
+        }
+
+        joinStages();
+        if (stageError) std::rethrow_exception(stageError);
+
+        if (!firstError.empty()) {
+            throw std::runtime_error("Pipeline parse error: " + firstError);
+        }
+
+        for (double ms : parseBusy) stats.parseMs += ms;
+        stats.records = loaded.size();
+
+        manager.loadRecords(std::move(loaded));
+        if (manager.dedupEnabled()) {
+            stats.duplicates = manager.removeDuplicates();
+            stats.records -= stats.duplicates;
+        }
+        stats.wallMs = millisSince(wallStart);
+
+        std::cout << "Validation complete. Removed " << stats.invalid << " invalid records";
+        if (manager.dedupEnabled()) std::cout << " and " << stats.duplicates << " duplicates";
+        std::cout << " (" << stats.records << " valid remain).\n";
+        std::cout << "[Pipeline] чтение: " << stats.readMs << " мс, парсинг ("
+            << parserThreads << " потоков): " << stats.parseMs << " мс, загрузка: "
+            << stats.loadMs << " мс, всего: " << stats.wallMs << " мс\n";
+
+        return stats;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,383 @@
+﻿#ifdef _WIN32
+#include <winsock2.h>
+#include <afunix.h>
+#define NOMINMAX
+#include <windows.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#include "../include/query_server.hpp"
+#include "../include/ingest.hpp"
+#include "../include/utils.hpp"
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <algorithm>
+#include <csignal>
+#include <chrono>
+
+#ifdef _WIN32
+using socket_t = SOCKET;
+using pollfd_t = WSAPOLLFD;
+static void closeSocket(socket_t s) { closesocket(s); }
+static bool isValidSocket(socket_t s) { return s != INVALID_SOCKET; }
+static int pollSockets(pollfd_t* fds, size_t count, int timeoutMs) {
+    return WSAPoll(fds, static_cast<ULONG>(count), timeoutMs);
+}
+static bool pollInterrupted() { return false; }
+#else
+using socket_t = int;
+using pollfd_t = pollfd;
+static void closeSocket(socket_t s) { close(s); }
+static bool isValidSocket(socket_t s) { return s >= 0; }
+static int pollSockets(pollfd_t* fds, size_t count, int timeoutMs) {
+    return poll(fds, static_cast<nfds_t>(count), timeoutMs);
+}
+static bool pollInterrupted() { return errno == EINTR; }
+#endif
+
+// Период опроса: с такой задержкой замечаются stop() и Ctrl+C
+static constexpr int POLL_MS = 200;
+// Пауза после неудачного accept (например, кончились дескрипторы)
+static constexpr int ACCEPT_RETRY_MS = 100;
+// Строка без перевода длиннее этого — ошибка клиента, соединение закрывается
+static constexpr size_t MAX_LINE_BYTES = 64 * 1024;
+// Пока у клиента столько строк ждут ответа, его сокет не читается
+static constexpr size_t MAX_QUEUED_LINES = 256;
+
+static std::atomic<bool> interrupted{ false };
+
+static void onInterrupt(int) {
+    interrupted = true;
+}
+
+// Сокет закрывается, когда клиента отпускают и поток опроса, и обработчик
+struct QueryServer::Client {
+    socket_t sock;
+    std::string input;                  // хвост без перевода строки; только поток опроса
+    std::deque<std::string> lines;      // под queueMutex
+    bool queued = false;                // под queueMutex: в очереди или обрабатывается
+    std::atomic<bool> broken{ false };  // отправка не удалась
+
+    explicit Client(socket_t sock) : sock(sock) {}
+    ~Client() { closeSocket(sock); }
+};
+
+static bool sendAll(socket_t sock, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        int w = static_cast<int>(send(sock, data.data() + sent, static_cast<int>(data.size() - sent), 0));
+        if (w <= 0) return false;
+        sent += w;
+    }
+    return true;
+}
+
+// Заменять можно только сокет, оставшийся от прошлого запуска:
+// путь по ошибке может указывать на файл данных
+static bool isSocketFile(const std::string& path) {
+#ifdef _WIN32
+#ifndef IO_REPARSE_TAG_AF_UNIX
+#define IO_REPARSE_TAG_AF_UNIX 0x80000023L
+#endif
+    WIN32_FIND_DATAW data;
+    HANDLE found = FindFirstFileW(std::filesystem::path(path).c_str(), &data);
+    if (found == INVALID_HANDLE_VALUE) return false;
+    FindClose(found);
+    return (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) && data.dwReserved0 == IO_REPARSE_TAG_AF_UNIX;
+#else
+    std::error_code ec;
+    return std::filesystem::is_socket(std::filesystem::symlink_status(path, ec));
+#endif
+}
+
+static std::string errorResponse(const std::string& message) {
+    json::ObjectType obj;
+    obj["error"] = json::Value(message);
+    return json::Parser::stringify(json::Value(std::move(obj)));
+}
+
+QueryServer::QueryServer(std::vector<std::string> inputs, LoadOptions options, size_t workerCount)
+    : inputs(std::move(inputs)), options(options), workerCount(workerCount == 0 ? 1 : workerCount) {
+    reload();
+}
+
+QueryServer::~QueryServer() {
+    stopWorkers();
+}
+
+uint64_t QueryServer::reload() {
+    std::lock_guard<std::mutex> lock(reloadMutex);
+
+    // Новый снимок строится, пока запросы обслуживаются по старому
+    auto fresh = std::make_shared<AttendanceManager>();
+    if (options.dedup) fresh->enableDedup(options.dedupWindow);
+    ingest::loadInto(*fresh, inputs);
+    fresh->freeze();
+
+    // Старый снимок не ждём: его освободит тот, кто отпустит последнюю ссылку
+    // (здесь же, если запросов по нему нет)
+    snapshot.exchange(std::move(fresh));
+    return ++generation;
+}
+
+std::string QueryServer::handleRequest(const std::string& line) {
+    std::istringstream in(line);
+    std::string command;
+    in >> command;
+
+    try {
+        if (command == "reload") {
+            uint64_t published = reload();
+            json::ObjectType obj;
+            obj["status"] = json::Value("reloaded");
+            obj["generation"] = json::Value(static_cast<double>(published));
+            return json::Parser::stringify(json::Value(std::move(obj)));
+        }
+
+        // Снимок удерживается до конца запроса, даже если его уже подменили
+        std::shared_ptr<const AttendanceManager> manager = snapshot.load();
+
+        if (command == "stats") {
+            return json::Parser::stringify(manager->statsToJson());
+        }
+
+        if (command == "student") {
+            std::string name;
+            std::getline(in >> std::ws, name);
+            if (name.empty()) return errorResponse("Usage: student <name>");
+            return json::Parser::stringify(manager->studentToJson(name));
+        }
+
+        if (command == "range") {
+            std::string fromStr, toStr;
+            in >> fromStr >> toStr;
+            long long from = AttendanceManager::parseDateBound(fromStr, false);
+            long long to = AttendanceManager::parseDateBound(toStr, true);
+            if (from == 0 || to == 0) return errorResponse("Usage: range <from> <to>");
+            return json::Parser::stringify(manager->rangeToJson(from, to));
+        }
+    }
+    catch (const std::exception& e) {
+        return errorResponse(e.what());
+    }
+
+    return errorResponse("Unknown command: " + command);
+}
+
+bool QueryServer::receive(const std::shared_ptr<Client>& client, const char* data, size_t size) {
+    client->input.append(data, size);
+
+    std::vector<std::string> lines;
+    size_t start = 0, nl;
+    while ((nl = client->input.find('\n', start)) != std::string::npos) {
+        std::string line = client->input.substr(start, nl - start);
+        start = nl + 1;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) lines.push_back(std::move(line));
+    }
+    client->input.erase(0, start);
+    if (client->input.size() > MAX_LINE_BYTES) return false;
+    if (lines.empty()) return true;
+
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        for (auto& line : lines) client->lines.push_back(std::move(line));
+        if (!client->queued) {
+            client->queued = true;
+            readyClients.push_back(client);
+            wake = true;
+        }
+    }
+    if (wake) queueCv.notify_one();
+    return true;
+}
+
+void QueryServer::workerLoop() {
+    while (true) {
+        std::shared_ptr<Client> client;
+        std::string line;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCv.wait(lock, [this] { return stopping || !readyClients.empty(); });
+            if (stopping) return;
+            client = std::move(readyClients.front());
+            readyClients.pop_front();
+            line = std::move(client->lines.front());
+            client->lines.pop_front();
+        }
+
+        if (!client->broken && !sendAll(client->sock, handleRequest(line) + "\n")) {
+            client->broken = true;
+        }
+
+        // Следующая строка клиента — в конец очереди, чтобы не занимать
+        // обработчик одним клиентом
+        bool requeued = false;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (client->broken) client->lines.clear();
+            if (client->lines.empty()) {
+                client->queued = false;
+            }
+            else {
+                readyClients.push_back(std::move(client));
+                requeued = true;
+            }
+        }
+        if (requeued) queueCv.notify_one();
+    }
+}
+
+void QueryServer::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+        readyClients.clear();
+    }
+    queueCv.notify_all();
+    for (auto& t : workers) {
+        if (t.joinable()) t.join();
+    }
+    workers.clear();
+}
+
+void QueryServer::run(const std::string& socketPath) {
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+        throw std::runtime_error("WSAStartup failed");
+    }
+#else
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("Socket path too long: " + socketPath);
+    }
+    std::memcpy(addr.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    std::error_code ec;
+    if (std::filesystem::exists(std::filesystem::symlink_status(socketPath, ec))) {
+        if (!isSocketFile(socketPath)) {
+            throw std::runtime_error("Refusing to replace a file that is not a socket: " + socketPath);
+        }
+        std::filesystem::remove(socketPath, ec);
+    }
+
+    socket_t listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (!isValidSocket(listener)) {
+        throw std::runtime_error("Cannot create socket");
+    }
+
+    if (bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(listener, 64) != 0) {
+        closeSocket(listener);
+        throw std::runtime_error("Cannot bind socket: " + socketPath);
+    }
+
+    stopRequested = false;
+    stopping = false;
+    interrupted = false;
+    auto previousInt = std::signal(SIGINT, onInterrupt);
+    auto previousTerm = std::signal(SIGTERM, onInterrupt);
+
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&QueryServer::workerLoop, this);
+    }
+
+    std::cout << "Сервер слушает " << socketPath
+        << " (обработчиков: " << workerCount << ", Ctrl+C — выход)\n";
+
+    std::vector<std::shared_ptr<Client>> clients;
+    std::vector<std::shared_ptr<Client>> polled;
+    std::vector<pollfd_t> fds;
+    char buf[4096];
+    bool acceptFailing = false;
+
+    auto shutdown = [&]() {
+        stopWorkers();
+        clients.clear();
+        polled.clear();
+        closeSocket(listener);
+        std::filesystem::remove(socketPath, ec);
+        std::signal(SIGINT, previousInt);
+        std::signal(SIGTERM, previousTerm);
+    };
+
+    try {
+        while (!stopRequested && !interrupted) {
+            // Клиенты с полной очередью строк не читаются, пока её не разберут
+            fds.assign(1, pollfd_t{});
+            fds[0].fd = listener;
+            fds[0].events = POLLIN;
+            polled.clear();
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                for (const auto& client : clients) {
+                    if (client->lines.size() >= MAX_QUEUED_LINES) continue;
+                    pollfd_t entry{};
+                    entry.fd = client->sock;
+                    entry.events = POLLIN;
+                    fds.push_back(entry);
+                    polled.push_back(client);
+                }
+            }
+
+            int ready = pollSockets(fds.data(), fds.size(), POLL_MS);
+            if (ready < 0) {
+                if (pollInterrupted()) continue;
+                throw std::runtime_error("poll failed on socket: " + socketPath);
+            }
+            if (ready == 0) continue;
+
+            if (fds[0].revents & POLLIN) {
+                socket_t sock = accept(listener, nullptr, nullptr);
+                if (isValidSocket(sock)) {
+                    clients.push_back(std::make_shared<Client>(sock));
+                    acceptFailing = false;
+                }
+                else {
+                    // Ошибка повторится на следующем опросе: не крутиться впустую
+                    if (!acceptFailing) std::cerr << "Сервер: не удалось принять соединение, повтор\n";
+                    acceptFailing = true;
+                    std::this_thread::sleep_for(std::chrono::milliseconds(ACCEPT_RETRY_MS));
+                }
+            }
+
+            for (size_t i = 0; i < polled.size(); ++i) {
+                const auto& client = polled[i];
+                short events = fds[i + 1].revents;
+                if (events == 0) continue;
+
+                bool keep = !client->broken;
+                if (keep && (events & (POLLIN | POLLHUP | POLLERR))) {
+                    int n = static_cast<int>(recv(client->sock, buf, sizeof(buf), 0));
+                    keep = n > 0 && receive(client, buf, static_cast<size_t>(n));
+                }
+                else if (events & POLLNVAL) {
+                    keep = false;
+                }
+
+                // Клиент, чьи строки ещё обрабатываются, живёт до конца обработки
+                if (!keep) clients.erase(std::find(clients.begin(), clients.end(), client));
+            }
+        }
+    }
+    catch (...) {
+        shutdown();
+        throw;
+    }
+
+    shutdown();
+    std::cout << "Сервер остановлен\n";
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+﻿#include "../include/record_stream.hpp"
+#include "../include/utils.hpp"
+#include <stdexcept>
+
+// --- ObjectSplitter ---
+
+void ObjectSplitter::compact() {
+    size_t keep = depth > 0 ? objectStart : scanPos;
+    if (keep == 0) return;
+
+    buffer.erase(0, keep);
+    scanPos -= keep;
+    objectStart = depth > 0 ? 0 : scanPos;
+}
+
+void ObjectSplitter::feed(const char* data, size_t size) {
+    compact();
+    buffer.append(data, size);
+}
+
+bool ObjectSplitter::nextObject(std::string& out) {
+    while (scanPos < buffer.size()) {
+        char c = buffer[scanPos];
+
+        if (inString) {
+            if (escaped) escaped = false;
+            else if (c == '\\') escaped = true;
+            else if (c == '"') inString = false;
+        }
+        else if (c == '"') {
+            inString = true;
+        }
+        else if (c == '{') {
+            if (depth == 0) objectStart = scanPos;
+            depth++;
+        }
+        else if (c == '}' && depth > 0) {
+            depth--;
+            if (depth == 0) {
+                out.assign(buffer, objectStart, scanPos + 1 - objectStart);
+                scanPos++;
+                return true;
+            }
+        }
+
+        scanPos++;
+    }
+
+    return false;
+}
+
+// --- RecordStreamReader ---
+
+RecordStreamReader::RecordStreamReader(const std::string& filename, size_t blockSize)
+    : block(blockSize) {
+    std::string path = utils::getPath(filename);
+    in.open(path, std::ios::in | std::ios::binary);
+    if (!in.is_open()) throw std::runtime_error("Cannot open file: " + path);
+}
+
+bool RecordStreamReader::next(AttendanceRecord& out) {
+    while (true) {
+        if (splitter.nextObject(objectText)) {
+            objects++;
+            json::Value value = json::Parser::parse(objectText);
+            out = AttendanceManager::recordFromJson(value.asObject());
+            return true;
+        }
+
+        if (eof) return false;
+
+        in.read(block.data(), static_cast<std::streamsize>(block.size()));
+        size_t got = static_cast<size_t>(in.gcount());
+        if (got == 0) {
+            eof = true;
+            continue;
+        }
+        bytes += got;
+        splitter.feed(block.data(), got);
+    }
+}
\ No newline at end of file
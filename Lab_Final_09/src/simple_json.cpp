@@ -199,6 +199,60 @@ namespace json {
         return Value(arr);
     }
 
+    // Четыре шестнадцатеричные цифры после \u, pos — на последней из них
+    static unsigned readHex4(const std::string& str, size_t& pos) {
+        if (pos + 4 >= str.size()) {
+            throw std::runtime_error("Invalid unicode escape");
+        }
+        unsigned code = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = str[++pos];
+            code <<= 4;
+            if (c >= '0' && c <= '9') code |= static_cast<unsigned>(c - '0');
+            else if (c >= 'a' && c <= 'f') code |= static_cast<unsigned>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') code |= static_cast<unsigned>(c - 'A' + 10);
+            else throw std::runtime_error("Invalid unicode escape");
+        }
+        return code;
+    }
+
+    static void appendUtf8(std::string& out, unsigned code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        }
+        else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    // \uXXXX в UTF-8; суррогатная пара — один символ, одиночный суррогат — U+FFFD
+    static void appendUnicodeEscape(std::string& out, const std::string& str, size_t& pos) {
+        unsigned code = readHex4(str, pos);
+        if (code >= 0xD800 && code <= 0xDBFF
+            && pos + 2 < str.size() && str[pos + 1] == '\\' && str[pos + 2] == 'u') {
+            size_t next = pos + 2;
+            unsigned low = readHex4(str, next);
+            if (low >= 0xDC00 && low <= 0xDFFF) {
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                pos = next;
+            }
+        }
+        if (code >= 0xD800 && code <= 0xDFFF) code = 0xFFFD;
+        appendUtf8(out, code);
+    }
+
     Value Parser::parseString(const std::string& str, size_t& pos) {
         if (str[pos] != '"') {
             throw std::runtime_error("Expected '\"'");
@@ -224,7 +278,7 @@ namespace json {
                 case 'r': result += '\r'; break;
                 case 't': result += '\t'; break;
                 case 'u':
-                    result += "\\u";
+                    appendUnicodeEscape(result, str, pos);
                     break;
                 default:
                     result += str[pos];
@@ -305,6 +359,34 @@ namespace json {
         return val;
     }
 
+    void Parser::appendEscaped(std::string& out, std::string_view str) {
+        out += '"';
+
+        for (char c : str) {
+            switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (c >= 0 && c < 32) {
+                    char buf[7];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                }
+                else {
+                    out += c;
+                }
+                break;
+            }
+        }
+
+        out += '"';
+    }
+
     std::string Parser::stringify(const Value& value, int indent) {
         switch (value.getType()) {
         case Type::Null:
@@ -334,32 +416,8 @@ namespace json {
         }
 
         case Type::String: {
-            std::string str = value.asString();
-            std::string result = "\"";
-
-            for (char c : str) {
-                switch (c) {
-                case '"': result += "\\\""; break;
-                case '\\': result += "\\\\"; break;
-                case '\b': result += "\\b"; break;
-                case '\f': result += "\\f"; break;
-                case '\n': result += "\\n"; break;
-                case '\r': result += "\\r"; break;
-                case '\t': result += "\\t"; break;
-                default:
-                    if (c >= 0 && c < 32) {
-                        char buf[7];
-                        snprintf(buf, sizeof(buf), "\\u%04x", c);
-                        result += buf;
-                    }
-                    else {
-                        result += c;
-                    }
-                    break;
-                }
-            }
-
-            result += "\"";
+            std::string result;
+            appendEscaped(result, value.asString());
             return result;
         }
 
@@ -0,0 +1,205 @@
+﻿#include "../include/sketch.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+namespace sketch {
+
+    static uint64_t mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    uint64_t hashKey(std::string_view key) {
+        uint64_t h = 1469598103934665603ULL;
+        for (char c : key) {
+            h ^= static_cast<uint8_t>(c);
+            h *= 1099511628211ULL;
+        }
+        // У FNV-1a слабо перемешаны старшие биты, а HyperLogLog берёт из них номер регистра
+        return mix(h);
+    }
+
+    // --- HyperLogLog ---
+
+    HyperLogLog::HyperLogLog(uint32_t precision)
+        : precision(std::clamp<uint32_t>(precision, 4, 18)), registers(size_t(1) << this->precision, 0) {
+    }
+
+    void HyperLogLog::add(uint64_t hash) {
+        size_t index = static_cast<size_t>(hash >> (64 - precision));
+        uint64_t rest = hash << precision;
+        // Позиция первой единицы в оставшихся 64 - precision битах
+        uint8_t rank = rest == 0
+            ? static_cast<uint8_t>(64 - precision + 1)
+            : static_cast<uint8_t>(std::countl_zero(rest) + 1);
+        if (rank > registers[index]) registers[index] = rank;
+    }
+
+    void HyperLogLog::merge(const HyperLogLog& other) {
+        if (other.precision != precision) throw std::invalid_argument("HyperLogLog precision mismatch");
+        for (size_t i = 0; i < registers.size(); ++i) {
+            registers[i] = std::max(registers[i], other.registers[i]);
+        }
+    }
+
+    double HyperLogLog::estimate() const {
+        double m = static_cast<double>(registers.size());
+        double sum = 0.0;
+        size_t zeros = 0;
+        for (uint8_t r : registers) {
+            sum += std::ldexp(1.0, -static_cast<int>(r));
+            if (r == 0) zeros++;
+        }
+
+        double alpha = 0.7213 / (1.0 + 1.079 / m);
+        double raw = alpha * m * m / sum;
+
+        // На малых множествах точнее линейный подсчёт по пустым регистрам
+        if (raw <= 2.5 * m && zeros > 0) {
+            return m * std::log(m / static_cast<double>(zeros));
+        }
+        return raw;
+    }
+
+    double HyperLogLog::standardError() const {
+        return 1.04 / std::sqrt(static_cast<double>(registers.size()));
+    }
+
+    // --- CountMin ---
+
+    CountMin::CountMin(double epsilon, double delta) {
+        if (epsilon <= 0.0 || delta <= 0.0 || delta >= 1.0) {
+            throw std::invalid_argument("CountMin: epsilon > 0 and 0 < delta < 1 required");
+        }
+        width = static_cast<size_t>(std::ceil(std::exp(1.0) / epsilon));
+        depth = static_cast<size_t>(std::ceil(std::log(1.0 / delta)));
+        counters.assign(width * depth, 0);
+    }
+
+    void CountMin::add(uint64_t hash, uint64_t count) {
+        // Двойное хеширование: столбец в строке i = h1 + i * h2
+        uint64_t h2 = mix(hash) | 1;
+        for (size_t i = 0; i < depth; ++i) {
+            counters[i * width + (hash + i * h2) % width] += count;
+        }
+        sum += count;
+    }
+
+    uint64_t CountMin::estimate(uint64_t hash) const {
+        uint64_t h2 = mix(hash) | 1;
+        uint64_t best = UINT64_MAX;
+        for (size_t i = 0; i < depth; ++i) {
+            best = std::min(best, counters[i * width + (hash + i * h2) % width]);
+        }
+        return best;
+    }
+
+    void CountMin::merge(const CountMin& other) {
+        if (other.width != width || other.depth != depth) {
+            throw std::invalid_argument("CountMin dimensions mismatch");
+        }
+        for (size_t i = 0; i < counters.size(); ++i) counters[i] += other.counters[i];
+        sum += other.sum;
+    }
+
+    double CountMin::epsilon() const {
+        return std::exp(1.0) / static_cast<double>(width);
+    }
+
+    double CountMin::delta() const {
+        return std::exp(-static_cast<double>(depth));
+    }
+
+    // --- HeavyHitters ---
+
+    static bool heapOrder(const HeavyHitters::Item& a, const HeavyHitters::Item& b) {
+        return a.estimate > b.estimate;  // наверху кучи — наименьшая оценка
+    }
+
+    HeavyHitters::HeavyHitters(size_t capacity, double epsilon, double delta)
+        : capacity(std::clamp<size_t>(capacity, 1, MAX_CAPACITY)), sketch(epsilon, delta) {
+        heap.reserve(this->capacity);
+    }
+
+    void HeavyHitters::offer(std::string_view key, uint64_t hash, uint64_t estimate) {
+        // Кандидатов немного, линейный поиск дешевле хеш-таблицы
+        for (auto& item : heap) {
+            if (item.hash == hash && item.key == key) {
+                item.estimate = estimate;
+                std::make_heap(heap.begin(), heap.end(), heapOrder);
+                return;
+            }
+        }
+
+        if (heap.size() < capacity) {
+            heap.push_back({ std::string(key), hash, estimate });
+            std::push_heap(heap.begin(), heap.end(), heapOrder);
+            return;
+        }
+
+        if (estimate <= heap.front().estimate) return;
+        std::pop_heap(heap.begin(), heap.end(), heapOrder);
+        heap.back() = { std::string(key), hash, estimate };
+        std::push_heap(heap.begin(), heap.end(), heapOrder);
+    }
+
+    void HeavyHitters::add(std::string_view key, uint64_t count) {
+        uint64_t hash = hashKey(key);
+        sketch.add(hash, count);
+        offer(key, hash, sketch.estimate(hash));
+    }
+
+    void HeavyHitters::merge(const HeavyHitters& other) {
+        sketch.merge(other.sketch);
+
+        // Кандидаты обеих сторон переоцениваются по объединённому счётчику
+        std::vector<Item> candidates = std::move(heap);
+        candidates.insert(candidates.end(), other.heap.begin(), other.heap.end());
+        heap.clear();
+        for (const auto& item : candidates) offer(item.key, item.hash, sketch.estimate(item.hash));
+    }
+
+    std::vector<HeavyHitters::Item> HeavyHitters::top() const {
+        std::vector<Item> result = heap;
+        std::sort(result.begin(), result.end(), [](const Item& a, const Item& b) {
+            if (a.estimate != b.estimate) return a.estimate > b.estimate;
+            return a.key < b.key;
+        });
+        return result;
+    }
+
+    size_t HeavyHitters::memoryBytes() const {
+        size_t bytes = sketch.memoryBytes() + heap.capacity() * sizeof(Item);
+        for (const auto& item : heap) bytes += item.key.capacity();
+        return bytes;
+    }
+
+    // --- Summary ---
+
+    void Summary::add(const AttendanceRecord& rec) {
+        if (!AttendanceManager::isValid(rec)) {
+            rejected++;
+            return;
+        }
+        records++;
+        students.add(hashKey(rec.student));
+        if (rec.type == EventType::ABSENCE) {
+            absences++;
+            absentees.add(rec.student);
+        }
+    }
+
+    void Summary::merge(const Summary& other) {
+        students.merge(other.students);
+        absentees.merge(other.absentees);
+        records += other.records;
+        rejected += other.rejected;
+        absences += other.absences;
+    }
+}
\ No newline at end of file
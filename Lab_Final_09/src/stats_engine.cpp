@@ -0,0 +1,313 @@
+﻿#include "../include/stats_engine.hpp"
+#include "../include/thread_pool.hpp"
+#include "../include/utils.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+static const char SNAPSHOT_MAGIC[4] = { 'A', 'T', 'S', 'E' };
+static const uint32_t SNAPSHOT_VERSION = 3;
+
+// --- StudentState ---
+
+void StatsEngine::StudentState::push(const Event& e) {
+    events.push_back(e);
+    stat.absorb(e.epoch, e.type);
+    if (events.size() % CHECKPOINT_EVERY == 0) {
+        checkpoints.push_back(stat);
+        trim();
+    }
+}
+
+size_t StatsEngine::StudentState::replayFrom(size_t pos) {
+    // Ближайшая контрольная точка не дальше pos
+    size_t kept = std::min(pos / CHECKPOINT_EVERY, checkpoints.size());
+    checkpoints.resize(kept);
+    stat = kept > 0 ? checkpoints.back() : sealed;
+
+    size_t start = kept * CHECKPOINT_EVERY;
+    for (size_t i = start; i < events.size(); ++i) {
+        stat.absorb(events[i].epoch, events[i].type);
+        if ((i + 1) % CHECKPOINT_EVERY == 0) {
+            checkpoints.push_back(stat);
+        }
+    }
+    size_t replayedCount = events.size() - start;
+    trim();
+    return replayedCount;
+}
+
+void StatsEngine::StudentState::trim() {
+    // Первая контрольная точка становится свёрнутым агрегатом, её события уходят;
+    // остальные точки сдвигаются на CHECKPOINT_EVERY событий
+    while (checkpoints.size() > RETAINED_EVENTS / CHECKPOINT_EVERY) {
+        sealed = checkpoints.front();
+        sealedUntil = events[CHECKPOINT_EVERY - 1].epoch;
+        events.erase(events.begin(), events.begin() + CHECKPOINT_EVERY);
+        checkpoints.erase(checkpoints.begin());
+    }
+}
+
+// --- StatsEngine ---
+
+StatsEngine::AddResult StatsEngine::add(const std::string& student, long long epoch, EventType type) {
+    StudentState& state = students[student];
+    Event e{ epoch, type };
+
+    if (epoch < state.sealedUntil) return AddResult::Stale;
+
+    if (state.events.empty() || state.events.back().epoch <= epoch) {
+        state.push(e);
+        return AddResult::Appended;
+    }
+
+    // Опоздавшее событие: вставка после всех событий с тем же временем
+    auto it = std::upper_bound(state.events.begin(), state.events.end(), epoch,
+        [](long long value, const Event& ev) { return value < ev.epoch; });
+    size_t pos = static_cast<size_t>(it - state.events.begin());
+    state.events.insert(it, e);
+    replayed += state.replayFrom(pos);
+    return AddResult::Replayed;
+}
+
+void StatsEngine::rebuild(
+    const std::unordered_map<std::string, std::vector<const AttendanceRecord*>>& grouped) {
+    students.clear();
+    students.reserve(grouped.size());
+
+    // Ключи вставляются последовательно, состояния заполняются параллельно
+    std::vector<std::pair<StudentState*, const std::vector<const AttendanceRecord*>*>> work;
+    work.reserve(grouped.size());
+    for (const auto& [student, rows] : grouped) {
+        work.emplace_back(&students[student], &rows);
+    }
+
+    ThreadPool::instance().parallelFor(0, work.size(), 1, [&](size_t lo, size_t hi) {
+        for (size_t w = lo; w < hi; ++w) {
+            StudentState& state = *work[w].first;
+            state.events.reserve(std::min(work[w].second->size(), RETAINED_EVENTS + CHECKPOINT_EVERY));
+            for (const auto* rec : *work[w].second) {
+                state.push({ rec->epoch, rec->type });
+            }
+        }
+    });
+
+    replayed = 0;
+}
+
+void StatsEngine::merge(StatsEngine&& other) {
+    // Проверка до изменений: свёрнутые события не восстановить, поэтому их
+    // можно только перенести целиком, а новые события — только в хвост
+    for (const auto& [student, theirs] : other.students) {
+        auto found = students.find(student);
+        if (found == students.end()) continue;
+        if (theirs.sealed.totalRecords > 0) {
+            throw std::runtime_error("Cannot merge stats: both engines have sealed history for student " + student);
+        }
+        if (!theirs.events.empty() && theirs.events.front().epoch < found->second.sealedUntil) {
+            throw std::runtime_error("Cannot merge stats: events predate the retained history for student " + student);
+        }
+    }
+
+    for (auto& [student, theirs] : other.students) {
+        auto found = students.find(student);
+        if (found == students.end()) {
+            students.emplace(student, std::move(theirs));
+            continue;
+        }
+
+        StudentState& ours = found->second;
+        if (theirs.events.empty()) continue;
+
+        if (ours.events.empty() || ours.events.back().epoch <= theirs.events.front().epoch) {
+            for (const auto& e : theirs.events) ours.push(e);
+            continue;
+        }
+
+        // Наборы перекрываются по времени: слияние и пересчёт с первой вставки
+        auto firstInsert = std::upper_bound(ours.events.begin(), ours.events.end(),
+            theirs.events.front().epoch,
+            [](long long value, const Event& ev) { return value < ev.epoch; });
+        size_t pos = static_cast<size_t>(firstInsert - ours.events.begin());
+
+        std::vector<Event> merged;
+        merged.reserve(ours.events.size() + theirs.events.size());
+        std::merge(ours.events.begin(), ours.events.end(),
+            theirs.events.begin(), theirs.events.end(), std::back_inserter(merged),
+            [](const Event& a, const Event& b) { return a.epoch < b.epoch; });
+        ours.events = std::move(merged);
+        replayed += ours.replayFrom(pos);
+    }
+
+    replayed += other.replayed;
+    other.clear();
+}
+
+void StatsEngine::clear() {
+    students.clear();
+    replayed = 0;
+}
+
+const StudentStat* StatsEngine::find(const std::string& student) const {
+    auto found = students.find(student);
+    return found == students.end() ? nullptr : &found->second.stat;
+}
+
+size_t StatsEngine::eventCount() const {
+    size_t total = 0;
+    for (const auto& [_, state] : students) total += static_cast<size_t>(state.stat.totalRecords);
+    return total;
+}
+
+size_t StatsEngine::retainedEvents() const {
+    size_t total = 0;
+    for (const auto& [_, state] : students) total += state.events.size();
+    return total;
+}
+
+std::map<std::string, StudentStat> StatsEngine::snapshot() const {
+    std::map<std::string, StudentStat> result;
+    for (const auto& [student, state] : students) {
+        result.emplace(student, state.stat);
+    }
+    return result;
+}
+
+// --- Snapshot ---
+
+template <typename T>
+static void writePod(std::ofstream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static T readPod(std::ifstream& in) {
+    T value{};
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    if (!in) throw std::runtime_error("Truncated stats snapshot");
+    return value;
+}
+
+void StatsEngine::save(const std::string& filename) const {
+    std::string path = utils::getPath(filename);
+    std::ofstream out(path, std::ios::out | std::ios::binary);
+    if (!out.is_open()) throw std::runtime_error("Cannot open file for writing: " + path);
+
+    out.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    writePod(out, SNAPSHOT_VERSION);
+    writePod(out, static_cast<uint64_t>(students.size()));
+
+    // Студенты по имени, чтобы снимок не зависел от порядка хеш-таблицы
+    std::vector<const std::pair<const std::string, StudentState>*> ordered;
+    ordered.reserve(students.size());
+    for (const auto& entry : students) ordered.push_back(&entry);
+    std::sort(ordered.begin(), ordered.end(),
+        [](const auto* a, const auto* b) { return a->first < b->first; });
+
+    // Фильтр Блума по именам идёт сразу за заголовком: его можно прочитать
+    // без загрузки событий (readBloom)
+    BloomFilter bloom(students.size());
+    for (const auto* entry : ordered) bloom.add(entry->first);
+    bloom.write(out);
+
+    for (const auto* entry : ordered) {
+        writePod(out, static_cast<uint32_t>(entry->first.size()));
+        out.write(entry->first.data(), static_cast<std::streamsize>(entry->first.size()));
+
+        const StudentState& state = entry->second;
+        writePod(out, static_cast<int64_t>(state.sealed.absences));
+        writePod(out, state.sealed.hoursPresent);
+        writePod(out, static_cast<int64_t>(state.sealed.lastIn));
+        writePod(out, static_cast<int64_t>(state.sealed.totalRecords));
+        writePod(out, static_cast<int64_t>(state.sealedUntil));
+
+        writePod(out, static_cast<uint64_t>(state.events.size()));
+        for (const auto& e : state.events) {
+            writePod(out, static_cast<int64_t>(e.epoch));
+            writePod(out, static_cast<uint8_t>(e.type));
+        }
+    }
+
+    out.flush();
+    if (!out) throw std::runtime_error("Write failed: " + path);
+}
+
+// Открыть снимок и проверить заголовок; возвращает число студентов
+static uint64_t openSnapshot(std::ifstream& in, const std::string& path) {
+    in.open(path, std::ios::in | std::ios::binary);
+    if (!in.is_open()) throw std::runtime_error("Cannot open file: " + path);
+
+    char magic[4];
+    in.read(magic, sizeof(magic));
+    if (!in || std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0) {
+        throw std::runtime_error("Not a stats snapshot: " + path);
+    }
+    if (readPod<uint32_t>(in) != SNAPSHOT_VERSION) {
+        throw std::runtime_error("Unsupported stats snapshot version: " + path);
+    }
+    return readPod<uint64_t>(in);
+}
+
+BloomFilter StatsEngine::readBloom(const std::string& filename) {
+    std::ifstream in;
+    openSnapshot(in, utils::getPath(filename));
+    return BloomFilter::read(in);
+}
+
+StatsEngine StatsEngine::load(const std::string& filename) {
+    std::string path = utils::getPath(filename);
+    std::ifstream in;
+    uint64_t studentCount = openSnapshot(in, path);
+    BloomFilter::read(in);
+
+    // Все счётчики из файла сверяются с оставшимся размером до выделения памяти
+    const uint64_t fileSize = std::filesystem::file_size(path);
+    auto remaining = [&in, fileSize]() -> uint64_t {
+        auto pos = in.tellg();
+        if (pos < 0 || static_cast<uint64_t>(pos) > fileSize) return 0;
+        return fileSize - static_cast<uint64_t>(pos);
+    };
+    auto fail = [&path]() { throw std::runtime_error("Corrupted stats snapshot: " + path); };
+
+    const uint64_t stateBytes = 5 * sizeof(int64_t);
+    const uint64_t eventBytes = sizeof(int64_t) + sizeof(uint8_t);
+    const uint64_t minStudentBytes = sizeof(uint32_t) + stateBytes + sizeof(uint64_t);
+    if (studentCount > remaining() / minStudentBytes) fail();
+
+    StatsEngine engine;
+    engine.students.reserve(static_cast<size_t>(studentCount));
+
+    for (uint64_t s = 0; s < studentCount; ++s) {
+        uint32_t nameLength = readPod<uint32_t>(in);
+        if (nameLength > remaining()) fail();
+        std::string name(nameLength, '\0');
+        in.read(name.data(), static_cast<std::streamsize>(name.size()));
+        if (!in) fail();
+
+        auto [it, inserted] = engine.students.try_emplace(std::move(name));
+        if (!inserted) fail();
+        StudentState& state = it->second;
+
+        state.sealed.absences = static_cast<int>(readPod<int64_t>(in));
+        state.sealed.hoursPresent = readPod<double>(in);
+        state.sealed.lastIn = readPod<int64_t>(in);
+        state.sealed.totalRecords = static_cast<int>(readPod<int64_t>(in));
+        state.sealedUntil = readPod<int64_t>(in);
+        state.stat = state.sealed;
+
+        uint64_t eventCount = readPod<uint64_t>(in);
+        if (eventCount > remaining() / eventBytes) fail();
+        state.events.reserve(static_cast<size_t>(std::min<uint64_t>(eventCount, RETAINED_EVENTS + CHECKPOINT_EVERY)));
+        for (uint64_t i = 0; i < eventCount; ++i) {
+            long long epoch = readPod<int64_t>(in);
+            auto type = readPod<uint8_t>(in);
+            if (type > static_cast<uint8_t>(EventType::UNKNOWN)) fail();
+            if (epoch < state.sealedUntil || (!state.events.empty() && epoch < state.events.back().epoch)) fail();
+            state.push({ epoch, static_cast<EventType>(type) });
+        }
+    }
+
+    return engine;
+}
\ No newline at end of file
@@ -0,0 +1,180 @@
+﻿#include "../include/student_dictionary.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+// --- StudentDictionary ---
+
+uint32_t StudentDictionary::intern(std::string_view name) {
+    auto found = ids.find(name);
+    if (found != ids.end()) return found->second;
+
+    uint32_t id = static_cast<uint32_t>(names.size());
+    names.emplace_back(name);
+    ids.emplace(std::string_view(names.back()), id);
+    return id;
+}
+
+uint32_t StudentDictionary::find(std::string_view name) const {
+    auto found = ids.find(name);
+    return found == ids.end() ? NOT_FOUND : found->second;
+}
+
+void StudentDictionary::clear() {
+    ids.clear();
+    names.clear();
+}
+
+// Кодовые точки UTF-8, чтобы кириллическая буква считалась одним символом
+static std::u32string decodeUtf8(std::string_view s) {
+    std::u32string out;
+    out.reserve(s.size());
+    for (size_t i = 0; i < s.size();) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        size_t len = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xE ? 3 : (c >> 3) == 0x1E ? 4 : 1;
+        char32_t cp = len == 1 ? c : len == 2 ? (c & 0x1F) : len == 3 ? (c & 0x0F) : (c & 0x07);
+        for (size_t k = 1; k < len && i + k < s.size(); ++k) {
+            cp = (cp << 6) | (static_cast<unsigned char>(s[i + k]) & 0x3F);
+        }
+        out.push_back(cp);
+        i += len;
+    }
+    return out;
+}
+
+// Расстояние Левенштейна с отсечением: больше limit не считается точно
+static size_t levenshtein(const std::u32string& a, const std::u32string& b, size_t limit) {
+    size_t diff = a.size() > b.size() ? a.size() - b.size() : b.size() - a.size();
+    if (diff > limit) return limit + 1;
+
+    std::vector<size_t> prev(b.size() + 1), cur(b.size() + 1);
+    for (size_t j = 0; j <= b.size(); ++j) prev[j] = j;
+
+    for (size_t i = 1; i <= a.size(); ++i) {
+        cur[0] = i;
+        size_t rowMin = cur[0];
+        for (size_t j = 1; j <= b.size(); ++j) {
+            size_t cost = a[i - 1] == b[j - 1] ? 0 : 1;
+            cur[j] = std::min({ prev[j] + 1, cur[j - 1] + 1, prev[j - 1] + cost });
+            rowMin = std::min(rowMin, cur[j]);
+        }
+        if (rowMin > limit) return limit + 1;
+        std::swap(prev, cur);
+    }
+    return prev[b.size()];
+}
+
+std::vector<std::string> StudentDictionary::suggest(std::string_view query, size_t limit) const {
+    std::u32string q = decodeUtf8(query);
+    if (q.empty() || limit == 0) return {};
+
+    size_t maxDistance = std::max<size_t>(2, q.size() / 3);
+    std::vector<std::pair<size_t, const std::string*>> candidates;
+
+    for (const auto& name : names) {
+        if (name.size() > query.size() && name.compare(0, query.size(), query) == 0) {
+            candidates.emplace_back(0, &name);
+            continue;
+        }
+        size_t d = levenshtein(q, decodeUtf8(name), maxDistance);
+        if (d <= maxDistance) candidates.emplace_back(d, &name);
+    }
+
+    size_t take = std::min(limit, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + take, candidates.end(),
+        [](const auto& a, const auto& b) {
+            if (a.first != b.first) return a.first < b.first;
+            return *a.second < *b.second;
+        });
+
+    std::vector<std::string> result;
+    result.reserve(take);
+    for (size_t i = 0; i < take; ++i) result.push_back(*candidates[i].second);
+    return result;
+}
+
+// --- BloomFilter ---
+
+static uint64_t fnv1a(std::string_view s) {
+    uint64_t h = 1469598103934665603ULL;
+    for (char c : s) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+BloomFilter::BloomFilter(size_t expectedItems, double falsePositiveRate) {
+    double n = static_cast<double>(std::max<size_t>(expectedItems, 1));
+    double ln2 = std::log(2.0);
+    double m = -n * std::log(falsePositiveRate) / (ln2 * ln2);
+    size_t words = std::max<size_t>(1, static_cast<size_t>(std::ceil(m / 64.0)));
+    bits.assign(words, 0);
+    hashes = static_cast<uint32_t>(std::max(1.0, std::round(words * 64.0 / n * ln2)));
+}
+
+void BloomFilter::add(std::string_view key) {
+    if (bits.empty()) return;
+    // Двойное хеширование: i-я позиция = h1 + i * h2
+    uint64_t h1 = fnv1a(key);
+    uint64_t h2 = mix(h1) | 1;
+    uint64_t total = bitCount();
+    for (uint32_t i = 0; i < hashes; ++i) {
+        uint64_t bit = (h1 + i * h2) % total;
+        bits[bit / 64] |= 1ULL << (bit % 64);
+    }
+}
+
+bool BloomFilter::mightContain(std::string_view key) const {
+    if (bits.empty()) return true;
+    uint64_t h1 = fnv1a(key);
+    uint64_t h2 = mix(h1) | 1;
+    uint64_t total = bitCount();
+    for (uint32_t i = 0; i < hashes; ++i) {
+        uint64_t bit = (h1 + i * h2) % total;
+        if ((bits[bit / 64] & (1ULL << (bit % 64))) == 0) return false;
+    }
+    return true;
+}
+
+void BloomFilter::write(std::ostream& out) const {
+    uint64_t words = bits.size();
+    out.write(reinterpret_cast<const char*>(&hashes), sizeof(hashes));
+    out.write(reinterpret_cast<const char*>(&words), sizeof(words));
+    out.write(reinterpret_cast<const char*>(bits.data()),
+        static_cast<std::streamsize>(words * sizeof(uint64_t)));
+}
+
+BloomFilter BloomFilter::read(std::istream& in) {
+    BloomFilter filter;
+    uint64_t words = 0;
+    in.read(reinterpret_cast<char*>(&filter.hashes), sizeof(filter.hashes));
+    in.read(reinterpret_cast<char*>(&words), sizeof(words));
+    if (!in || words > (1ULL << 32)) throw std::runtime_error("Corrupted Bloom filter");
+
+    // Размер из файла не больше оставшихся байт потока (если поток позиционируемый)
+    auto pos = in.tellg();
+    if (pos >= 0) {
+        in.seekg(0, std::ios::end);
+        auto end = in.tellg();
+        in.seekg(pos);
+        if (end >= pos && words > static_cast<uint64_t>(end - pos) / sizeof(uint64_t)) {
+            throw std::runtime_error("Truncated Bloom filter");
+        }
+    }
+
+    filter.bits.resize(static_cast<size_t>(words));
+    in.read(reinterpret_cast<char*>(filter.bits.data()),
+        static_cast<std::streamsize>(words * sizeof(uint64_t)));
+    if (!in) throw std::runtime_error("Truncated Bloom filter");
+    return filter;
+}
\ No newline at end of file
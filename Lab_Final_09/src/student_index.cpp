@@ -0,0 +1,224 @@
+﻿#include "../include/student_index.hpp"
+#include "../include/utils.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <climits>
+
+static const char INDEX_MAGIC[4] = { 'A', 'T', 'I', 'X' };
+static const uint32_t INDEX_VERSION = 1;
+
+// Поля хранятся в порядке байтов платформы, как и в снимке статистики
+struct IndexHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    uint64_t studentCount;
+    uint64_t recordCount;
+    uint64_t namesOffset;       // от начала файла
+    uint64_t dataOffset;        // от начала файла
+    uint64_t reserved;
+};
+
+struct IndexEntry {
+    uint64_t nameOffset;        // от начала блока имён
+    uint32_t nameLength;
+    uint32_t rowCount;
+    uint64_t dataBegin;         // от начала блока строк
+    uint64_t dataEnd;
+};
+
+static_assert(sizeof(IndexHeader) == 64, "IndexHeader layout");
+static_assert(sizeof(IndexEntry) == 32, "IndexEntry layout");
+
+// Размер и время изменения файла данных: по ним индекс признаётся устаревшим
+static bool sourceIdentity(const std::string& dataFile, uint64_t& size, int64_t& time) {
+    std::error_code ec;
+    std::string path = utils::getPath(dataFile);
+    size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    time = static_cast<int64_t>(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+    return !ec;
+}
+
+std::string StudentIndex::pathFor(const std::string& dataFile) {
+    return dataFile + ".idx";
+}
+
+void StudentIndex::write(const std::string& indexFile, const std::string& dataFile,
+    const std::unordered_map<std::string, std::vector<const AttendanceRecord*>>& grouped) {
+    std::vector<const std::pair<const std::string, std::vector<const AttendanceRecord*>>*> ordered;
+    ordered.reserve(grouped.size());
+    for (const auto& entry : grouped) ordered.push_back(&entry);
+    std::sort(ordered.begin(), ordered.end(),
+        [](const auto* a, const auto* b) { return a->first < b->first; });
+
+    std::vector<IndexEntry> entries(ordered.size());
+    std::string names;
+    std::string rows;
+    uint64_t recordCount = 0;
+
+    for (size_t i = 0; i < ordered.size(); ++i) {
+        const auto& [student, recs] = *ordered[i];
+        if (recs.size() > UINT32_MAX || student.size() > UINT32_MAX) {
+            throw std::runtime_error("Too many records of one student for the index: " + student);
+        }
+        IndexEntry& e = entries[i];
+        e.nameOffset = names.size();
+        e.nameLength = static_cast<uint32_t>(student.size());
+        e.rowCount = static_cast<uint32_t>(recs.size());
+        e.dataBegin = rows.size();
+        names += student;
+
+        for (const auto* rec : recs) {
+            uint16_t tsLength = static_cast<uint16_t>(std::min<size_t>(rec->timestamp.size(), 0xFFFF));
+            int64_t epoch = rec->epoch;
+            rows += static_cast<char>(rec->type);
+            rows.append(reinterpret_cast<const char*>(&epoch), sizeof(epoch));
+            rows.append(reinterpret_cast<const char*>(&tsLength), sizeof(tsLength));
+            rows.append(rec->timestamp.data(), tsLength);
+        }
+        e.dataEnd = rows.size();
+        recordCount += recs.size();
+    }
+
+    IndexHeader header{};
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+    if (!sourceIdentity(dataFile, header.sourceSize, header.sourceTime)) {
+        throw std::runtime_error("Cannot stat data file: " + utils::getPath(dataFile));
+    }
+    header.studentCount = entries.size();
+    header.recordCount = recordCount;
+    header.namesOffset = sizeof(IndexHeader) + entries.size() * sizeof(IndexEntry);
+    header.dataOffset = header.namesOffset + names.size();
+
+    // Запись во временный файл и переименование: читатель не увидит
+    // наполовину записанный индекс
+    std::string path = utils::getPath(indexFile);
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) throw std::runtime_error("Cannot open file for writing: " + tmpPath);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(entries.data()),
+            static_cast<std::streamsize>(entries.size() * sizeof(IndexEntry)));
+        out.write(names.data(), static_cast<std::streamsize>(names.size()));
+        out.write(rows.data(), static_cast<std::streamsize>(rows.size()));
+        out.flush();
+        if (!out) throw std::runtime_error("Write failed: " + tmpPath);
+    }
+    std::filesystem::rename(tmpPath, path);
+}
+
+bool StudentIndex::open(const std::string& indexFile, const std::string& dataFile) {
+    std::string path = utils::getPath(indexFile);
+    if (!std::filesystem::exists(path)) return false;
+
+    try {
+        file = MappedFile(path);
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+
+    IndexHeader header;
+    if (file.size() < sizeof(header)) {
+        file = MappedFile();
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    uint64_t size = 0;
+    int64_t time = 0;
+    bool valid = std::memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0
+        && header.version == INDEX_VERSION
+        && header.studentCount <= (file.size() - sizeof(IndexHeader)) / sizeof(IndexEntry)
+        && header.namesOffset == sizeof(IndexHeader) + header.studentCount * sizeof(IndexEntry)
+        && header.namesOffset <= header.dataOffset && header.dataOffset <= file.size()
+        && sourceIdentity(dataFile, size, time)
+        && size == header.sourceSize && time == header.sourceTime;
+
+    // Каталог проверяется целиком: имя и строки каждого студента должны
+    // лежать в своих блоках, иначе обрезанный или испорченный файл читался бы
+    // за пределами отображения
+    const uint64_t namesSize = header.dataOffset - header.namesOffset;
+    const uint64_t rowsSize = file.size() - header.dataOffset;
+    const uint64_t minRow = 1 + sizeof(int64_t) + sizeof(uint16_t);
+    for (uint64_t i = 0; valid && i < header.studentCount; ++i) {
+        IndexEntry e;
+        std::memcpy(&e, file.data() + sizeof(IndexHeader) + i * sizeof(IndexEntry), sizeof(e));
+        valid = e.nameOffset <= namesSize && e.nameLength <= namesSize - e.nameOffset
+            && e.dataBegin <= e.dataEnd && e.dataEnd <= rowsSize
+            && e.rowCount <= (e.dataEnd - e.dataBegin) / minRow;
+    }
+
+    if (!valid) {
+        file = MappedFile();
+        return false;
+    }
+
+    students = static_cast<size_t>(header.studentCount);
+    records = static_cast<size_t>(header.recordCount);
+    namesOffset = header.namesOffset;
+    dataOffset = header.dataOffset;
+    return true;
+}
+
+static IndexEntry entryAt(const MappedFile& file, size_t i) {
+    IndexEntry e;
+    std::memcpy(&e, file.data() + sizeof(IndexHeader) + i * sizeof(IndexEntry), sizeof(e));
+    return e;
+}
+
+std::string_view StudentIndex::nameAt(size_t i) const {
+    IndexEntry e = entryAt(file, i);
+    return { file.data() + namesOffset + e.nameOffset, e.nameLength };
+}
+
+bool StudentIndex::find(std::string_view student, std::vector<AttendanceRecord>& out) const {
+    out.clear();
+
+    // Бинарный поиск по отсортированному каталогу: читаются O(log n) записей
+    size_t lo = 0, hi = studentCount();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (nameAt(mid) < student) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == studentCount() || nameAt(lo) != student) return false;
+
+    IndexEntry e = entryAt(file, lo);
+    const char* p = file.data() + dataOffset + e.dataBegin;
+    const char* end = file.data() + dataOffset + e.dataEnd;
+    if (end > file.data() + file.size()) throw std::runtime_error("Corrupted student index");
+
+    out.reserve(e.rowCount);
+    // Строка: тип (1 байт), epoch (8), длина метки (2), метка времени
+    const size_t fixed = 1 + sizeof(int64_t) + sizeof(uint16_t);
+    while (p + fixed <= end) {
+        AttendanceRecord rec;
+        rec.student = std::string(student);
+        rec.type = static_cast<EventType>(static_cast<uint8_t>(p[0]));
+        int64_t epoch;
+        uint16_t tsLength;
+        std::memcpy(&epoch, p + 1, sizeof(epoch));
+        std::memcpy(&tsLength, p + 1 + sizeof(epoch), sizeof(tsLength));
+        p += fixed;
+        if (p + tsLength > end) throw std::runtime_error("Corrupted student index");
+        rec.timestamp.assign(p, tsLength);
+        rec.epoch = epoch;
+        p += tsLength;
+        out.push_back(std::move(rec));
+    }
+    return true;
+}
+
+std::vector<std::string> StudentIndex::names() const {
+    std::vector<std::string> result;
+    result.reserve(studentCount());
+    for (size_t i = 0; i < studentCount(); ++i) result.emplace_back(nameAt(i));
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,186 @@
+﻿#include "../include/table_writer.hpp"
+#include "../include/simple_json.hpp"
+#include <charconv>
+#include <cmath>
+
+// Число символов UTF-8 (байты продолжения не считаются)
+static size_t displayWidth(std::string_view s) {
+    size_t chars = 0;
+    for (char c : s) {
+        if ((c & 0xC0) != 0x80) chars++;
+    }
+    return chars;
+}
+
+TableWriter::TableWriter(std::ostream& out, std::vector<Column> columns,
+    Format format, size_t flushBytes)
+    : out(out), columns(std::move(columns)), format(format), flushBytes(flushBytes) {
+    buf.reserve(flushBytes + 256);
+}
+
+TableWriter::~TableWriter() {
+    try {
+        finish();
+    }
+    catch (...) {
+    }
+}
+
+bool TableWriter::parseFormat(const std::string& s, Format& out) {
+    if (s == "text") out = Format::Text;
+    else if (s == "csv") out = Format::Csv;
+    else if (s == "tsv") out = Format::Tsv;
+    else if (s == "json") out = Format::Json;
+    else return false;
+    return true;
+}
+
+void TableWriter::header() {
+    if (format == Format::Json) {
+        buf += '[';
+        opened = true;
+        return;
+    }
+
+    for (const auto& col : columns) {
+        cell(std::string_view(col.title));
+    }
+    endRow();
+}
+
+void TableWriter::beginCell() {
+    switch (format) {
+    case Format::Json:
+        if (column == 0) {
+            if (rows > 0) buf += ',';
+            buf += '{';
+        }
+        else {
+            buf += ',';
+        }
+        json::Parser::appendEscaped(buf, columns[column].title);
+        buf += ':';
+        break;
+    case Format::Csv:
+        if (column > 0) buf += ',';
+        break;
+    case Format::Tsv:
+        if (column > 0) buf += '\t';
+        break;
+    case Format::Text:
+        break;
+    }
+}
+
+void TableWriter::appendRaw(std::string_view s) {
+    beginCell();
+    buf.append(s);
+    if (format == Format::Text) {
+        size_t width = static_cast<size_t>(columns[column].width);
+        size_t shown = displayWidth(s);
+        if (shown < width) buf.append(width - shown, ' ');
+    }
+    column++;
+}
+
+TableWriter& TableWriter::cell(std::string_view s) {
+    switch (format) {
+    case Format::Json:
+        beginCell();
+        json::Parser::appendEscaped(buf, s);
+        column++;
+        break;
+
+    case Format::Csv:
+        if (s.find_first_of(",\"\n\r") == std::string_view::npos) {
+            appendRaw(s);
+            break;
+        }
+        beginCell();
+        buf += '"';
+        for (char c : s) {
+            if (c == '"') buf += '"';
+            buf += c;
+        }
+        buf += '"';
+        column++;
+        break;
+
+    case Format::Tsv:
+        beginCell();
+        for (char c : s) {
+            buf += (c == '\t' || c == '\n' || c == '\r') ? ' ' : c;
+        }
+        column++;
+        break;
+
+    case Format::Text:
+        appendRaw(s);
+        break;
+    }
+    return *this;
+}
+
+TableWriter& TableWriter::cell(long long v) {
+    char tmp[32];
+    auto res = std::to_chars(tmp, tmp + sizeof(tmp), v);
+    appendRaw(std::string_view(tmp, static_cast<size_t>(res.ptr - tmp)));
+    return *this;
+}
+
+TableWriter& TableWriter::cell(double v, int precision) {
+    // Нечисловые значения — строкой, иначе в Json вышел бы неразбираемый inf
+    if (!std::isfinite(v)) {
+        return cell(std::string_view(std::isnan(v) ? "nan" : v > 0 ? "inf" : "-inf"));
+    }
+    char tmp[400];
+    auto res = std::to_chars(tmp, tmp + sizeof(tmp), v, std::chars_format::fixed, precision);
+    if (res.ec != std::errc()) {
+        return cell(std::string_view("nan"));
+    }
+    appendRaw(std::string_view(tmp, static_cast<size_t>(res.ptr - tmp)));
+    return *this;
+}
+
+void TableWriter::endRow() {
+    if (format == Format::Json) {
+        if (column > 0) buf += '}';
+    }
+    else {
+        buf += '\n';
+    }
+    column = 0;
+    rows++;
+    flushIfFull();
+}
+
+void TableWriter::rule(size_t width, char c) {
+    if (format != Format::Text) return;
+    buf.append(width, c);
+    buf += '\n';
+}
+
+void TableWriter::text(std::string_view s) {
+    if (format != Format::Text) return;
+    buf.append(s);
+    flushIfFull();
+}
+
+void TableWriter::flushIfFull() {
+    if (buf.size() >= flushBytes) {
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+        buf.clear();
+    }
+}
+
+void TableWriter::finish() {
+    if (finished) return;
+    finished = true;
+
+    if (format == Format::Json) {
+        buf += opened ? "]\n" : "[]\n";
+    }
+    out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    buf.clear();
+    out.flush();
+}
\ No newline at end of file
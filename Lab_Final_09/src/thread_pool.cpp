@@ -0,0 +1,170 @@
+﻿#include "../include/thread_pool.hpp"
+#include <algorithm>
+#include <exception>
+#include <chrono>
+
+// Индекс рабочего потока текущего пула (-1 — внешний поток)
+static thread_local int currentWorker = -1;
+static thread_local const ThreadPool* currentPool = nullptr;
+
+std::unique_ptr<ThreadPool>& ThreadPool::holder() {
+    static std::unique_ptr<ThreadPool> pool;
+    return pool;
+}
+
+ThreadPool& ThreadPool::instance() {
+    auto& pool = holder();
+    if (!pool) configure(0);
+    return *pool;
+}
+
+void ThreadPool::configure(size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    auto& pool = holder();
+    pool.reset();
+    pool.reset(new ThreadPool(threads));
+}
+
+ThreadPool::ThreadPool(size_t threads) {
+    size_t workerCount = threads > 1 ? threads - 1 : 0;
+    for (size_t i = 0; i < workerCount; ++i) {
+        queues.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    stopping = true;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    sleepCv.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+void ThreadPool::submit(Task task, const void* batch) {
+    size_t index = (currentPool == this && currentWorker >= 0)
+        ? static_cast<size_t>(currentWorker)
+        : nextQueue.fetch_add(1) % queues.size();
+
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back({ std::move(task), batch });
+    }
+    pending.fetch_add(1);
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    sleepCv.notify_one();
+}
+
+bool ThreadPool::runOneTask(const void* batch) {
+    if (pending.load() == 0) return false;
+
+    Task task;
+    size_t n = queues.size();
+    int self = (currentPool == this) ? currentWorker : -1;
+
+    // Задача из очереди: с конца или с начала; при заданном batch —
+    // ближайшая к этому краю задача того же вызова parallelFor
+    auto take = [batch, &task](Worker& worker, bool fromBack) {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        auto& jobs = worker.tasks;
+        if (jobs.empty()) return;
+        if (!batch) {
+            auto& job = fromBack ? jobs.back() : jobs.front();
+            task = std::move(job.task);
+            if (fromBack) jobs.pop_back();
+            else jobs.pop_front();
+            return;
+        }
+        for (size_t k = 0; k < jobs.size(); ++k) {
+            size_t i = fromBack ? jobs.size() - 1 - k : k;
+            if (jobs[i].batch != batch) continue;
+            task = std::move(jobs[i].task);
+            jobs.erase(jobs.begin() + static_cast<std::ptrdiff_t>(i));
+            return;
+        }
+    };
+
+    // Сначала своя очередь (с конца), затем чужие (с начала)
+    if (self >= 0) take(*queues[self], true);
+
+    if (!task) {
+        size_t start = self >= 0 ? static_cast<size_t>(self) + 1 : 0;
+        for (size_t k = 0; k < n && !task; ++k) {
+            take(*queues[(start + k) % n], false);
+        }
+    }
+
+    if (!task) return false;
+
+    pending.fetch_sub(1);
+    task();
+    return true;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    currentWorker = static_cast<int>(index);
+    currentPool = this;
+
+    while (!stopping) {
+        if (runOneTask()) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepCv.wait_for(lock, std::chrono::milliseconds(10),
+            [this] { return stopping || pending.load() > 0; });
+    }
+}
+
+void ThreadPool::parallelFor(size_t begin, size_t end, size_t grain,
+    const std::function<void(size_t, size_t)>& body) {
+    if (end <= begin) return;
+
+    size_t total = end - begin;
+    if (grain == 0) grain = 1;
+
+    if (workers.empty() || total <= grain) {
+        body(begin, end);
+        return;
+    }
+
+    // Кусков не больше total / grain: все, кроме последнего, не короче grain
+    size_t chunks = std::min(total / grain, threadCount() * 4);
+    size_t chunkSize = (total + chunks - 1) / chunks;
+    chunks = (total + chunkSize - 1) / chunkSize;
+
+    std::atomic<size_t> remaining{ chunks };
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto runChunk = [&](size_t lo, size_t hi) {
+        try {
+            body(lo, hi);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) error = std::current_exception();
+        }
+        remaining.fetch_sub(1);
+    };
+
+    // Первый кусок выполняется сразу в текущем потоке
+    for (size_t c = 1; c < chunks; ++c) {
+        size_t lo = begin + c * chunkSize;
+        size_t hi = std::min(end, lo + chunkSize);
+        submit([&runChunk, lo, hi] { runChunk(lo, hi); }, &remaining);
+    }
+    runChunk(begin, std::min(end, begin + chunkSize));
+
+    while (remaining.load() > 0) {
+        if (!runOneTask(&remaining)) std::this_thread::yield();
+    }
+
+    if (error) std::rethrow_exception(error);
+}
\ No newline at end of file
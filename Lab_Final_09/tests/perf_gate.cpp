@@ -0,0 +1,407 @@
+﻿// Порог производительности: генерирует данные с фиксированным зерном, замеряет
+// разбор JSON, загрузку записей, валидацию и агрегацию и сравнивает с базой
+// из tests/perf_baseline.txt. Код возврата 1, если какой-то этап медленнее
+// базы больше чем на допуск; --update-baseline записывает базу заново.
+//
+// Скорость этапа делится на скорость калибровочного цикла на той же машине,
+// поэтому база переносится между машинами, а не только между сборками.
+// Калибровок две: parse и load в основном выделяют память под строки и узлы,
+// и их скорость зависит от распределителя памяти не меньше, чем от процессора;
+// validate и aggregate — счётные проходы по готовым записям.
+//
+// Запуск из каталога Lab_Final_09 (проект PerfTests или на Linux):
+//   g++ -std=c++20 -O2 -pthread $(ls src/*.cpp | grep -v main.cpp) tests/perf_gate.cpp -o perf_gate
+//   ./perf_gate [--update-baseline] [--baseline <файл>] [--records N] [--repeats N]
+//               [--tolerance 0.4] [--threads N]
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include "../include/simple_json.hpp"
+#include "../include/attendance.hpp"
+#include "../include/thread_pool.hpp"
+#include "../include/utils.hpp"
+#include "test_common.hpp"
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct Options {
+    std::string baselinePath = "tests/perf_baseline.txt";
+    bool updateBaseline = false;
+    size_t records = 200000;
+    int repeats = 7;
+    double tolerance = -1.0;    // < 0 — из файла базы
+    size_t threads = 1;
+};
+
+struct Baseline {
+    size_t records = 0;
+    double tolerance = 0.40;
+    std::map<std::string, double> scores;   // этап -> скорость / калибровка
+};
+
+static const char* const STAGES[] = { "parse", "load", "validate", "aggregate" };
+
+// Сколько полных прогонов усредняет --update-baseline (по медиане)
+static constexpr int BASELINE_ROUNDS = 3;
+
+enum class Calibration { Compute, Alloc };
+
+static Calibration calibrationOf(const std::string& stage) {
+    return stage == "parse" || stage == "load" ? Calibration::Alloc : Calibration::Compute;
+}
+
+static double millisSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// --- Dataset ---
+// Вывод mt19937 одинаков во всех реализациях стандартной библиотеки,
+// распределения — нет, поэтому диапазоны берутся остатком от деления
+
+static std::string generateDataset(size_t count) {
+    std::mt19937 rng(20251001);
+    auto pick = [&rng](uint32_t n) { return static_cast<uint32_t>(rng() % n); };
+
+    static const char* const surnames[] = {
+        "Иванов", "Петров", "Сидоров", "Смирнов", "Кузнецов", "Попов", "Васильев", "Михайлов",
+        "Новиков", "Федоров", "Морозов", "Волков", "Алексеев", "Лебедев", "Семенов", "Егоров"
+    };
+    static const char* const initials[] = { "А.А.", "Б.В.", "Г.Д.", "Е.Ж.", "И.К." };
+    static const char* const types[] = { "in", "out", "absence" };
+
+    std::string out;
+    out.reserve(count * 80);
+    out += "[\n";
+    char ts[32];
+    for (size_t i = 0; i < count; ++i) {
+        std::string student = std::string(surnames[pick(16)]) + " " + initials[pick(5)];
+        std::snprintf(ts, sizeof(ts), "2025-10-%02uT%02u:%02u:%02uZ",
+            1 + pick(31), 8 + pick(12), pick(60), pick(60));
+        std::string type = types[pick(3)];
+
+        // Около 3% невалидных записей, чтобы валидации было что отбрасывать
+        switch (pick(100)) {
+        case 0: student = "Unknown"; break;
+        case 1: std::snprintf(ts, sizeof(ts), "2025-10-%02u", 1 + pick(31)); break;
+        case 2: type = "late"; break;
+        default: break;
+        }
+
+        out += "  { \"student\": \"" + student + "\", \"ts\": \"" + ts + "\", \"type\": \"" + type + "\" }";
+        out += i + 1 < count ? ",\n" : "\n";
+    }
+    out += "]";
+    return out;
+}
+
+// --- Calibration ---
+// Целочисленная работа с ветвлениями и обходом памяти, близкая по характеру
+// к валидации и агрегации; результат — миллионов операций в секунду
+
+static double calibrateCompute(int repeats) {
+    std::vector<uint32_t> data(1 << 20);
+    std::mt19937 rng(42);
+    for (auto& v : data) v = rng();
+
+    double best = 0.0;
+    volatile uint64_t sink = 0;
+    for (int r = 0; r < repeats; ++r) {
+        std::vector<uint32_t> work = data;
+        auto start = Clock::now();
+        uint64_t h = 1469598103934665603ULL;
+        for (uint32_t v : work) {
+            h ^= v;
+            h *= 1099511628211ULL;
+            if (h & 1) h += v >> 3;
+        }
+        std::sort(work.begin(), work.end());
+        sink = h + work[work.size() / 2];
+        double ms = millisSince(start);
+        best = std::max(best, static_cast<double>(work.size()) * 2.0 / (ms * 1e3));
+    }
+    (void)sink;
+    return best;
+}
+
+// Выделение и освобождение коротких строк вне SSO, как при построении
+// записей из JSON; результат — миллионов строк в секунду
+
+static double calibrateAlloc(int repeats) {
+    const size_t count = 1 << 18;
+    double best = 0.0;
+    volatile size_t sink = 0;
+    for (int r = 0; r < repeats; ++r) {
+        auto start = Clock::now();
+        std::vector<std::pair<std::string, std::string>> items;
+        items.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            items.emplace_back(std::string(20 + (i & 7), static_cast<char>('a' + i % 26)),
+                std::string(20, static_cast<char>('0' + i % 10)));
+        }
+        size_t bytes = 0;
+        for (const auto& item : items) bytes += item.first.size() + item.second.back();
+        items.clear();
+        items.shrink_to_fit();
+        sink = bytes;
+        double ms = millisSince(start);
+        best = std::max(best, static_cast<double>(count) * 2.0 / (ms * 1e3));
+    }
+    (void)sink;
+    return best;
+}
+
+struct Calibrations {
+    double compute = 0.0;
+    double alloc = 0.0;
+
+    double of(const std::string& stage) const {
+        return calibrationOf(stage) == Calibration::Alloc ? alloc : compute;
+    }
+};
+
+// Калибровка до и после замеров: лучшая из них меньше зависит от фоновой нагрузки
+static void calibrate(Calibrations& out, int repeats) {
+    out.compute = std::max(out.compute, calibrateCompute(repeats));
+    out.alloc = std::max(out.alloc, calibrateAlloc(repeats));
+}
+
+// --- Stages ---
+// Скорость этапа — записей (для parse — мегабайт) в секунду, лучшая из повторов
+
+static std::map<std::string, double> measure(const std::string& text, const Options& options) {
+    std::map<std::string, double> best;
+    auto record = [&best](const std::string& stage, double perSecond) {
+        best[stage] = std::max(best[stage], perSecond);
+    };
+
+    for (int r = 0; r < options.repeats; ++r) {
+        QuietStdout quiet;
+
+        auto start = Clock::now();
+        json::Value root = json::Parser::parse(text);
+        double parseMs = millisSince(start);
+
+        AttendanceManager manager;
+        start = Clock::now();
+        manager.loadRecords(AttendanceManager::recordsFromJson(root));
+        double loadMs = millisSince(start);
+        size_t loaded = manager.recordCount();
+
+        start = Clock::now();
+        manager.validateData();
+        double validateMs = millisSince(start);
+
+        start = Clock::now();
+        StudentStat total = manager.totalStats();
+        double aggregateMs = millisSince(start);
+        if (total.totalRecords != static_cast<int>(manager.recordCount())) {
+            throw std::runtime_error("aggregate: record count mismatch");
+        }
+
+        record("parse", text.size() / (1024.0 * 1024.0) / (parseMs / 1e3));
+        record("load", loaded / (loadMs / 1e3));
+        record("validate", loaded / (validateMs / 1e3));
+        record("aggregate", manager.recordCount() / (aggregateMs / 1e3));
+    }
+    return best;
+}
+
+// --- Baseline file ---
+
+static bool readBaseline(const std::string& path, Baseline& out) {
+    std::ifstream in(path);
+    if (!in.is_open()) return false;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string key;
+        double value = 0.0;
+        if (!(fields >> key >> value)) continue;
+        if (key == "records") out.records = static_cast<size_t>(value);
+        else if (key == "tolerance") out.tolerance = value;
+        else out.scores[key] = value;
+    }
+    return !out.scores.empty();
+}
+
+static void writeBaseline(const std::string& path, const Baseline& baseline,
+    const std::map<std::string, double>& raw, const Calibrations& calibration) {
+    std::ofstream out(path, std::ios::out | std::ios::trunc);
+    if (!out.is_open()) throw std::runtime_error("Cannot open file for writing: " + path);
+
+    out << "# Perf gate baseline (tests/perf_gate.cpp), re-record with --update-baseline\n";
+    out << "# score = stage throughput / calibration loop throughput on the same machine\n";
+    out << "# (parse, load: allocation loop; validate, aggregate: compute loop)\n";
+    out << "# recorded: compute " << std::fixed << std::setprecision(1) << calibration.compute
+        << " Mops/s, alloc " << calibration.alloc << " Mstr/s";
+    for (const char* stage : STAGES) out << ", " << stage << " " << raw.at(stage);
+    out << "\n";
+    out << "records " << baseline.records << "\n";
+    out << "tolerance " << std::setprecision(2) << baseline.tolerance << "\n";
+    out << std::setprecision(2);
+    for (const char* stage : STAGES) out << stage << " " << baseline.scores.at(stage) << "\n";
+}
+
+static bool parseArgs(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--update-baseline") options.updateBaseline = true;
+        else if (arg == "--baseline" && i + 1 < argc) options.baselinePath = argv[++i];
+        else if (arg == "--records" && i + 1 < argc) {
+            if (!utils::parseCount(arg, argv[++i], options.records)) return false;
+        }
+        else if (arg == "--repeats" && i + 1 < argc) {
+            size_t repeats = 0;
+            if (!utils::parseCount(arg, argv[++i], repeats)) return false;
+            options.repeats = static_cast<int>(std::clamp<size_t>(repeats, 1, 1000));
+        }
+        else if (arg == "--tolerance" && i + 1 < argc) {
+            if (!utils::parseNonNegative(arg, argv[++i], options.tolerance)) return false;
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            if (!utils::parseCount(arg, argv[++i], options.threads)) return false;
+        }
+        else {
+            std::cerr << "Неизвестный аргумент: " << arg << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    utils::setupConsoleEncoding();
+
+    Options options;
+    if (!parseArgs(argc, argv, options)) return 2;
+
+    Baseline baseline;
+    bool haveBaseline = readBaseline(options.baselinePath, baseline);
+    if (!haveBaseline && !options.updateBaseline) {
+        std::cerr << "Нет базы " << options.baselinePath << ": запустите с --update-baseline\n";
+        return 2;
+    }
+    // Объём данных — как в базе, чтобы сравнивать одинаковые замеры
+    if (haveBaseline && !options.updateBaseline && baseline.records > 0) options.records = baseline.records;
+    if (options.tolerance >= 0.0) baseline.tolerance = options.tolerance;
+
+    ThreadPool::configure(options.threads);
+    std::cout << "=== Perf Gate ===\n";
+    std::cout << "Записей: " << options.records << ", повторов: " << options.repeats
+        << ", потоков: " << ThreadPool::instance().threadCount() << "\n";
+
+    std::string text = generateDataset(options.records);
+
+    // База — медиана нескольких прогонов: по одному удачному прогону
+    // обычные замеры выглядели бы регрессией
+    int rounds = options.updateBaseline ? BASELINE_ROUNDS : 1;
+    std::vector<std::map<std::string, double>> roundRaw, roundScores;
+    Calibrations calibration;
+    for (int round = 0; round < rounds; ++round) {
+        Calibrations current;
+        calibrate(current, options.repeats);
+        std::map<std::string, double> raw;
+        try {
+            raw = measure(text, options);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Ошибка замера: " << e.what() << "\n";
+            return 2;
+        }
+        calibrate(current, options.repeats);
+        std::cout << "Калибровка: вычисления " << std::fixed << std::setprecision(1) << current.compute
+            << " Mops/s, выделение памяти " << current.alloc << " Mstr/s\n";
+
+        std::map<std::string, double> scores;
+        for (const char* stage : STAGES) scores[stage] = raw[stage] / current.of(stage);
+        roundRaw.push_back(std::move(raw));
+        roundScores.push_back(std::move(scores));
+        calibration = current;
+    }
+    std::cout << "\n";
+
+    auto median = [](const std::vector<std::map<std::string, double>>& rounds, const char* stage) {
+        std::vector<double> values;
+        for (const auto& r : rounds) values.push_back(r.at(stage));
+        std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+        return values[values.size() / 2];
+    };
+    std::map<std::string, double> raw, scores;
+    for (const char* stage : STAGES) {
+        raw[stage] = median(roundRaw, stage);
+        scores[stage] = median(roundScores, stage);
+    }
+
+    if (options.updateBaseline) {
+        baseline.records = options.records;
+        baseline.scores = scores;
+        writeBaseline(options.baselinePath, baseline, raw, calibration);
+        for (const char* stage : STAGES) {
+            std::cout << std::left << std::setw(10) << stage << std::right << std::setprecision(2)
+                << std::setw(14) << scores[stage] << "\n";
+        }
+        std::cout << "\nБаза записана в " << options.baselinePath << "\n";
+        return 0;
+    }
+
+    auto title = [](const std::string& s, int width, bool left = false) {
+        std::cout << (left ? std::left : std::right) << std::setw(utils::u8_adjust(s, width)) << s;
+    };
+    title("Этап", 10, true);
+    title("Сейчас/с", 14);
+    title("База", 14);
+    title("Сейчас", 14);
+    title("Разница", 10);
+    std::cout << "  Итог\n" << std::right;
+    std::cout << std::string(76, '-') << "\n";
+
+    size_t regressions = 0;
+    for (const char* stage : STAGES) {
+        auto found = baseline.scores.find(stage);
+        double current = scores[stage];
+        std::string verdict;
+        double change = 0.0;
+        if (found == baseline.scores.end() || found->second <= 0.0) {
+            verdict = "нет в базе";
+        }
+        else {
+            change = current / found->second - 1.0;
+            if (change < -baseline.tolerance) {
+                verdict = "РЕГРЕССИЯ";
+                regressions++;
+            }
+            else if (change > baseline.tolerance) {
+                verdict = "быстрее базы";
+            }
+            else {
+                verdict = "OK";
+            }
+        }
+
+        std::cout << std::left << std::setw(10) << stage << std::right << std::setprecision(1)
+            << std::setw(14) << raw[stage] << std::setprecision(2)
+            << std::setw(14) << (found != baseline.scores.end() ? found->second : 0.0)
+            << std::setw(14) << current << std::setprecision(1)
+            << std::setw(9) << std::showpos << change * 100.0 << std::noshowpos << "%"
+            << "  " << verdict << "\n";
+    }
+
+    std::cout << "\nДопуск: " << baseline.tolerance * 100.0 << "% (parse — МБ/с, остальные — записей/с)\n";
+    if (regressions > 0) {
+        std::cout << "=== Регрессия производительности: этапов " << regressions << " ===\n";
+        return 1;
+    }
+    std::cout << "=== Производительность в пределах допуска ===\n";
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+﻿#include <vector>
+#include <string>
+#include <random>
+#include <tuple>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+#include "../include/attendance.hpp"
+#include "../include/columnar_store.hpp"
+#include "test_common.hpp"
+
+// Записи нескольких студентов вперемешку; часть меток записана не в
+// каноническом виде (без Z) и должна пройти через исключения блока
+static std::vector<AttendanceRecord> makeRecords(size_t count) {
+    std::mt19937 rng(7);
+    const char* names[] = { "Иванов", "Петров", "Сидоров", "Козлов", "Smith" };
+    const EventType types[] = { EventType::IN, EventType::OUT, EventType::ABSENCE };
+    std::vector<AttendanceRecord> records;
+    records.reserve(count);
+    long long t = 1759300000;
+    for (size_t i = 0; i < count; ++i) {
+        t += static_cast<long long>(rng() % 900);
+        AttendanceRecord rec;
+        rec.student = names[rng() % 5];
+        rec.epoch = t;
+        rec.timestamp = AttendanceRecord::formatTimestamp(t);
+        if (rng() % 16 == 0) rec.timestamp.pop_back();
+        rec.type = types[rng() % 3];
+        records.push_back(std::move(rec));
+    }
+    return records;
+}
+
+// Снимок хранит записи в порядке (студент, время)
+static std::vector<AttendanceRecord> snapshotOrder(std::vector<AttendanceRecord> records) {
+    std::stable_sort(records.begin(), records.end(), [](const AttendanceRecord& a, const AttendanceRecord& b) {
+        return std::tie(a.student, a.epoch) < std::tie(b.student, b.epoch);
+    });
+    return records;
+}
+
+static bool sameRecords(const std::vector<AttendanceRecord>& a, const std::vector<AttendanceRecord>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].student != b[i].student || a[i].timestamp != b[i].timestamp
+            || a[i].type != b[i].type || a[i].epoch != b[i].epoch) return false;
+    }
+    return true;
+}
+
+static bool decodeFails(std::string_view data) {
+    try {
+        columnar::decode(data);
+    }
+    catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+void test_columnar_round_trip() {
+    TEST_CASE("Columnar Snapshot Round Trip") {
+        // Больше одного блока, последний неполный
+        auto records = makeRecords(columnar::BLOCK_ROWS + 1000);
+        std::string data = columnar::encode(records);
+        CHECK(sameRecords(columnar::decode(data), snapshotOrder(records)));
+
+        // Колонки совпадают с записями без восстановления строк
+        auto expected = snapshotOrder(records);
+        auto cols = columnar::decodeColumns(data);
+        CHECK(cols.students.size() == expected.size());
+        CHECK(std::is_sorted(cols.dictionary.begin(), cols.dictionary.end()));
+        for (size_t i = 0; i < expected.size(); ++i) {
+            CHECK(cols.dictionary[cols.students[i]] == expected[i].student);
+            CHECK(cols.epochs[i] == expected[i].epoch);
+            CHECK(cols.types[i] == static_cast<uint8_t>(expected[i].type));
+        }
+
+        CHECK(columnar::decode(columnar::encode({})).empty());
+
+        std::string path = "data/test_round_trip.atc";
+        columnar::save(path, records);
+        CHECK(sameRecords(columnar::load(path), expected));
+        std::filesystem::remove(path);
+    } TEST_PASS
+}
+
+void test_columnar_rejects_corrupt() {
+    TEST_CASE("Columnar Snapshot Rejects Corrupt Data") {
+        std::string data = columnar::encode(makeRecords(1000));
+
+        CHECK(decodeFails(""));
+        CHECK(decodeFails(std::string_view(data).substr(0, 8)));
+        CHECK(decodeFails(std::string_view(data).substr(0, data.size() / 2)));
+
+        std::string badMagic = data;
+        badMagic[0] = 'X';
+        CHECK(decodeFails(badMagic));
+
+        std::string badVersion = data;
+        badVersion[4] ^= 0x7F;
+        CHECK(decodeFails(badVersion));
+    } TEST_PASS
+}
+
+void runColumnarTests() {
+    test_columnar_round_trip();
+    test_columnar_rejects_corrupt();
+}
\ No newline at end of file
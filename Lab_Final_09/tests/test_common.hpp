@@ -0,0 +1,60 @@
+﻿#pragma once
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <stdexcept>
+#include <cstdlib>
+
+#define TEST_CASE(name) \
+    std::cout << "[RUN] " << name << "... "; \
+    try
+
+#define TEST_PASS \
+    catch (const std::exception& e) { \
+        std::cout << "FAIL (" << e.what() << ")\n"; \
+        exit(1); \
+    } \
+    std::cout << "OK\n";
+
+// Проверка, которая работает и в Release (assert там отключён)
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) throw std::runtime_error(std::string("check failed: ") + #cond \
+            + " (" + __FILE__ + ":" + std::to_string(__LINE__) + ")"); \
+    } while (0)
+
+// Загрузка и валидация пишут ход работы в std::cout; в тестах он не нужен
+class QuietStdout {
+public:
+    QuietStdout() : old(std::cout.rdbuf(sink.rdbuf())) {}
+    ~QuietStdout() { std::cout.rdbuf(old); }
+
+private:
+    std::ostringstream sink;
+    std::streambuf* old;
+};
+
+// То же для std::cerr: ошибки отдельных файлов при загрузке
+class QuietStderr {
+public:
+    QuietStderr() : old(std::cerr.rdbuf(sink.rdbuf())) {}
+    ~QuietStderr() { std::cerr.rdbuf(old); }
+
+private:
+    std::ostringstream sink;
+    std::streambuf* old;
+};
+
+// Наборы тестов из остальных файлов tests/test_*.cpp
+void runStatsTests();
+void runIndexTests();
+void runFilterTests();
+void runColumnarTests();
+void runSketchTests();
+void runDedupTests();
+void runPartitionTests();
+void runIngestTests();
+void runThreadPoolTests();
+void runTableWriterTests();
+void runJsonWriterTests();
+void runQueryServerTests();
\ No newline at end of file
@@ -0,0 +1,126 @@
+﻿#include <vector>
+#include <string>
+#include <cstdint>
+#include "../include/attendance.hpp"
+#include "../include/dedup.hpp"
+#include "test_common.hpp"
+
+static AttendanceRecord event(const std::string& student, long long epoch, EventType type) {
+    AttendanceRecord rec;
+    rec.student = student;
+    rec.epoch = epoch;
+    rec.timestamp = AttendanceRecord::formatTimestamp(epoch);
+    rec.type = type;
+    return rec;
+}
+
+static const long long T0 = 1759300000;
+
+void test_fingerprint_set() {
+    TEST_CASE("Fingerprint Set Insert And Evict") {
+        // Разные ненулевые отпечатки
+        auto key = [](uint64_t i) { return i * 0x9e3779b97f4a7c15ULL; };
+        dedup::FingerprintSet set;
+        // Больше начальной ёмкости: таблица несколько раз растёт
+        for (uint64_t fp = 1; fp <= 10000; ++fp) CHECK(set.insert(key(fp), static_cast<long long>(fp)));
+        CHECK(set.size() == 10000);
+        for (uint64_t fp = 1; fp <= 10000; ++fp) CHECK(!set.insert(key(fp), 0));
+
+        // Вытесняются только события раньше границы; остальные по-прежнему найдены
+        size_t memoryBefore = set.memoryBytes();
+        CHECK(set.evictBefore(9001) == 9000);
+        CHECK(set.size() == 1000);
+        CHECK(set.memoryBytes() < memoryBefore);
+        CHECK(set.evictBefore(9001) == 0);
+        for (uint64_t fp = 9001; fp <= 10000; ++fp) CHECK(!set.insert(key(fp), 0));
+        for (uint64_t fp = 1; fp <= 9000; ++fp) CHECK(set.insert(key(fp), 0));
+        CHECK(set.size() == 10000);
+
+        set.clear();
+        CHECK(set.size() == 0);
+        CHECK(set.insert(key(1), 1));
+    } TEST_PASS
+}
+
+void test_dedup_keeps_first() {
+    TEST_CASE("Dedup Keeps First Occurrence In Order") {
+        dedup::Deduplicator dedup;
+
+        // Повторы внутри пакета; тот же момент с другим типом — другое событие
+        std::vector<AttendanceRecord> batch = {
+            event("Иванов", T0, EventType::IN),
+            event("Петров", T0, EventType::IN),
+            event("Иванов", T0, EventType::IN),
+            event("Иванов", T0, EventType::OUT),
+            event("Петров", T0 + 60, EventType::OUT),
+            event("Петров", T0, EventType::IN),
+        };
+        CHECK(dedup.filter(batch) == 2);
+        CHECK(batch.size() == 4);
+        CHECK(batch[0].student == "Иванов" && batch[0].type == EventType::IN);
+        CHECK(batch[1].student == "Петров" && batch[1].epoch == T0);
+        CHECK(batch[2].student == "Иванов" && batch[2].type == EventType::OUT);
+        CHECK(batch[3].student == "Петров" && batch[3].epoch == T0 + 60);
+        CHECK(dedup.size() == 4);
+
+        // Повтор из прошлого пакета; без окна он распознаётся сколько угодно позже
+        std::vector<AttendanceRecord> later = {
+            event("Сидоров", T0 + 30 * 24 * 3600, EventType::IN),
+            event("Иванов", T0, EventType::OUT),
+        };
+        CHECK(dedup.filter(later) == 1);
+        CHECK(later.size() == 1 && later[0].student == "Сидоров");
+        CHECK(dedup.size() == 5);
+
+        // Больше одного фрагмента parallelFor и всех частей таблицы
+        std::vector<AttendanceRecord> large;
+        for (int i = 0; i < 20000; ++i) large.push_back(event("Студент " + std::to_string(i % 500), T0 + i, EventType::IN));
+        for (int i = 0; i < 20000; i += 2) large.push_back(event("Студент " + std::to_string(i % 500), T0 + i, EventType::IN));
+        CHECK(dedup.filter(large) == 10000);
+        CHECK(large.size() == 20000);
+        for (int i = 0; i < 20000; ++i) CHECK(large[i].epoch == T0 + i);
+    } TEST_PASS
+}
+
+void test_dedup_window_eviction() {
+    TEST_CASE("Dedup Window Eviction") {
+        const long long window = 3600;
+        dedup::Deduplicator dedup(window);
+        CHECK(dedup.window() == window);
+
+        std::vector<AttendanceRecord> first;
+        for (int i = 0; i < 100; ++i) first.push_back(event("Иванов", T0 + i, EventType::IN));
+        CHECK(dedup.filter(first) == 0);
+        CHECK(dedup.size() == 100);
+
+        // Повтор в пределах окна ещё распознаётся
+        std::vector<AttendanceRecord> inWindow = {
+            event("Иванов", T0 + 10, EventType::IN),
+            event("Петров", T0 + window / 2, EventType::IN),
+        };
+        CHECK(dedup.filter(inWindow) == 1);
+        CHECK(dedup.size() == 101);
+
+        // Событие через два окна сдвигает границу: старые отпечатки вытеснены
+        std::vector<AttendanceRecord> advance = { event("Петров", T0 + 2 * window, EventType::OUT) };
+        CHECK(dedup.filter(advance) == 0);
+        CHECK(dedup.size() == 1);
+
+        // Повтор, пришедший позже окна, уже не распознаётся
+        std::vector<AttendanceRecord> stale = {
+            event("Иванов", T0 + 10, EventType::IN),
+            event("Петров", T0 + 2 * window, EventType::OUT),
+        };
+        CHECK(dedup.filter(stale) == 1);
+        CHECK(stale.size() == 1 && stale[0].epoch == T0 + 10);
+
+        dedup.clear();
+        CHECK(dedup.size() == 0);
+    } TEST_PASS
+}
+
+void runDedupTests() {
+    test_fingerprint_set();
+    test_dedup_keeps_first();
+    test_dedup_window_eviction();
+}
\ No newline at end of file
@@ -0,0 +1,248 @@
+﻿#include <vector>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include "../include/attendance.hpp"
+#include "../include/filter.hpp"
+#include "../include/kernels.hpp"
+#include "../include/group_by.hpp"
+#include "../include/student_dictionary.hpp"
+#include "test_common.hpp"
+
+static bool parseFails(const std::string& text) {
+    try {
+        filter::Expression::parse(text);
+    }
+    catch (const std::invalid_argument&) {
+        return true;
+    }
+    return false;
+}
+
+// Колонки записей без AttendanceManager: несколько дней, у студентов записи всех типов
+struct Sample {
+    StudentDictionary dict;
+    RecordColumns cols;
+
+    Sample() {
+        struct Row { const char* student; const char* ts; EventType type; };
+        const Row rows[] = {
+            { "Иванов", "2025-10-01T09:00:00", EventType::IN },
+            { "Иванов", "2025-10-01T12:00:00", EventType::OUT },
+            { "Петров", "2025-10-02T09:00:00", EventType::IN },
+            { "Петров", "2025-10-02T12:00:00", EventType::OUT },
+            { "Иванов", "2025-10-02T10:00:00", EventType::ABSENCE },
+            { "Сидоров", "2025-10-03T09:00:00", EventType::IN },
+            { "Сидоров", "2025-10-03T12:00:00", EventType::OUT },
+            { "Петров", "2025-10-03T10:00:00", EventType::ABSENCE },
+        };
+        for (const auto& row : rows) {
+            cols.types.push_back(static_cast<uint8_t>(row.type));
+            cols.epochs.push_back(AttendanceRecord::parseTimestamp(row.ts));
+            cols.students.push_back(dict.intern(row.student));
+        }
+    }
+
+    std::vector<uint32_t> select(const std::string& where) const {
+        return filter::Predicate(filter::Expression::parse(where), dict).select(cols);
+    }
+
+    // Та же выборка прямой проверкой каждой записи
+    template <typename Accept>
+    std::vector<uint32_t> selectByHand(Accept accept) const {
+        std::vector<uint32_t> result;
+        for (uint32_t i = 0; i < cols.types.size(); ++i) {
+            if (accept(static_cast<EventType>(cols.types[i]), cols.epochs[i], dict.name(cols.students[i]))) {
+                result.push_back(i);
+            }
+        }
+        return result;
+    }
+};
+
+void test_dnf_expansion() {
+    TEST_CASE("Where Expression Expands To DNF") {
+        auto single = filter::Expression::parse("type=absence");
+        CHECK(single.terms().size() == 1);
+        CHECK(single.terms()[0].size() == 1);
+        CHECK(single.terms()[0][0].field == filter::Field::Type);
+        CHECK(single.terms()[0][0].op == filter::Op::Eq);
+        CHECK(single.terms()[0][0].value == "absence");
+
+        // (a or b) and c -> ac, bc
+        auto product = filter::Expression::parse("(type=in or type=out) and ts<2025-10-15");
+        CHECK(product.terms().size() == 2);
+        for (const auto& term : product.terms()) {
+            CHECK(term.size() == 2);
+            CHECK(term[1].field == filter::Field::Time);
+            CHECK(term[1].op == filter::Op::Lt);
+        }
+        CHECK(product.terms()[0][0].value == "in");
+        CHECK(product.terms()[1][0].value == "out");
+
+        // (a or b) and (c or d) -> ac, ad, bc, bd
+        auto square = filter::Expression::parse(
+            "(type=in or type=out) and (student=\"Иванов\" or student~\"Пет\")");
+        CHECK(square.terms().size() == 4);
+        CHECK(square.terms()[1][0].value == "in");
+        CHECK(square.terms()[1][1].op == filter::Op::Contains);
+        CHECK(square.terms()[2][0].value == "out");
+        CHECK(square.terms()[2][1].value == "Иванов");
+
+        // and связывает сильнее or
+        auto precedence = filter::Expression::parse("type=in or type=out and student=\"Петров\"");
+        CHECK(precedence.terms().size() == 2);
+        CHECK(precedence.terms()[0].size() == 1);
+        CHECK(precedence.terms()[1].size() == 2);
+    } TEST_PASS
+}
+
+void test_syntax_errors() {
+    TEST_CASE("Where Syntax Errors Rejected") {
+        CHECK(parseFails(""));
+        CHECK(parseFails("type="));
+        CHECK(parseFails("(type=in"));
+        CHECK(parseFails("type=in and"));
+        CHECK(parseFails("room=101"));
+        CHECK(parseFails("type=late"));
+        CHECK(parseFails("type<in"));
+        CHECK(parseFails("ts~2025"));
+        CHECK(parseFails("ts>=2025-13-45"));
+
+        // Девять скобок по два терма — 512 термов, больше MAX_TERMS
+        std::string tooComplex;
+        for (int i = 0; i < 9; ++i) {
+            if (i) tooComplex += " and ";
+            tooComplex += "(type=in or type=out)";
+        }
+        CHECK(parseFails(tooComplex));
+    } TEST_PASS
+}
+
+void test_ts_not_equal_split() {
+    TEST_CASE("Where ts!= Splits Conjunct") {
+        Sample sample;
+
+        // Дата без времени исключает весь день: остаются отрезки до и после него
+        auto expr = filter::Expression::parse("ts!=2025-10-02");
+        filter::Predicate predicate(expr, sample.dict);
+        const auto& parts = predicate.conjuncts();
+        CHECK(parts.size() == 2);
+        long long dayStart = AttendanceManager::parseDateBound("2025-10-02", false);
+        long long dayEnd = AttendanceManager::parseDateBound("2025-10-02", true);
+        CHECK(parts[0].from == LLONG_MIN);
+        CHECK(parts[0].to == dayStart - 1);
+        CHECK(parts[1].from == dayEnd + 1);
+        CHECK(parts[1].to == LLONG_MAX);
+
+        auto expected = sample.selectByHand([&](EventType, long long epoch, const std::string&) {
+            return epoch < dayStart || epoch > dayEnd;
+        });
+        CHECK(expected.size() == 5);
+        CHECK(predicate.select(sample.cols) == expected);
+
+        // Отрезок, который после деления пуст, отбрасывается
+        auto clipped = filter::Expression::parse("ts>=2025-10-02 and ts!=2025-10-01");
+        filter::Predicate after(clipped, sample.dict);
+        CHECK(after.conjuncts().size() == 1);
+        CHECK(after.conjuncts()[0].from == dayStart);
+    } TEST_PASS
+}
+
+void test_predicate_select() {
+    TEST_CASE("Where Predicate Matches Row Check") {
+        Sample sample;
+
+        auto byType = sample.select("type!=absence and student!=\"Сидоров\"");
+        CHECK(byType == sample.selectByHand([](EventType type, long long, const std::string& name) {
+            return type != EventType::ABSENCE && name != "Сидоров";
+        }));
+        CHECK(byType.size() == 4);
+
+        auto either = sample.select("type=absence or (student~\"Сидор\" and type=in)");
+        CHECK(either == sample.selectByHand([](EventType type, long long, const std::string& name) {
+            return type == EventType::ABSENCE || (name == "Сидоров" && type == EventType::IN);
+        }));
+        CHECK(either.size() == 3);
+
+        // Неизвестный студент и противоречивые условия дают пустую выборку
+        CHECK(sample.select("student=\"Козлов\"").empty());
+        filter::Predicate contradiction(filter::Expression::parse("type=in and type=out"), sample.dict);
+        CHECK(contradiction.conjuncts().empty());
+        CHECK(contradiction.select(sample.cols).empty());
+    } TEST_PASS
+}
+
+void test_type_only_kernel() {
+    TEST_CASE("Where Type-Only Uses Bitmap Kernel") {
+        // Больше одного куска выборки (65536) и не кратно 64: полные слова маски и хвост
+        Sample sample;
+        for (uint32_t i = 0; i < 150001; ++i) {
+            sample.cols.types.push_back(static_cast<uint8_t>((i * 7 + i / 3) % 3));
+            sample.cols.epochs.push_back(1759300000 + i);
+            sample.cols.students.push_back(i % 3);
+        }
+
+        const kernels::Isa best = kernels::detectIsa();
+        for (kernels::Isa isa : { kernels::Isa::Scalar, kernels::Isa::SSE2, kernels::Isa::AVX2 }) {
+            if (static_cast<int>(isa) > static_cast<int>(best)) break;
+            kernels::setIsa(isa);
+            CHECK(sample.select("type=out") == sample.selectByHand([](EventType type, long long, const std::string&) {
+                return type == EventType::OUT;
+            }));
+            CHECK(sample.select("type=absence or type=in") == sample.selectByHand([](EventType type, long long, const std::string&) {
+                return type != EventType::OUT;
+            }));
+        }
+        kernels::setIsa(best);
+    } TEST_PASS
+}
+
+void test_dst_day_bounds() {
+    TEST_CASE("Date Bounds Follow DST") {
+#ifndef _WIN32
+        // Центральноевропейское время с правилами перехода (без базы часовых поясов).
+        // Кэш parseTimestamp хранит начала суток по дате, поэтому даты здесь
+        // не встречаются в других тестах
+        const char* saved = std::getenv("TZ");
+        std::string previous = saved ? saved : "";
+        setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
+        tzset();
+
+        long long springStart = AttendanceManager::parseDateBound("2025-03-30", false);
+        long long springEnd = AttendanceManager::parseDateBound("2025-03-30", true);
+        long long autumnStart = AttendanceManager::parseDateBound("2025-10-26", false);
+        long long autumnEnd = AttendanceManager::parseDateBound("2025-10-26", true);
+
+        // Группировка: 04:30 местного в день перехода на летнее время — час 4,
+        // хотя от полуночи прошло 3.5 часа
+        groupby::Calendar calendar;
+        uint32_t day = 0, hour = 0;
+        calendar.split(springStart + 3 * 3600 + 1800, day, hour);
+        uint32_t springDay = day, springHour = hour;
+        calendar.split(autumnEnd, day, hour);
+        uint32_t autumnHour = hour;
+
+        if (saved) setenv("TZ", previous.c_str(), 1);
+        else unsetenv("TZ");
+        tzset();
+
+        CHECK(springEnd - springStart == 23 * 3600 - 1);
+        CHECK(autumnEnd - autumnStart == 25 * 3600 - 1);
+        CHECK(springDay == 20250330);
+        CHECK(springHour == 4);
+        CHECK(autumnHour == 23);
+#endif
+    } TEST_PASS
+}
+
+void runFilterTests() {
+    test_dnf_expansion();
+    test_syntax_errors();
+    test_ts_not_equal_split();
+    test_predicate_select();
+    test_type_only_kernel();
+    test_dst_day_bounds();
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+﻿#include <vector>
+#include <string>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <filesystem>
+#include "../include/attendance.hpp"
+#include "../include/student_index.hpp"
+#include "../include/simple_json.hpp"
+#include "../include/utils.hpp"
+#include "test_common.hpp"
+
+static const std::string INDEX_DATA = "data/test_index.json";
+
+static std::string readBytes(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+static void writeBytes(const std::string& path, const std::string& bytes) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+// Файл данных и индекс к нему; возвращает путь индекса
+static std::string buildIndex() {
+    std::string json = R"([
+        {"student": "Петров", "ts": "2025-10-02T09:00:00Z", "type": "in"},
+        {"student": "Иванов", "ts": "2025-10-01T17:00:00Z", "type": "out"},
+        {"student": "Иванов", "ts": "2025-10-01T08:00:00Z", "type": "in"},
+        {"student": "Петров", "ts": "2025-10-03T09:00:00Z", "type": "absence"},
+        {"student": "Сидоров", "ts": "2025-10-01T10:00:00Z", "type": "in"}
+    ])";
+    utils::writeFile(INDEX_DATA, json);
+
+    AttendanceManager manager;
+    {
+        QuietStdout quiet;
+        manager.loadFromJson(json::Parser::parse(json));
+        manager.validateData();
+    }
+    std::string indexFile = StudentIndex::pathFor(INDEX_DATA);
+    manager.saveStudentIndex(indexFile, INDEX_DATA);
+    return indexFile;
+}
+
+void test_index_lookup() {
+    TEST_CASE("Student Index Lookup") {
+        std::string indexFile = buildIndex();
+
+        StudentIndex index;
+        CHECK(index.open(indexFile, INDEX_DATA));
+        CHECK(index.studentCount() == 3);
+        CHECK(index.recordCount() == 5);
+        CHECK((index.names() == std::vector<std::string>{ "Иванов", "Петров", "Сидоров" }));
+
+        // Записи студента в порядке времени, как в отчёте
+        std::vector<AttendanceRecord> rows;
+        CHECK(index.find("Иванов", rows));
+        CHECK(rows.size() == 2);
+        CHECK(rows[0].type == EventType::IN && rows[0].timestamp == "2025-10-01T08:00:00Z");
+        CHECK(rows[1].type == EventType::OUT && rows[1].timestamp == "2025-10-01T17:00:00Z");
+        CHECK(rows[0].epoch == AttendanceRecord::parseTimestamp(rows[0].timestamp));
+        CHECK(rows[0].student == "Иванов");
+
+        CHECK(index.find("Петров", rows) && rows.size() == 2 && rows[1].type == EventType::ABSENCE);
+        CHECK(index.find("Сидоров", rows) && rows.size() == 1);
+        CHECK(!index.find("Козлов", rows) && rows.empty());
+        CHECK(!index.find("", rows));
+
+        std::filesystem::remove(indexFile);
+        std::filesystem::remove(INDEX_DATA);
+    } TEST_PASS
+}
+
+void test_index_rejected() {
+    TEST_CASE("Student Index Rejects Stale Or Corrupt Files") {
+        std::string indexFile = buildIndex();
+        const std::string original = readBytes(indexFile);
+        StudentIndex index;
+
+        // Обрезанный файл
+        for (size_t cut : { size_t(10), size_t(64), original.size() / 2, original.size() - 1 }) {
+            writeBytes(indexFile, original.substr(0, cut));
+            CHECK(!index.open(indexFile, INDEX_DATA));
+        }
+
+        // Имя первого студента указывает за блок имён
+        std::string broken = original;
+        uint32_t length = 0xFFFFFF;
+        std::memcpy(broken.data() + 64 + 8, &length, sizeof(length));
+        writeBytes(indexFile, broken);
+        CHECK(!index.open(indexFile, INDEX_DATA));
+
+        // Строки студента за концом файла
+        broken = original;
+        uint64_t dataEnd = 1ULL << 40;
+        std::memcpy(broken.data() + 64 + 24, &dataEnd, sizeof(dataEnd));
+        writeBytes(indexFile, broken);
+        CHECK(!index.open(indexFile, INDEX_DATA));
+
+        // Целый индекс открывается, пока файл данных не изменился
+        writeBytes(indexFile, original);
+        CHECK(index.open(indexFile, INDEX_DATA));
+        index = StudentIndex();
+        std::ofstream(INDEX_DATA, std::ios::app) << "\n";
+        CHECK(!index.open(indexFile, INDEX_DATA));
+
+        std::filesystem::remove(indexFile);
+        std::filesystem::remove(INDEX_DATA);
+    } TEST_PASS
+}
+
+void runIndexTests() {
+    test_index_lookup();
+    test_index_rejected();
+}
\ No newline at end of file
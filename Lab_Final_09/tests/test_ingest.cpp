@@ -0,0 +1,136 @@
+﻿#include <vector>
+#include <string>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include "../include/attendance.hpp"
+#include "../include/ingest.hpp"
+#include "test_common.hpp"
+
+static const char* const DIR = "data/test_ingest";
+
+static void writeText(const std::string& path, const std::string& text) {
+    std::ofstream out(path, std::ios::binary);
+    out << text;
+}
+
+// Два файла с перекрывающимися студентами и временем, один битый и один не по маске
+static void makeInputs() {
+    std::filesystem::remove_all(DIR);
+    std::filesystem::create_directories(DIR);
+    writeText(std::string(DIR) + "/a.json", R"([
+        {"student": "Петров", "ts": "2025-10-01T08:00:00Z", "type": "in"},
+        {"student": "Иванов", "ts": "2025-10-01T10:00:00Z", "type": "out"},
+        {"student": "Иванов", "ts": "2025-10-01T08:00:00Z", "type": "in"}
+    ])");
+    writeText(std::string(DIR) + "/b.ndjson",
+        "{\"student\": \"Иванов\", \"ts\": \"2025-10-01T08:00:00Z\", \"type\": \"absence\"}\n"
+        "{\"student\": \"Иванов\", \"ts\": \"2025-10-01T09:00:00Z\", \"type\": \"in\"}\n");
+    writeText(std::string(DIR) + "/c.json", R"([{"student": "Иванов", "ts": )");
+    writeText(std::string(DIR) + "/notes.txt", "не данные");
+}
+
+void test_ingest_expand() {
+    TEST_CASE("Ingest Expands Directories And Globs") {
+        makeInputs();
+        const std::string dir = DIR;
+
+        auto all = ingest::expandInputs({ dir });
+        CHECK(all.size() == 3);
+        CHECK(std::filesystem::path(all[0]).filename() == "a.json");
+        CHECK(std::filesystem::path(all[1]).filename() == "b.ndjson");
+        CHECK(std::filesystem::path(all[2]).filename() == "c.json");
+
+        auto json = ingest::expandInputs({ dir + "/*.json" });
+        CHECK(json.size() == 2);
+        CHECK(std::filesystem::path(json[0]).filename() == "a.json");
+        CHECK(std::filesystem::path(json[1]).filename() == "c.json");
+
+        CHECK(ingest::expandInputs({ dir + "/*.csv" }).empty());
+        CHECK(ingest::isMultiInput({ dir }));
+        CHECK(!ingest::isMultiInput({ dir + "/a.json" }));
+        std::filesystem::remove_all(DIR);
+    } TEST_PASS
+}
+
+void test_ingest_merge_order() {
+    TEST_CASE("Ingest Merges Files In (Student, Time) Order") {
+        makeInputs();
+        const std::string a = std::string(DIR) + "/a.json";
+        const std::string b = std::string(DIR) + "/b.ndjson";
+        const std::string c = std::string(DIR) + "/c.json";
+
+        // Ошибка одного файла не мешает остальным
+        auto results = ingest::parseFiles({ a, b, c });
+        CHECK(results.size() == 3);
+        CHECK(results[0].error.empty() && results[0].records.size() == 3);
+        CHECK(results[1].error.empty() && results[1].records.size() == 2);
+        CHECK(!results[2].error.empty() && results[2].records.empty());
+
+        auto merged = ingest::mergeSorted(results);
+        CHECK(merged.size() == 5);
+        for (const auto& r : results) CHECK(r.records.empty());
+
+        // Одинаковые (студент, время) — в порядке файлов во входных путях
+        const char* expected[][3] = {
+            { "Иванов", "2025-10-01T08:00:00Z", "in" },
+            { "Иванов", "2025-10-01T08:00:00Z", "absence" },
+            { "Иванов", "2025-10-01T09:00:00Z", "in" },
+            { "Иванов", "2025-10-01T10:00:00Z", "out" },
+            { "Петров", "2025-10-01T08:00:00Z", "in" },
+        };
+        for (size_t i = 0; i < merged.size(); ++i) {
+            CHECK(merged[i].student == expected[i][0]);
+            CHECK(merged[i].timestamp == expected[i][1]);
+            CHECK(AttendanceManager::typeToStr(merged[i].type) == expected[i][2]);
+        }
+
+        auto swapped = ingest::parseFiles({ b, a });
+        auto reordered = ingest::mergeSorted(swapped);
+        CHECK(reordered.size() == 5);
+        CHECK(reordered[0].type == EventType::ABSENCE);
+        CHECK(reordered[1].type == EventType::IN);
+        std::filesystem::remove_all(DIR);
+    } TEST_PASS
+}
+
+void test_ingest_load_errors() {
+    TEST_CASE("Ingest Reports Failed Files") {
+        makeInputs();
+        const std::string dir = DIR;
+
+        AttendanceManager manager;
+        ingest::Summary summary;
+        {
+            QuietStdout quiet;
+            QuietStderr quietErr;
+            summary = ingest::loadInto(manager, { dir });
+        }
+        CHECK(summary.filesTotal == 3);
+        CHECK(summary.filesFailed == 1);
+        CHECK(summary.recordsLoaded == 5);
+        CHECK(manager.recordCount() == 5);
+
+        // Ни одного загруженного файла или пустая маска — ошибка
+        bool allFailed = false;
+        bool noMatch = false;
+        {
+            QuietStdout quiet;
+            QuietStderr quietErr;
+            AttendanceManager empty;
+            try { ingest::loadInto(empty, { dir + "/c.json" }); }
+            catch (const std::runtime_error&) { allFailed = true; }
+            try { ingest::loadInto(empty, { dir + "/*.csv" }); }
+            catch (const std::runtime_error&) { noMatch = true; }
+        }
+        CHECK(allFailed);
+        CHECK(noMatch);
+        std::filesystem::remove_all(DIR);
+    } TEST_PASS
+}
+
+void runIngestTests() {
+    test_ingest_expand();
+    test_ingest_merge_order();
+    test_ingest_load_errors();
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+﻿#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <filesystem>
+#include <stdexcept>
+#include "../include/attendance.hpp"
+#include "../include/simple_json.hpp"
+#include "../include/thread_pool.hpp"
+#include "test_common.hpp"
+
+// Имена с символами, которые нужно экранировать, и обычные кириллические
+static std::vector<AttendanceRecord> makeRecords(size_t count) {
+    const std::string names[] = {
+        "Иванов", "Петров \"Пётр\"", "обратный \\ слеш", "две\nстроки",
+        std::string("управляющий \x01\x1f"), "таб\tуляция", "" };
+    const EventType types[] = { EventType::IN, EventType::OUT, EventType::ABSENCE };
+    std::vector<AttendanceRecord> recs;
+    recs.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        AttendanceRecord rec;
+        rec.student = names[i % 7];
+        rec.epoch = 1759300000 + static_cast<long long>(i) * 37;
+        rec.timestamp = AttendanceRecord::formatTimestamp(rec.epoch);
+        rec.type = types[i % 3];
+        recs.push_back(std::move(rec));
+    }
+    return recs;
+}
+
+static std::string streamed(const AttendanceManager& manager) {
+    std::ostringstream out;
+    manager.writeJson(out);
+    return out.str();
+}
+
+void test_json_writer_matches_dom() {
+    TEST_CASE("Streamed JSON Matches DOM Writer") {
+        // Несколько окон по threadCount() * 2 кусков и неполный последний кусок
+        ThreadPool::configure(4);
+        const size_t sizes[] = { 0, 1, 16384, 16385, 4 * 2 * 16384 * 2 + 123 };
+        for (size_t size : sizes) {
+            AttendanceManager manager;
+            {
+                QuietStdout quiet;
+                manager.loadRecords(makeRecords(size));
+            }
+            std::string dom = json::Parser::stringify(manager.saveToJson());
+            std::string text = streamed(manager);
+            CHECK(text == dom);
+            CHECK(manager.serializeJson() == dom);
+            CHECK(json::Parser::parse(text).asArray().size() == size);
+        }
+
+        // На одном потоке результат тот же
+        ThreadPool::configure(1);
+        AttendanceManager manager;
+        {
+            QuietStdout quiet;
+            manager.loadRecords(makeRecords(40000));
+        }
+        std::string dom = json::Parser::stringify(manager.saveToJson());
+        CHECK(streamed(manager) == dom);
+
+        // Файл побайтно совпадает с DOM-выводом
+        const std::string path = "data/test_json_writer.json";
+        manager.saveJsonFile(path);
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream saved;
+        saved << in.rdbuf();
+        in.close();
+        std::filesystem::remove(path);
+        CHECK(saved.str() == dom);
+
+        ThreadPool::configure(0);
+    } TEST_PASS
+}
+
+void runJsonWriterTests() {
+    test_json_writer_matches_dom();
+}
\ No newline at end of file
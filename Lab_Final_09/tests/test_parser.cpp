@@ -4,17 +4,7 @@
 #include <cmath>
 #include <cassert>
 #include "../include/simple_json.hpp"
-
-#define TEST_CASE(name) \
-    std::cout << "[RUN] " << name << "... "; \
-    try
-
-#define TEST_PASS \
-    catch (const std::exception& e) { \
-        std::cout << "FAIL (" << e.what() << ")\n"; \
-        exit(1); \
-    } \
-    std::cout << "OK\n";
+#include "test_common.hpp"
 
 
 void test_primitives() {
@@ -81,6 +71,9 @@ void test_escaping() {
         auto root = json::Parser::parse(json);
         std::string res = root.asString();
         assert(res == "Line1\nLine2\"Quote\"");
+
+        auto unicode = json::Parser::parse("\"\\u0418\\u0432\\u0430\\u043d \\ud83d\\ude00 \\u0001\"");
+        assert(unicode.asString() == "\u0418\u0432\u0430\u043d \U0001F600 \x01");
     } TEST_PASS
 }
 
@@ -107,13 +100,26 @@ void test_errors() {
 }
 
 int main() {
-    std::cout << "=== Running Parser Tests ===\n";
+    std::cout << "=== Running Tests ===\n";
     test_primitives();
     test_arrays();
     test_objects();
     test_nested();
     test_escaping();
     test_errors();
+
+    runStatsTests();
+    runIndexTests();
+    runFilterTests();
+    runColumnarTests();
+    runSketchTests();
+    runDedupTests();
+    runPartitionTests();
+    runIngestTests();
+    runThreadPoolTests();
+    runTableWriterTests();
+    runJsonWriterTests();
+    runQueryServerTests();
     std::cout << "=== All Tests Passed ===\n";
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,125 @@
+﻿#include <vector>
+#include <string>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include "../include/attendance.hpp"
+#include "../include/partition_store.hpp"
+#include "test_common.hpp"
+
+static AttendanceRecord event(const std::string& student, long long epoch, EventType type) {
+    AttendanceRecord rec;
+    rec.student = student;
+    rec.epoch = epoch;
+    rec.timestamp = AttendanceRecord::formatTimestamp(epoch);
+    rec.type = type;
+    return rec;
+}
+
+static const long long T0 = 1759300000;
+static const char* const ROOT = "data/test_partitions";
+
+// Много студентов в одном месяце: в каждом разделе их несколько
+static std::vector<AttendanceRecord> makeRecords() {
+    std::vector<AttendanceRecord> recs;
+    for (int s = 0; s < 64; ++s) {
+        std::string name = "Студент " + std::to_string(s);
+        for (int i = 0; i < 10; ++i) {
+            recs.push_back(event(name, T0 + s * 100 + i * 3600, i % 2 ? EventType::OUT : EventType::IN));
+        }
+    }
+    return recs;
+}
+
+void test_partition_reingest() {
+    TEST_CASE("Partition Re-Ingest Is Idempotent") {
+        std::filesystem::remove_all(ROOT);
+        auto recs = makeRecords();
+
+        partition::WriteStats first;
+        size_t parts = partition::write(ROOT, recs, &first);
+        CHECK(parts > 0 && parts <= partition::BUCKETS);
+        CHECK(first.appended == recs.size());
+        CHECK(first.skipped == 0);
+
+        // Те же записи ещё раз: ни одна строка не дописана, разделы не тронуты
+        partition::WriteStats second;
+        CHECK(partition::write(ROOT, recs, &second) == 0);
+        CHECK(second.appended == 0);
+        CHECK(second.skipped == recs.size());
+        CHECK(partition::scan(ROOT, {}).size() == recs.size());
+
+        // Новые записи вперемешку со старыми: дописываются только новые
+        auto more = recs;
+        more.push_back(event("Студент 1", T0 + 50 * 3600, EventType::ABSENCE));
+        partition::WriteStats third;
+        CHECK(partition::write(ROOT, more, &third) == 1);
+        CHECK(third.appended == 1);
+        CHECK(partition::scan(ROOT, {}).size() == recs.size() + 1);
+        std::filesystem::remove_all(ROOT);
+    } TEST_PASS
+}
+
+void test_partition_pruning() {
+    TEST_CASE("Partition Bloom Pruning") {
+        std::filesystem::remove_all(ROOT);
+        partition::write(ROOT, makeRecords());
+
+        // Раздел студента читается, остальные отсекаются по имени файла;
+        // отсутствующий студент из того же раздела отсекается фильтром Блума
+        partition::ScanStats stats;
+        partition::Query query;
+        query.student = "Студент 7";
+        CHECK(partition::scan(ROOT, query, &stats).size() == 10);
+        CHECK(stats.partitions - stats.pruned == 1);
+
+        query.student = "Козлов";
+        CHECK(partition::scan(ROOT, query, &stats).empty());
+        CHECK(stats.pruned == stats.partitions);
+        std::filesystem::remove_all(ROOT);
+    } TEST_PASS
+}
+
+void test_partition_corrupted() {
+    TEST_CASE("Partition Rejects Bad Footer Sizes") {
+        std::filesystem::remove_all(ROOT);
+        partition::write(ROOT, makeRecords());
+
+        std::filesystem::path file;
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(ROOT)) {
+            if (entry.is_regular_file()) file = entry.path();
+        }
+        CHECK(!file.empty());
+
+        // Сводка с огромным dataBytes не должна приводить к выделению памяти под него
+        partition::Footer footer{};
+        auto size = std::filesystem::file_size(file);
+        {
+            std::ifstream in(file, std::ios::binary);
+            in.seekg(static_cast<std::streamoff>(size - sizeof(footer)));
+            in.read(reinterpret_cast<char*>(&footer), sizeof(footer));
+        }
+        footer.dataBytes = 1ULL << 60;
+        {
+            std::fstream out(file, std::ios::in | std::ios::out | std::ios::binary);
+            out.seekp(static_cast<std::streamoff>(size - sizeof(footer)));
+            out.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+        }
+
+        bool rejected = false;
+        try {
+            partition::scan(ROOT, {});
+        }
+        catch (const std::runtime_error&) {
+            rejected = true;
+        }
+        CHECK(rejected);
+        std::filesystem::remove_all(ROOT);
+    } TEST_PASS
+}
+
+void runPartitionTests() {
+    test_partition_reingest();
+    test_partition_pruning();
+    test_partition_corrupted();
+}
\ No newline at end of file
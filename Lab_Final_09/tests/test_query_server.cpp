@@ -0,0 +1,111 @@
+﻿#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <filesystem>
+#include <stdexcept>
+#include "../include/query_server.hpp"
+#include "../include/simple_json.hpp"
+#include "test_common.hpp"
+
+static const char* const INPUT = "data/test_server.ndjson";
+
+// Версия 0: у Иванова 100 записей; версия 1: у Иванова 200, у Петрова 50
+static void writeVersion(int version) {
+    std::ofstream out(INPUT, std::ios::binary | std::ios::trunc);
+    auto line = [&out](const char* student, long long epoch) {
+        out << "{\"student\": \"" << student << "\", \"ts\": \""
+            << AttendanceRecord::formatTimestamp(epoch) << "\", \"type\": \"absence\"}\n";
+    };
+    long long t = 1759300000;
+    for (int i = 0; i < (version ? 200 : 100); ++i) line("Иванов", t + i * 60);
+    if (version) {
+        for (int i = 0; i < 50; ++i) line("Петров", t + i * 60);
+    }
+}
+
+// Ответ целиком из одного снимка: ни одна из версий не смешана с другой
+static int statsVersion(const std::string& response) {
+    json::Value root = json::Parser::parse(response);
+    const auto& obj = root.asObject();
+    int students = static_cast<int>(obj.at("students").asNumber());
+    int total = static_cast<int>(obj.at("total").asObject().at("records").asNumber());
+    int ivanov = static_cast<int>(obj.at("stats").asObject().at("Иванов").asObject().at("records").asNumber());
+    if (students == 1 && total == 100 && ivanov == 100) return 0;
+    if (students == 2 && total == 250 && ivanov == 200) return 1;
+    return -1;
+}
+
+static int studentVersion(const std::string& response) {
+    json::Value root = json::Parser::parse(response);
+    const auto& obj = root.asObject();
+    size_t count = static_cast<size_t>(obj.at("count").asNumber());
+    if (obj.at("records").asArray().size() != count) return -1;
+    if (count == 100) return 0;
+    if (count == 200) return 1;
+    return -1;
+}
+
+static uint64_t generationOf(const std::string& response) {
+    json::Value root = json::Parser::parse(response);
+    return static_cast<uint64_t>(root.asObject().at("generation").asNumber());
+}
+
+void test_server_snapshot_swap() {
+    TEST_CASE("Server Snapshot Swap Under Readers") {
+        QuietStdout quiet;
+        QuietStderr quietErr;
+        writeVersion(0);
+        QueryServer server({ INPUT }, {}, 2);
+        CHECK(statsVersion(server.handleRequest("stats")) == 0);
+
+        // Читатели без остановки запрашивают данные, пока снимки подменяются
+        std::atomic<bool> done{ false };
+        std::atomic<size_t> mixed{ 0 };
+        std::atomic<size_t> answered{ 0 };
+        std::vector<std::thread> readers;
+        for (int r = 0; r < 3; ++r) {
+            readers.emplace_back([&] {
+                while (!done) {
+                    try {
+                        if (statsVersion(server.handleRequest("stats")) < 0) mixed++;
+                        if (studentVersion(server.handleRequest("student Иванов")) < 0) mixed++;
+                    }
+                    catch (const std::exception&) {
+                        mixed++;
+                    }
+                    answered += 2;
+                }
+            });
+        }
+
+        // Проверки — после join: исключение при живых потоках завершило бы процесс
+        const int reloads = 12;
+        bool published = true;
+        for (int i = 1; i <= reloads; ++i) {
+            writeVersion(i % 2);
+            published = published
+                && generationOf(server.handleRequest("reload")) == static_cast<uint64_t>(i) + 1
+                && statsVersion(server.handleRequest("stats")) == i % 2;
+        }
+        done = true;
+        for (auto& t : readers) t.join();
+        CHECK(published);
+        CHECK(mixed.load() == 0);
+        CHECK(answered.load() > 0);
+
+        // Неудачный reload не подменяет снимок и не меняет номер поколения
+        std::filesystem::remove(INPUT);
+        json::Value failed = json::Parser::parse(server.handleRequest("reload"));
+        CHECK(failed.asObject().count("error") == 1);
+        CHECK(statsVersion(server.handleRequest("stats")) == reloads % 2);
+        writeVersion(1);
+        CHECK(generationOf(server.handleRequest("reload")) == reloads + 2);
+        std::filesystem::remove(INPUT);
+    } TEST_PASS
+}
+
+void runQueryServerTests() {
+    test_server_snapshot_swap();
+}
\ No newline at end of file
@@ -0,0 +1,165 @@
+﻿#include <vector>
+#include <string>
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include <unordered_map>
+#include "../include/attendance.hpp"
+#include "../include/sketch.hpp"
+#include "test_common.hpp"
+
+static double relativeError(double estimate, double exact) {
+    return std::abs(estimate - exact) / exact;
+}
+
+// Частоты с длинным хвостом: ключ k встречается примерно в 1/(k+1) раз реже первого
+static std::unordered_map<std::string, uint64_t> skewedCounts(size_t keys, uint64_t first) {
+    std::unordered_map<std::string, uint64_t> counts;
+    for (size_t k = 0; k < keys; ++k) {
+        counts["Студент " + std::to_string(k)] = std::max<uint64_t>(1, first / (k + 1));
+    }
+    return counts;
+}
+
+void test_hll_error_bound() {
+    TEST_CASE("HyperLogLog Error Bound") {
+        sketch::HyperLogLog hll(14);
+        CHECK(std::abs(hll.standardError() - 1.04 / 128.0) < 1e-12);
+        CHECK(hll.estimate() == 0.0);
+
+        // Хеши детерминированы, поэтому допуск в четыре стандартные ошибки не «плавает»
+        const size_t checkpoints[] = { 100, 1000, 10000, 100000, 500000 };
+        size_t added = 0;
+        for (size_t target : checkpoints) {
+            for (; added < target; ++added) hll.add(sketch::hashKey("Студент " + std::to_string(added)));
+            CHECK(relativeError(hll.estimate(), static_cast<double>(target)) <= 4 * hll.standardError());
+        }
+
+        // Повторы не меняют оценку
+        double before = hll.estimate();
+        for (size_t i = 0; i < 1000; ++i) hll.add(sketch::hashKey("Студент " + std::to_string(i)));
+        CHECK(hll.estimate() == before);
+
+        // Объединение половин — то же самое, что один проход по всем ключам
+        sketch::HyperLogLog even(14), odd(14);
+        for (size_t i = 0; i < added; ++i) {
+            (i % 2 ? odd : even).add(sketch::hashKey("Студент " + std::to_string(i)));
+        }
+        even.merge(odd);
+        CHECK(even.estimate() == hll.estimate());
+    } TEST_PASS
+}
+
+void test_count_min_error_bound() {
+    TEST_CASE("Count-Min Error Bound") {
+        const double epsilon = 0.001, delta = 0.01;
+        sketch::CountMin cm(epsilon, delta);
+        CHECK(cm.epsilon() <= epsilon);
+        CHECK(cm.delta() <= delta);
+
+        auto counts = skewedCounts(5000, 20000);
+        uint64_t total = 0;
+        for (const auto& [key, count] : counts) {
+            cm.add(sketch::hashKey(key), count);
+            total += count;
+        }
+        CHECK(cm.total() == total);
+
+        // Оценка никогда не меньше истинной и превышает её больше чем на
+        // epsilon * N не чаще, чем в доле delta ключей
+        size_t overBound = 0;
+        for (const auto& [key, count] : counts) {
+            uint64_t estimate = cm.estimate(sketch::hashKey(key));
+            CHECK(estimate >= count);
+            if (static_cast<double>(estimate - count) > epsilon * static_cast<double>(total)) overBound++;
+        }
+        CHECK(overBound <= static_cast<size_t>(delta * counts.size()));
+
+        // Объединение счётчиков — поэлементная сумма
+        sketch::CountMin left(epsilon, delta), right(epsilon, delta);
+        bool toLeft = true;
+        for (const auto& [key, count] : counts) {
+            (toLeft ? left : right).add(sketch::hashKey(key), count);
+            toLeft = !toLeft;
+        }
+        left.merge(right);
+        CHECK(left.total() == total);
+        for (const auto& [key, count] : counts) {
+            CHECK(left.estimate(sketch::hashKey(key)) == cm.estimate(sketch::hashKey(key)));
+        }
+    } TEST_PASS
+}
+
+void test_heavy_hitters() {
+    TEST_CASE("Heavy Hitters Find Frequent Keys") {
+        // Пять частых ключей и длинный хвост редких, поданные вперемешку
+        std::vector<std::string> stream;
+        for (int k = 0; k < 5; ++k) {
+            for (int i = 0; i < 2000 - 300 * k; ++i) stream.push_back("Частый " + std::to_string(k));
+        }
+        for (int i = 0; i < 20000; ++i) stream.push_back("Редкий " + std::to_string(i));
+        std::shuffle(stream.begin(), stream.end(), std::mt19937(3));
+
+        sketch::HeavyHitters whole(5), first(5), second(5);
+        for (size_t i = 0; i < stream.size(); ++i) {
+            whole.add(stream[i]);
+            (i < stream.size() / 2 ? first : second).add(stream[i]);
+        }
+        first.merge(second);
+
+        // Огромное --top ограничивается MAX_CAPACITY, а не выделяется целиком
+        sketch::HeavyHitters huge(1000000000);
+        for (const auto& key : stream) huge.add(key);
+        CHECK(huge.top().size() == sketch::HeavyHitters::MAX_CAPACITY);
+        CHECK(huge.top()[0].key == "Частый 0");
+
+        for (const auto* hitters : { &whole, &first }) {
+            auto top = hitters->top();
+            CHECK(top.size() == 5);
+            for (int k = 0; k < 5; ++k) {
+                CHECK(top[k].key == "Частый " + std::to_string(k));
+                uint64_t exact = static_cast<uint64_t>(2000 - 300 * k);
+                CHECK(top[k].estimate >= exact);
+                CHECK(top[k].estimate <= exact + static_cast<uint64_t>(0.001 * stream.size()) + 1);
+            }
+        }
+    } TEST_PASS
+}
+
+void test_summary() {
+    TEST_CASE("Approx Summary Counts And Merges") {
+        auto record = [](const std::string& student, EventType type) {
+            AttendanceRecord rec;
+            rec.student = student;
+            rec.timestamp = "2025-10-01T09:00:00Z";
+            rec.type = type;
+            rec.epoch = rec.parseTimestamp();
+            return rec;
+        };
+
+        sketch::Summary a(3), b(3);
+        for (int i = 0; i < 300; ++i) {
+            a.add(record("Студент " + std::to_string(i), i % 3 == 0 ? EventType::ABSENCE : EventType::IN));
+        }
+        for (int i = 0; i < 50; ++i) b.add(record("Иванов", EventType::ABSENCE));
+        b.add(record("", EventType::IN));
+        b.add(record("Петров", EventType::UNKNOWN));
+
+        a.merge(b);
+        CHECK(a.records == 350);
+        CHECK(a.rejected == 2);
+        CHECK(a.absences == 150);
+        CHECK(relativeError(a.students.estimate(), 301.0) <= 4 * a.students.standardError());
+        auto top = a.absentees.top();
+        CHECK(!top.empty());
+        CHECK(top[0].key == "Иванов");
+        CHECK(top[0].estimate >= 50);
+    } TEST_PASS
+}
+
+void runSketchTests() {
+    test_hll_error_bound();
+    test_count_min_error_bound();
+    test_heavy_hitters();
+    test_summary();
+}
\ No newline at end of file
@@ -0,0 +1,439 @@
+﻿#include <vector>
+#include <string>
+#include <map>
+#include <set>
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include "../include/attendance.hpp"
+#include "../include/stats_engine.hpp"
+#include "../include/external_sort.hpp"
+#include "../include/student_dictionary.hpp"
+#include "../include/simple_json.hpp"
+#include "test_common.hpp"
+
+static bool sameStat(const StudentStat& a, const StudentStat& b) {
+    return a.absences == b.absences && a.totalRecords == b.totalRecords
+        && std::abs(a.hoursPresent - b.hoursPresent) < 1e-9;
+}
+
+static bool sameStats(const std::map<std::string, StudentStat>& a, const std::map<std::string, StudentStat>& b) {
+    if (a.size() != b.size()) return false;
+    for (const auto& [name, stat] : a) {
+        auto found = b.find(name);
+        if (found == b.end() || !sameStat(stat, found->second)) return false;
+    }
+    return true;
+}
+
+struct TestEvent {
+    std::string student;
+    long long epoch;
+    EventType type;
+};
+
+// Несколько студентов, больше CHECKPOINT_EVERY событий у каждого
+static std::vector<TestEvent> makeEvents(size_t perStudent) {
+    std::mt19937 rng(42);
+    const char* names[] = { "Иванов", "Петров", "Сидоров" };
+    const EventType types[] = { EventType::IN, EventType::OUT, EventType::ABSENCE };
+    std::vector<TestEvent> events;
+    for (const char* name : names) {
+        long long t = 1759300000;
+        for (size_t i = 0; i < perStudent; ++i) {
+            t += 600 + static_cast<long long>(rng() % 7200);
+            events.push_back({ name, t, types[rng() % 3] });
+        }
+    }
+    return events;
+}
+
+static std::vector<AttendanceRecord> recordsOf(const std::vector<TestEvent>& events) {
+    std::vector<AttendanceRecord> recs;
+    for (const auto& e : events) {
+        recs.push_back({ e.student, AttendanceRecord::formatTimestamp(e.epoch), e.type, e.epoch });
+    }
+    return recs;
+}
+
+// Статистика менеджера через публичные запросы (кэш статистики)
+static std::map<std::string, StudentStat> managerStats(const AttendanceManager& manager) {
+    std::map<std::string, StudentStat> stats;
+    for (auto& [name, stat] : manager.topStudents(1000, RankKey::Records)) stats[name] = stat;
+    return stats;
+}
+
+static StatsEngine engineOf(const std::vector<TestEvent>& events) {
+    StatsEngine engine;
+    for (const auto& e : events) engine.add(e.student, e.epoch, e.type);
+    return engine;
+}
+
+void test_session_pairing() {
+    TEST_CASE("Sessions Paired In Time Order") {
+        // Записи в файле не по порядку: по времени это 08:00-10:30 и 12:00-13:15,
+        // то есть 3.75 часа (в порядке файла вышло бы 08:00-13:15, 5.25 часа)
+        std::string json = R"([
+            {"student": "Иванов", "ts": "2025-10-01T10:30:00Z", "type": "out"},
+            {"student": "Иванов", "ts": "2025-10-01T08:00:00Z", "type": "in"},
+            {"student": "Иванов", "ts": "2025-10-01T13:15:00Z", "type": "out"},
+            {"student": "Иванов", "ts": "2025-10-01T12:00:00Z", "type": "in"},
+            {"student": "Иванов", "ts": "2025-10-02T09:00:00Z", "type": "absence"}
+        ])";
+
+        AttendanceManager manager;
+        {
+            QuietStdout quiet;
+            manager.loadFromJson(json::Parser::parse(json));
+            manager.validateData();
+        }
+
+        auto top = manager.topStudents(10, RankKey::Absences);
+        CHECK(top.size() == 1);
+        CHECK(top[0].first == "Иванов");
+        CHECK(std::abs(top[0].second.hoursPresent - 3.75) < 1e-9);
+        CHECK(top[0].second.absences == 1);
+        CHECK(top[0].second.totalRecords == 5);
+
+        // --top K задаёт пользователь: огромное K не должно выделять память под K строк
+        CHECK(manager.topStudents(1000000000, RankKey::Hours).size() == 1);
+    } TEST_PASS
+}
+
+void test_late_events() {
+    TEST_CASE("StatsEngine Late Events") {
+        auto events = makeEvents(1000);
+        StatsEngine ordered = engineOf(events);
+
+        auto shuffled = events;
+        std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(7));
+        StatsEngine late = engineOf(shuffled);
+
+        CHECK(late.replayedEvents() > 0);
+        CHECK(late.eventCount() == events.size());
+        CHECK(sameStats(late.snapshot(), ordered.snapshot()));
+    } TEST_PASS
+}
+
+void test_engine_merge() {
+    TEST_CASE("StatsEngine Merge") {
+        auto events = makeEvents(1000);
+        StatsEngine full = engineOf(events);
+
+        // Чётные события в одном движке, нечётные — в другом: времена перекрываются
+        std::vector<TestEvent> even, odd;
+        for (size_t i = 0; i < events.size(); ++i) (i % 2 ? odd : even).push_back(events[i]);
+        StatsEngine merged = engineOf(even);
+        merged.merge(engineOf(odd));
+        CHECK(merged.eventCount() == events.size());
+        CHECK(sameStats(merged.snapshot(), full.snapshot()));
+
+        // Второй набор целиком позже первого: дописывание без пересчёта
+        size_t half = events.size() / 2;
+        std::vector<TestEvent> early, later;
+        for (const auto& e : events) (e.epoch < events[half].epoch ? early : later).push_back(e);
+        StatsEngine appended = engineOf(early);
+        appended.merge(engineOf(later));
+        CHECK(sameStats(appended.snapshot(), full.snapshot()));
+    } TEST_PASS
+}
+
+void test_append_invalidates_caches() {
+    TEST_CASE("Append Updates Cached Aggregates") {
+        auto events = makeEvents(400);
+        std::sort(events.begin(), events.end(),
+            [](const TestEvent& a, const TestEvent& b) { return a.epoch < b.epoch; });
+        size_t half = events.size() / 2;
+        std::vector<TestEvent> early(events.begin(), events.begin() + half);
+        std::vector<TestEvent> later(events.begin() + half, events.end());
+        // Два опоздавших события: пересчёт хвоста студента
+        std::swap(later[later.size() - 1], later[later.size() - 4]);
+        later.push_back({ "Козлов", events.back().epoch + 60, EventType::ABSENCE });
+
+        AttendanceManager manager;
+        {
+            QuietStdout quiet;
+            manager.loadRecords(recordsOf(early));
+        }
+        // Все кэши построены до дописывания
+        CHECK(managerStats(manager).size() == 3);
+        CHECK(manager.totalStats().totalRecords == static_cast<int>(half));
+        CHECK(manager.studentToJson("Козлов").asObject().at("count").asNumber() == 0);
+        CHECK(manager.rangeRecords(events.front().epoch, events.back().epoch + 60).size() == half);
+        CHECK(manager.columns().types.size() == half);
+
+        auto appended = recordsOf(later);
+        appended.push_back({ "Иванов", "not a timestamp", EventType::IN, 0 });
+        CHECK(manager.appendRecords(std::move(appended)) == later.size());
+
+        AttendanceManager fresh;
+        {
+            QuietStdout quiet;
+            auto all = recordsOf(early);
+            for (auto& rec : recordsOf(later)) all.push_back(std::move(rec));
+            fresh.loadRecords(std::move(all));
+        }
+        size_t total = events.size() + 1;
+        CHECK(manager.recordCount() == total);
+        CHECK(sameStats(managerStats(manager), managerStats(fresh)));
+        CHECK(managerStats(manager).size() == 4);
+        CHECK(manager.totalStats().totalRecords == static_cast<int>(total));
+        CHECK(manager.studentToJson("Козлов").asObject().at("count").asNumber() == 1);
+        CHECK(manager.rangeRecords(events.front().epoch, events.back().epoch + 60).size() == total);
+        CHECK(manager.columns().types.size() == total);
+
+        // Пустое дописывание не сбрасывает кэши и ничего не меняет
+        std::vector<AttendanceRecord> none;
+        CHECK(manager.appendRecords(std::move(none)) == 0);
+        CHECK(sameStats(managerStats(manager), managerStats(fresh)));
+    } TEST_PASS
+}
+
+void test_snapshot_round_trip() {
+    TEST_CASE("Stats Snapshot Round Trip") {
+        const std::string path = "data/test_stats_snapshot.bin";
+        auto events = makeEvents(600);
+        StatsEngine engine = engineOf(events);
+        engine.save(path);
+
+        StatsEngine loaded = StatsEngine::load(path);
+        CHECK(loaded.eventCount() == engine.eventCount());
+        CHECK(sameStats(loaded.snapshot(), engine.snapshot()));
+
+        // Снимок и загруженные записи (--stats-from) дают то же, что все события вместе
+        std::string json = R"([
+            {"student": "Иванов", "ts": "2030-01-01T08:00:00Z", "type": "in"},
+            {"student": "Иванов", "ts": "2030-01-01T11:00:00Z", "type": "out"},
+            {"student": "Козлов", "ts": "2030-01-01T09:00:00Z", "type": "absence"}
+        ])";
+        AttendanceManager manager;
+        {
+            QuietStdout quiet;
+            manager.loadFromJson(json::Parser::parse(json));
+            manager.validateData();
+        }
+        auto combined = manager.statsWithSnapshot(path);
+        std::filesystem::remove(path);
+
+        StatsEngine expected = engineOf(events);
+        expected.add("Иванов", AttendanceRecord::parseTimestamp(std::string("2030-01-01T08:00:00Z")), EventType::IN);
+        expected.add("Иванов", AttendanceRecord::parseTimestamp(std::string("2030-01-01T11:00:00Z")), EventType::OUT);
+        expected.add("Козлов", AttendanceRecord::parseTimestamp(std::string("2030-01-01T09:00:00Z")), EventType::ABSENCE);
+        CHECK(sameStats(combined, expected.snapshot()));
+        CHECK(combined.size() == 4);
+    } TEST_PASS
+}
+
+void test_snapshot_bloom() {
+    TEST_CASE("Snapshot Bloom Filter") {
+        // Словарь хранит string_view на свои строки — копирование запрещено
+        static_assert(!std::is_copy_constructible_v<StudentDictionary>);
+        static_assert(std::is_move_constructible_v<StudentDictionary>);
+
+        const std::string path = "data/test_stats_bloom.bin";
+        StatsEngine engine = engineOf(makeEvents(300));
+        engine.save(path);
+
+        BloomFilter bloom = StatsEngine::readBloom(path);
+        CHECK(!bloom.empty());
+        for (const char* name : { "Иванов", "Петров", "Сидоров" }) CHECK(bloom.mightContain(name));
+
+        // Ложные срабатывания редки (около 1%): из сотни чужих имён почти все отвергнуты
+        size_t falsePositives = 0;
+        for (int i = 0; i < 100; ++i) {
+            if (bloom.mightContain("Студент " + std::to_string(i))) falsePositives++;
+        }
+        CHECK(falsePositives < 10);
+
+        // --stats-from --student: отвергнутое фильтром имя не загружает снимок
+        AttendanceManager manager;
+        CHECK(manager.statsWithSnapshot(path, "Козлов").empty());
+        auto one = manager.statsWithSnapshot(path, "Петров");
+        CHECK(one.size() == 1);
+        CHECK(sameStat(one.at("Петров"), engine.snapshot().at("Петров")));
+        std::filesystem::remove(path);
+    } TEST_PASS
+}
+
+void test_engine_sealed_history() {
+    TEST_CASE("StatsEngine Sealed History") {
+        // Хвост ограничен: старые события свёрнуты в агрегат, итог тот же
+        auto events = makeEvents(3000);
+        StatsEngine engine = engineOf(events);
+        CHECK(engine.eventCount() == events.size());
+        CHECK(engine.retainedEvents() <= 3 * (StatsEngine::RETAINED_EVENTS + StatsEngine::CHECKPOINT_EVERY));
+
+        std::map<std::string, StudentStat> expected;
+        for (const auto& e : events) expected[e.student].absorb(e.epoch, e.type);
+        CHECK(sameStats(engine.snapshot(), expected));
+
+        // Опоздание в пределах хвоста пересчитывается, раньше свёрнутой части — нет
+        const long long lastIvanov = events[2999].epoch;
+        CHECK(engine.add("Иванов", lastIvanov - 60, EventType::ABSENCE) == StatsEngine::AddResult::Replayed);
+        CHECK(engine.add("Иванов", events[0].epoch, EventType::ABSENCE) == StatsEngine::AddResult::Stale);
+        CHECK(engine.eventCount() == events.size() + 1);
+
+        // Снимок хранит агрегат и хвост, а не весь журнал
+        const std::string path = "data/test_stats_sealed.bin";
+        engine.save(path);
+        CHECK(std::filesystem::file_size(path) < events.size() * 9);
+        StatsEngine loaded = StatsEngine::load(path);
+        std::filesystem::remove(path);
+        CHECK(loaded.eventCount() == engine.eventCount());
+        CHECK(sameStats(loaded.snapshot(), engine.snapshot()));
+
+        // Слияние, которому нужны свёрнутые события, отклоняется без изменений
+        StatsEngine early;
+        early.add("Иванов", events[0].epoch, EventType::IN);
+        bool rejected = false;
+        try { loaded.merge(std::move(early)); }
+        catch (const std::runtime_error&) { rejected = true; }
+        CHECK(rejected);
+        CHECK(sameStats(loaded.snapshot(), engine.snapshot()));
+
+        // Менеджер: опоздавшая запись раньше свёрнутой истории — полная перестройка
+        std::vector<AttendanceRecord> recs;
+        for (const auto& e : events) {
+            if (e.student == "Петров") recs.push_back({ e.student, AttendanceRecord::formatTimestamp(e.epoch), e.type, e.epoch });
+        }
+        AttendanceRecord stale = recs.front();
+        AttendanceManager manager;
+        {
+            QuietStdout quiet;
+            manager.loadRecords(std::move(recs));
+        }
+        CHECK(manager.topStudents(1, RankKey::Records)[0].second.totalRecords == 3000);
+
+        stale.type = EventType::ABSENCE;
+        std::vector<AttendanceRecord> late{ stale };
+        CHECK(manager.appendRecords(std::move(late)) == 1);
+        auto top = manager.topStudents(1, RankKey::Records);
+        CHECK(top[0].second.totalRecords == 3001);
+        CHECK(top[0].second.absences == expected.at("Петров").absences + 1);
+    } TEST_PASS
+}
+
+void test_snapshot_corrupted() {
+    TEST_CASE("Corrupted Stats Snapshot") {
+        const std::string path = "data/test_stats_corrupted.bin";
+        StatsEngine engine = engineOf(makeEvents(300));
+        engine.save(path);
+        auto size = std::filesystem::file_size(path);
+
+        auto rejected = [&path]() {
+            try { StatsEngine::load(path); }
+            catch (const std::runtime_error&) { return true; }
+            return false;
+        };
+
+        // Обрезанный файл
+        std::filesystem::resize_file(path, size - 5);
+        CHECK(rejected());
+
+        // Огромные счётчики не должны выделять память: длина имени и число событий
+        // первого студента сверяются с размером файла
+        engine.save(path);
+        BloomFilter bloom = StatsEngine::readBloom(path);
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekg(4 + 4 + 8);
+        BloomFilter::read(file);
+        auto first = file.tellg();
+
+        const uint32_t hugeName = 0xFFFFFFF0u;
+        file.seekp(first);
+        file.write(reinterpret_cast<const char*>(&hugeName), sizeof(hugeName));
+        file.flush();
+        CHECK(rejected());
+
+        engine.save(path);
+        file.close();
+        file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+        uint32_t nameLength = 0;
+        file.seekg(first);
+        file.read(reinterpret_cast<char*>(&nameLength), sizeof(nameLength));
+        const uint64_t hugeCount = 1ULL << 60;
+        file.seekp(static_cast<std::streamoff>(first) + 4 + nameLength + 5 * 8);
+        file.write(reinterpret_cast<const char*>(&hugeCount), sizeof(hugeCount));
+        file.close();
+        CHECK(rejected());
+
+        std::filesystem::remove(path);
+    } TEST_PASS
+}
+
+void test_external_cascade() {
+    TEST_CASE("External Sort Cascaded Merge") {
+        // Минимальный буфер (1024 записи): прогонов больше MERGE_FAN_IN,
+        // finish() сливает их каскадом, итог совпадает с подсчётом в памяти
+        auto events = makeEvents(30000);
+        std::shuffle(events.begin(), events.end(), std::mt19937(11));
+
+        ExternalStore store(0);
+        std::map<std::string, std::vector<std::pair<long long, EventType>>> byStudent;
+        for (const auto& e : events) {
+            store.add({ e.student, AttendanceRecord::formatTimestamp(e.epoch), e.type, e.epoch });
+            byStudent[e.student].emplace_back(e.epoch, e.type);
+        }
+        store.finish();
+        CHECK(store.spilledRunCount() > ExternalStore::MERGE_FAN_IN);
+        CHECK(store.runCount() <= ExternalStore::MERGE_FAN_IN);
+
+        std::map<std::string, StudentStat> expected;
+        for (auto& [name, rows] : byStudent) {
+            std::stable_sort(rows.begin(), rows.end(),
+                [](const auto& a, const auto& b) { return a.first < b.first; });
+            for (const auto& [epoch, type] : rows) expected[name].absorb(epoch, type);
+        }
+        CHECK(sameStats(store.aggregate(), expected));
+        CHECK(store.studentRecords("Петров").size() == 30000);
+    } TEST_PASS
+}
+
+void test_report_file_names() {
+    TEST_CASE("Report File Names Do Not Collide") {
+        // "A B" и "A_B", "A/B" и "A:B" после замены символов дают одно имя,
+        // "Smith" и "SMITH" совпадают в Windows; "Иванов" ни с кем не совпадает
+        const char* names[] = { "A B", "A_B", "A/B", "A:B", "Smith", "SMITH", "Иванов" };
+        std::vector<AttendanceRecord> recs;
+        for (const char* name : names) {
+            recs.push_back({ name, "2025-10-01T09:00:00Z", EventType::IN, 1759309200 });
+        }
+        AttendanceManager manager;
+        {
+            QuietStdout quiet;
+            manager.loadRecords(std::move(recs));
+        }
+
+        const std::string dir = "data/test_reports";
+        std::filesystem::remove_all(dir);
+        CHECK(manager.exportReports("test_reports", "txt") == 7);
+
+        std::set<std::string> files;
+        for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+            std::string file = entry.path().filename().string();
+            std::transform(file.begin(), file.end(), file.begin(),
+                [](char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c; });
+            files.insert(file);
+        }
+        std::filesystem::remove_all(dir);
+        CHECK(files.size() == 7);
+        CHECK(files.count("Иванов.txt") == 1);
+    } TEST_PASS
+}
+
+void runStatsTests() {
+    test_session_pairing();
+    test_late_events();
+    test_engine_merge();
+    test_append_invalidates_caches();
+    test_snapshot_round_trip();
+    test_snapshot_bloom();
+    test_engine_sealed_history();
+    test_snapshot_corrupted();
+    test_external_cascade();
+    test_report_file_names();
+}
\ No newline at end of file
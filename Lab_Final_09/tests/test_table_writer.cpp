@@ -0,0 +1,124 @@
+﻿#include <vector>
+#include <string>
+#include <sstream>
+#include <limits>
+#include <stdexcept>
+#include "../include/table_writer.hpp"
+#include "../include/simple_json.hpp"
+#include "test_common.hpp"
+
+// Строки, которые ломают наивный вывод: разделители, кавычки, переводы строк
+static const std::vector<std::string> TRICKY = {
+    "Иванов",
+    "Петров, Пётр",
+    "Сказал \"привет\"",
+    "две\nстроки",
+    "возврат\rкаретки",
+    "таб\tуляция",
+    "обратный \\ слеш",
+    std::string("управляющий \x01 символ"),
+    "",
+};
+
+static std::string render(TableWriter::Format format, size_t flushBytes = 1 << 16) {
+    std::ostringstream out;
+    TableWriter table(out, { { "Имя", 20 }, { "Число", 8 }, { "Часы", 8 } }, format, flushBytes);
+    table.header();
+    long long n = 0;
+    for (const auto& s : TRICKY) {
+        table.cell(s).cell(n - 3).cell(n * 1.25);
+        table.endRow();
+        n++;
+    }
+    table.finish();
+    return out.str();
+}
+
+void test_table_csv() {
+    TEST_CASE("TableWriter CSV Quoting") {
+        std::string expected =
+            "Имя,Число,Часы\n"
+            "Иванов,-3,0.00\n"
+            "\"Петров, Пётр\",-2,1.25\n"
+            "\"Сказал \"\"привет\"\"\",-1,2.50\n"
+            "\"две\nстроки\",0,3.75\n"
+            "\"возврат\rкаретки\",1,5.00\n"
+            "таб\tуляция,2,6.25\n"
+            "обратный \\ слеш,3,7.50\n"
+            "управляющий \x01 символ,4,8.75\n"
+            ",5,10.00\n";
+        CHECK(render(TableWriter::Format::Csv) == expected);
+
+        // В TSV разделители внутри значения заменяются пробелом
+        std::string tsv = render(TableWriter::Format::Tsv);
+        CHECK(tsv.find("две строки\t0\t3.75\n") != std::string::npos);
+        CHECK(tsv.find("возврат каретки\t1\t5.00\n") != std::string::npos);
+        CHECK(tsv.find("таб уляция\t2\t6.25\n") != std::string::npos);
+        CHECK(tsv.find("Петров, Пётр\t-2\t1.25\n") != std::string::npos);
+    } TEST_PASS
+}
+
+void test_table_json() {
+    TEST_CASE("TableWriter JSON Escaping") {
+        std::string text = render(TableWriter::Format::Json);
+        CHECK(text.back() == '\n');
+
+        // Вывод разбирается обратно в те же значения
+        json::Value root = json::Parser::parse(text);
+        const auto& rows = root.asArray();
+        CHECK(rows.size() == TRICKY.size());
+        for (size_t i = 0; i < rows.size(); ++i) {
+            const auto& row = rows[i].asObject();
+            CHECK(row.size() == 3);
+            CHECK(row.at("Имя").asString() == TRICKY[i]);
+            CHECK(row.at("Число").asNumber() == static_cast<double>(i) - 3);
+            CHECK(row.at("Часы").asNumber() == static_cast<double>(i) * 1.25);
+        }
+        CHECK(text.find("\\u0001") != std::string::npos);
+
+        // Пустая таблица — пустой массив, даже без header()
+        std::ostringstream empty;
+        {
+            TableWriter table(empty, { { "Имя", 20 } }, TableWriter::Format::Json);
+        }
+        CHECK(empty.str() == "[]\n");
+
+        // Нечисловые значения double не портят JSON
+        std::ostringstream special;
+        {
+            TableWriter table(special, { { "a", 8 }, { "b", 8 } }, TableWriter::Format::Json);
+            table.header();
+            table.cell(std::numeric_limits<double>::infinity())
+                .cell(std::numeric_limits<double>::quiet_NaN());
+            table.endRow();
+        }
+        json::Value parsed = json::Parser::parse(special.str());
+        const auto& row = parsed.asArray().at(0).asObject();
+        CHECK(row.at("a").asString() == "inf");
+        CHECK(row.at("b").asString() == "nan");
+    } TEST_PASS
+}
+
+void test_table_flush() {
+    TEST_CASE("TableWriter Flush Boundaries") {
+        // Маленький буфер сбрасывается посреди таблицы: вывод не меняется
+        const TableWriter::Format formats[] = {
+            TableWriter::Format::Text, TableWriter::Format::Csv,
+            TableWriter::Format::Tsv, TableWriter::Format::Json };
+        for (auto format : formats) {
+            CHECK(render(format, 1) == render(format));
+            CHECK(render(format, 17) == render(format));
+        }
+
+        // Text: ширина считается в символах UTF-8, а не в байтах
+        std::string text = render(TableWriter::Format::Text);
+        CHECK(text.rfind("Имя                 Число   Часы    \n", 0) == 0);
+        CHECK(text.find("\nИванов              -3      0.00    \n") != std::string::npos);
+    } TEST_PASS
+}
+
+void runTableWriterTests() {
+    test_table_csv();
+    test_table_json();
+    test_table_flush();
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+﻿#include <vector>
+#include <string>
+#include <atomic>
+#include <stdexcept>
+#include "../include/thread_pool.hpp"
+#include "test_common.hpp"
+
+// Пул по умолчанию берёт число ядер; на одном ядре всё выполнялось бы
+// в вызывающем потоке, поэтому тесты задают размер пула явно
+static const size_t POOL_THREADS = 4;
+
+void test_pool_coverage() {
+    TEST_CASE("ParallelFor Covers Range Once") {
+        ThreadPool::configure(POOL_THREADS);
+        auto& pool = ThreadPool::instance();
+        CHECK(pool.threadCount() == POOL_THREADS);
+
+        const size_t sizes[] = { 0, 1, 7, 100, 4096, 100003 };
+        for (size_t size : sizes) {
+            std::vector<std::atomic<int>> hits(size + 10);
+            std::atomic<size_t> shortChunks{ 0 };
+            pool.parallelFor(10, 10 + size, 64, [&](size_t lo, size_t hi) {
+                if (hi - lo < 64 && hi != 10 + size) shortChunks.fetch_add(1);
+                for (size_t i = lo; i < hi; ++i) hits[i].fetch_add(1);
+            });
+            for (size_t i = 0; i < 10; ++i) CHECK(hits[i].load() == 0);
+            for (size_t i = 10; i < 10 + size; ++i) CHECK(hits[i].load() == 1);
+            CHECK(shortChunks.load() == 0);
+        }
+    } TEST_PASS
+}
+
+void test_pool_exceptions() {
+    TEST_CASE("ParallelFor Propagates Exceptions") {
+        ThreadPool::configure(POOL_THREADS);
+        auto& pool = ThreadPool::instance();
+        const size_t total = 10000;
+
+        // Бросает первый кусок (в вызывающем потоке) и кусок из очереди
+        const size_t throwAt[] = { 0, total - 1 };
+        for (size_t bad : throwAt) {
+            std::atomic<size_t> done{ 0 };
+            bool caught = false;
+            try {
+                pool.parallelFor(0, total, 100, [&](size_t lo, size_t hi) {
+                    if (lo <= bad && bad < hi) throw std::runtime_error("chunk failed");
+                    done.fetch_add(hi - lo);
+                });
+            }
+            catch (const std::runtime_error& e) {
+                caught = std::string(e.what()) == "chunk failed";
+            }
+            CHECK(caught);
+            // Остальные куски дорабатывают до возврата: ссылки на стек вызова не висят
+            CHECK(done.load() > 0 && done.load() < total);
+        }
+
+        // После ошибки пул пригоден для работы
+        std::atomic<size_t> sum{ 0 };
+        pool.parallelFor(0, total, 100, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) sum.fetch_add(i);
+        });
+        CHECK(sum.load() == total * (total - 1) / 2);
+    } TEST_PASS
+}
+
+void test_pool_nested() {
+    TEST_CASE("Nested ParallelFor") {
+        ThreadPool::configure(POOL_THREADS);
+        auto& pool = ThreadPool::instance();
+
+        // Поток, ждущий внутренний вызов, не должен начать чужой внешний кусок:
+        // тот может захватить блокировку, которую держит ожидающий
+        static thread_local int outerDepth = 0;
+        std::atomic<size_t> reentered{ 0 };
+        std::atomic<size_t> sum{ 0 };
+        const size_t outer = 64, inner = 2000;
+
+        pool.parallelFor(0, outer, 1, [&](size_t lo, size_t hi) {
+            if (outerDepth++ > 0) reentered.fetch_add(1);
+            for (size_t o = lo; o < hi; ++o) {
+                pool.parallelFor(0, inner, 50, [&](size_t a, size_t b) {
+                    for (size_t i = a; i < b; ++i) sum.fetch_add(1);
+                });
+            }
+            outerDepth--;
+        });
+        CHECK(sum.load() == outer * inner);
+        CHECK(reentered.load() == 0);
+
+        // Исключение из внутреннего вызова проходит через внешний
+        bool caught = false;
+        try {
+            pool.parallelFor(0, outer, 1, [&](size_t lo, size_t) {
+                pool.parallelFor(0, inner, 50, [&](size_t a, size_t) {
+                    if (lo == outer / 2 && a == 0) throw std::logic_error("inner failed");
+                });
+            });
+        }
+        catch (const std::logic_error&) {
+            caught = true;
+        }
+        CHECK(caught);
+
+        ThreadPool::configure(0);
+    } TEST_PASS
+}
+
+void runThreadPoolTests() {
+    test_pool_coverage();
+    test_pool_exceptions();
+    test_pool_nested();
+}
\ No newline at end of file